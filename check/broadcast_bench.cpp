@@ -0,0 +1,106 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdlib.h>
+#include <new>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <timestamp.hpp>
+#include <client.hpp>
+
+using namespace JSR;
+using namespace std;
+using namespace Utils;
+
+// Number of broadcasts measured for every number of clients.
+#define BROADCASTS      20000
+#define PAYLOAD_SIZE    4096
+
+// Every allocation is counted, so copies of the payload can be seen.
+static size_t allocations = 0;
+
+void* operator new( size_t size ) {
+    allocations++;
+    void *memory = malloc( size ? size : 1 );
+    if( !memory ) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete( void *memory ) throw() {
+    free( memory );
+}
+
+// Sends commands to all the clients and takes them out of the queues,
+// just like the protocol thread does.
+static bool broadcast( ClientManager &manager, vector<Client*> &clients, const string &payload ) {
+    Command command( Command::BROADCAST, 1, payload );
+    manager.broadcast( command );
+    bool result = true;
+    Command out;
+    for( vector<Client*>::iterator it = clients.begin(); it != clients.end(); it++ ) {
+        if( !( *it )->getOutQueue().get( out ) || out.getValue().size() != payload.size() ) {
+            result = false;
+        }
+    }
+    return result;
+}
+
+static bool measure( int count ) {
+    ClientManager manager( count );
+    vector<Client*> clients;
+    for( int i = 0; i < count; i++ ) {
+        clients.push_back( new Client( i + 1 ) );
+        if( manager.addClient( clients.back() ) ) {
+            return false;
+        }
+    }
+    string payload( PAYLOAD_SIZE, 'x' );
+    bool result = true;
+    // Queues allocate their nodes lazily.
+    for( int i = 0; i < 100; i++ ) {
+        result &= broadcast( manager, clients, payload );
+    }
+    size_t allocated = allocations;
+    TimeStamp start;
+    for( int i = 0; i < BROADCASTS; i++ ) {
+        result &= broadcast( manager, clients, payload );
+    }
+    uint64_t elapsed = ( TimeStamp() - start ).getNanos();
+    cout << count << " clients: " << elapsed / BROADCASTS << " ns per broadcast, "
+         << static_cast<double>( allocations - allocated ) / BROADCASTS << " allocations per broadcast" << endl;
+    manager.stop();
+    return result;
+}
+
+int main( int argc, char **argv ) {
+
+    const int clients[] = { 1, 8, 64 };
+    for( size_t i = 0; i < sizeof( clients ) / sizeof( clients[0] ); i++ ) {
+        if( !measure( clients[i] ) ) {
+            cout << "Broadcast failed for " << clients[i] << " clients." << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <iostream>
+
+#include <compression.hpp>
+
+using namespace std;
+using namespace Utils;
+
+// Letters which can hardly be compressed.
+static string randomLetters( size_t size ) {
+    string result( size, ' ' );
+    uint32_t seed = 12345;
+    for( size_t i = 0; i < size; i++ ) {
+        seed = seed * 1103515245 + 12345;
+        result[i] = 'a' + ( seed >> 16 ) % 26;
+    }
+    return result;
+}
+
+// Compresses data as a single part of a new stream and inflates it.
+static bool roundTrip( const string &data, size_t maxSize, string &out ) {
+    Deflater deflater;
+    Inflater inflater;
+    string compressed;
+    if( !deflater.init() || !inflater.init() || !deflater.deflate( data.data(), data.size(), compressed ) ) {
+        return false;
+    }
+    out.clear();
+    return inflater.inflate( compressed.data(), compressed.size(), out, maxSize );
+}
+
+// Parts of the same stream share the dictionary, but every one of them
+// can be decompressed as soon as it arrives.
+static bool testStream() {
+    Deflater deflater;
+    Inflater inflater;
+    if( !deflater.init() || !inflater.init() ) {
+        return false;
+    }
+    for( int i = 0; i < 100; i++ ) {
+        string part = "{\"type\":\"info\",\"subtype\":\"paused\",\"line\":" + to_string( i ) + "}";
+        string compressed;
+        string out;
+        if( !deflater.deflate( part.data(), part.size(), compressed ) ||
+                !inflater.inflate( compressed.data(), compressed.size(), out, part.size() ) || out != part ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Data which fills the limit exactly is accepted, a byte more is not.
+static bool testLimit() {
+    const size_t sizes[] = { 1, 100, 16 * 1024, 64 * 1024, 200000 };
+    for( size_t i = 0; i < sizeof( sizes ) / sizeof( sizes[0] ); i++ ) {
+        string data = randomLetters( sizes[i] );
+        string out;
+        if( !roundTrip( data, sizes[i], out ) || out != data ) {
+            cout << "  " << sizes[i] << " bytes rejected with the same limit." << endl;
+            return false;
+        }
+        if( roundTrip( data, sizes[i] - 1, out ) ) {
+            cout << "  " << sizes[i] << " bytes accepted with a smaller limit." << endl;
+            return false;
+        }
+        // Well compressed data is inflated in a few rounds.
+        string zeros( sizes[i], '\0' );
+        if( !roundTrip( zeros, sizes[i], out ) || out != zeros || roundTrip( zeros, sizes[i] - 1, out ) ) {
+            cout << "  " << sizes[i] << " zeros handled incorrectly." << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Broken data is rejected.
+static bool testBroken() {
+    Inflater inflater;
+    string out;
+    return inflater.init() && !inflater.inflate( "\x01\x02\x03\x04", 4, out, 1024 );
+}
+
+int main( int argc, char **argv ) {
+
+    if( !Inflater::isSupported() ) {
+        cout << "Compression is not available, nothing to check." << endl;
+        return 0;
+    }
+
+    int failed = 0;
+
+    if( !testStream() ) {
+        cout << "Test failed: stream." << endl;
+        failed++;
+    }
+
+    if( !testLimit() ) {
+        cout << "Test failed: limit." << endl;
+        failed++;
+    }
+
+    if( !testBroken() ) {
+        cout << "Test failed: broken data." << endl;
+        failed++;
+    }
+
+    return failed ? 1 : 0;
+}
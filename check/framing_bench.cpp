@@ -0,0 +1,90 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include <string>
+#include <iostream>
+
+#include <framing.hpp>
+#include <timestamp.hpp>
+
+using namespace std;
+using namespace Utils;
+
+// Payload is scanned again and again until this many bytes are scanned.
+#define SCAN_TOTAL  ( 2048ULL * 1024 * 1024 )
+#define MB          ( 1024 * 1024 )
+
+typedef size_t (*ScanFunction)( const char *data, size_t size );
+
+// Byte by byte scanning, the way commands were checked before.
+static size_t scanBytes( const char *data, size_t size ) {
+    for( size_t i = 0; i < size; i++ ) {
+        if( data[i] == '\n' || data[i] == '\0' ) {
+            return i;
+        }
+    }
+    return size;
+}
+
+// Standard library can look for the new line only, so it's the upper limit.
+static size_t scanNewLine( const char *data, size_t size ) {
+    const void *found = memchr( data, '\n', size );
+    return found ? static_cast<const char*>( found ) - data : size;
+}
+
+static bool measure( const char *name, ScanFunction scan, const string &payload ) {
+    size_t rounds = static_cast<size_t>( SCAN_TOTAL / payload.size() );
+    size_t found = 0;
+    // Calls cannot be optimized out even though they look the same.
+    ScanFunction volatile function = scan;
+    TimeStamp start;
+    for( size_t i = 0; i < rounds; i++ ) {
+        found += function( payload.data(), payload.size() );
+    }
+    uint64_t elapsed = ( TimeStamp() - start ).getMicros();
+    cout << "  " << name << ": " << SCAN_TOTAL / ( elapsed ? elapsed : 1 ) << " MB/s" << endl;
+    // The separator is the last byte of the payload.
+    return found == rounds * ( payload.size() - 1 );
+}
+
+int main( int argc, char **argv ) {
+
+    const size_t sizes[] = { 4 * 1024, 64 * 1024, 1 * MB, 16 * MB };
+
+    for( size_t i = 0; i < sizeof( sizes ) / sizeof( sizes[0] ); i++ ) {
+        // Some JSON looking data followed by the separator.
+        string payload;
+        while( payload.size() < sizes[i] - 1 ) {
+            payload += "{\"type\":\"variable\",\"name\":\"value\",\"value\":[1,2,3]},";
+        }
+        payload.resize( sizes[i] - 1 );
+        payload += '\n';
+
+        cout << sizes[i] / 1024 << " kB payload:" << endl;
+        if( !measure( "bytes", scanBytes, payload ) ||
+                !measure( "memchr", scanNewLine, payload ) ||
+                !measure( "scanFrame", scanFrame, payload ) ) {
+            cout << "Separator not found." << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
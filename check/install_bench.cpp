@@ -0,0 +1,194 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdio.h>
+#include <locale.h>
+#include <string>
+#include <vector>
+#include <iostream>
+
+// SpiderMonkey.
+#include <jsapi.h>
+
+// JSRDBG.
+#include <jsrdbg.h>
+#include <jsldbg.h>
+
+#include <timestamp.hpp>
+
+using namespace JSR;
+using namespace std;
+using namespace Utils;
+
+// Number of commands sent to the debugger in the round trip test.
+#define ROUND_TRIPS     10000
+
+// Counts responses of the debugger.
+class RoundTripDebugger : public JSLocalDebugger {
+public:
+    RoundTripDebugger( JSContext *ctx, JSDbgEngineOptions &options )
+        : JSLocalDebugger( ctx, options ),
+          _responses(0) {
+    }
+    bool handlePause( bool suspended ) {
+        return false;
+    }
+    bool handleCommand( const std::string &command ) {
+        _responses++;
+        return true;
+    }
+    int getResponses() const {
+        return _responses;
+    }
+private:
+    int _responses;
+};
+
+// Installs the debugger into the given number of contexts and measures
+// every single installation. Shared scripts are compiled once per process,
+// so only the very first installation pays for them.
+static bool measure( JSRuntime *rt, JSDbgEngineOptions &options, int count, bool &first ) {
+    JSRemoteDebugger dbg;
+    vector<JSContext*> contexts;
+    uint64_t total = 0;
+    uint64_t compiled = 0;
+    bool result = true;
+    for( int i = 0; i < count; i++ ) {
+        JSContext *cx = JS_NewContext( rt, 8192 );
+        if( !cx ) {
+            result = false;
+            break;
+        }
+        contexts.push_back( cx );
+        char name[32];
+        snprintf( name, sizeof( name ), "bench-%d", i );
+        TimeStamp start;
+        if( dbg.install( cx, name, options ) != JSR_ERROR_NO_ERROR ) {
+            result = false;
+            break;
+        }
+        uint64_t elapsed = ( TimeStamp() - start ).getMicros();
+        if( first ) {
+            // Not a part of the average.
+            compiled = elapsed;
+            first = false;
+        } else {
+            total += elapsed;
+        }
+    }
+    for( vector<JSContext*>::iterator it = contexts.begin(); it != contexts.end(); it++ ) {
+        dbg.uninstall( *it );
+        JS_DestroyContext( *it );
+    }
+    if( result ) {
+        cout << count << " contexts: " << ( total + compiled ) / 1000 << " ms in total";
+        if( compiled ) {
+            cout << ", first install " << compiled << " us";
+        }
+        int installs = compiled ? count - 1 : count;
+        if( installs ) {
+            cout << ", " << total / installs << " us per install";
+        }
+        cout << "." << endl;
+    }
+    return result;
+}
+
+// Sends commands which are handled by the debugger scripts without pausing
+// the debuggee, so the time is spent in the compiled scripts mostly.
+static bool measureRoundTrip( JSRuntime *rt, JSDbgEngineOptions &options ) {
+    JSContext *cx = JS_NewContext( rt, 8192 );
+    if( !cx ) {
+        return false;
+    }
+    bool result;
+    {
+        RoundTripDebugger dbg( cx, options );
+        result = dbg.install() == JSR_ERROR_NO_ERROR;
+        if( result ) {
+            const string command = "{\"type\":\"command\",\"name\":\"get_breakpoints\",\"id\":1}";
+            DebuggerStateHint hint;
+            TimeStamp start;
+            for( int i = 0; i < ROUND_TRIPS && result; i++ ) {
+                result = dbg.sendCommand( command, hint );
+            }
+            uint64_t elapsed = ( TimeStamp() - start ).getMicros();
+            result = result && dbg.getResponses() == ROUND_TRIPS;
+            if( result ) {
+                cout << "Command round trip: " << elapsed * 1000 / ROUND_TRIPS << " ns." << endl;
+            }
+            dbg.uninstall();
+        }
+    }
+    JS_DestroyContext( cx );
+    return result;
+}
+
+// Both installations and commands are measured with scripts compiled
+// for every context and then with shared ones.
+static bool measureMode( JSRuntime *rt, JSDbgEngineOptions &options ) {
+    bool first = true;
+    const int contexts[] = { 1, 10, 100 };
+    for( size_t i = 0; i < sizeof( contexts ) / sizeof( contexts[0] ); i++ ) {
+        if( !measure( rt, options, contexts[i], first ) ) {
+            cout << "Cannot install debugger into " << contexts[i] << " contexts." << endl;
+            return false;
+        }
+    }
+    if( !measureRoundTrip( rt, options ) ) {
+        cout << "Cannot send commands to the debugger." << endl;
+        return false;
+    }
+    return true;
+}
+
+int main( int argc, char **argv ) {
+
+    setlocale( LC_ALL, "" );
+
+    JSRuntime *rt = JS_NewRuntime( 64L * 1024 * 1024, JS_NO_HELPER_THREADS );
+    if( !rt ) {
+        cout << "Cannot initialize runtime." << endl;
+        return 1;
+    }
+
+    JS_SetNativeStackQuota( rt, 1024 * 1024 );
+    JS_SetGCParameter( rt, JSGC_MAX_BYTES, 0xffffffff );
+
+    int result = 0;
+
+    JSDbgEngineOptions compiled;
+    JSDbgEngineOptions shared;
+    shared.shareCompiledScripts();
+
+    cout << "Scripts compiled for every context:" << endl;
+    if( measureMode( rt, compiled ) ) {
+        cout << "Shared scripts:" << endl;
+        if( !measureMode( rt, shared ) ) {
+            result = 1;
+        }
+    } else {
+        result = 1;
+    }
+
+    JS_DestroyRuntime( rt );
+    JS_ShutDown();
+
+    return result;
+}
@@ -0,0 +1,186 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdlib.h>
+#include <poll.h>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <timestamp.hpp>
+#include <framing.hpp>
+
+// Client of the jrdb.
+#include <tcp_client.hpp>
+
+#include "tcp_harness.hpp"
+
+using namespace JSR;
+using namespace std;
+using namespace Utils;
+
+// Read buffer of the server, frames of this size need many reads.
+#define SERVER_BUFFER       ( 64 * 1024 )
+// Maximum time of a single round trip, in milliseconds.
+#define ROUND_TRIP_TIMEOUT  5000
+
+// Collects commands received by the client.
+class CommandCollector : public IEventHandler {
+public:
+    CommandCollector()
+        : _disconnected(false) {
+    }
+    void handle( IEvent *event ) {
+        DebuggerCommandEvent *command = dynamic_cast<DebuggerCommandEvent*>( event );
+        if( command ) {
+            _commands.push_back( command->str() );
+            _contexts.push_back( command->hasContextId() ? command->getContextId() : -1 );
+        } else if( dynamic_cast<ClientDisconnectedEvent*>( event ) ) {
+            _disconnected = true;
+        }
+        delete event;
+    }
+    const vector<string>& getCommands() const {
+        return _commands;
+    }
+    const vector<int>& getContexts() const {
+        return _contexts;
+    }
+    bool isDisconnected() const {
+        return _disconnected;
+    }
+private:
+    vector<string> _commands;
+    vector<int> _contexts;
+    bool _disconnected;
+};
+
+// Letters mixed with the bytes the text protocol cannot carry.
+static string binaryPayload( size_t size ) {
+    string result( size, ' ' );
+    uint32_t seed = 12345;
+    for( size_t i = 0; i < size; i++ ) {
+        seed = seed * 1103515245 + 12345;
+        result[i] = i % 7 ? 'a' + ( seed >> 16 ) % 26 : ( i % 2 ? '\n' : '\0' );
+    }
+    return result;
+}
+
+// Does the job of the jrdb's event loop until the expected number
+// of commands is received.
+static bool exchange( ::TCPClient &client, CommandCollector &collector, size_t expected ) {
+    TimeStamp start;
+    while( collector.getCommands().size() < expected ) {
+        if( ( TimeStamp() - start ).getMicros() > ROUND_TRIP_TIMEOUT * 1000 || collector.isDisconnected() ) {
+            return false;
+        }
+        struct pollfd fd;
+        fd.fd = client.getConsumerFD();
+        fd.events = client.isReady() ? POLLIN | POLLOUT : POLLIN;
+        fd.revents = 0;
+        if( ::poll( &fd, 1, 100 ) < 0 ) {
+            continue;
+        }
+        if( ( fd.revents & POLLOUT ) ) {
+            int error = client.write();
+            if( error && error != JDB_ERROR_WOULD_BLOCK ) {
+                return false;
+            }
+        }
+        if( fd.revents & ( POLLIN | POLLHUP ) ) {
+            int error = client.read();
+            if( error && error != JDB_ERROR_WOULD_BLOCK ) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Commands sent by the jrdb come back from the server untouched. Responses
+// bigger than a single read of the client are put together from many reads.
+static bool testRoundTrip( int port, bool binary, bool compress ) {
+    JSRemoteDebuggerCfg cfg;
+    cfg.setTcpPort( port );
+    cfg.setTcpBufferSize( SERVER_BUFFER );
+    TestServer server( cfg );
+    if( server.start() ) {
+        cout << "Cannot start the server on port " << port << "." << endl;
+        return false;
+    }
+    ::TCPClient *client;
+    if( ::TCPClient::Connect( "127.0.0.1", port, &client ) ) {
+        return false;
+    }
+    CommandCollector collector;
+    client->setEventHandler( &collector );
+    vector<string> payloads;
+    if( binary ) {
+        client->requestBinaryFraming( compress );
+        payloads.push_back( binaryPayload( 100 ) );
+        payloads.push_back( binaryPayload( SERVER_BUFFER - JSR_FRAME_HEADER_SIZE ) );
+    } else {
+        payloads.push_back( "{\"type\":\"command\",\"name\":\"get_call_stack\",\"id\":1}" );
+        payloads.push_back( string( SERVER_BUFFER - 64, 'a' ) );
+    }
+    payloads.push_back( "{}" );
+    for( size_t i = 0; i < payloads.size(); i++ ) {
+        client->sendCommand( DebuggerCommand( static_cast<int>( i ) + 1, payloads[i] ) );
+    }
+    bool result = exchange( *client, collector, payloads.size() );
+    if( result ) {
+        for( size_t i = 0; i < payloads.size(); i++ ) {
+            // Context ID is a part of the line in the text protocol.
+            int contextId = static_cast<int>( i ) + 1;
+            string expected = binary ? payloads[i] : to_string( contextId ) + "/" + payloads[i];
+            if( collector.getCommands()[i] != expected || collector.getContexts()[i] != ( binary ? contextId : -1 ) ) {
+                cout << "  Command " << i << " broken." << endl;
+                result = false;
+            }
+        }
+    }
+    client->setEventHandler( nullptr );
+    client->disconnect( 0 );
+    delete client;
+    return result;
+}
+
+int main( int argc, char **argv ) {
+
+    int port = argc > 1 ? atoi( argv[1] ) : JSR_CHECK_TCP_PORT;
+
+    int failed = 0;
+
+    if( !testRoundTrip( port, false, false ) ) {
+        cout << "Test failed: text protocol." << endl;
+        failed++;
+    }
+
+    if( !testRoundTrip( port, true, false ) ) {
+        cout << "Test failed: binary framing." << endl;
+        failed++;
+    }
+
+    if( !testRoundTrip( port, true, true ) ) {
+        cout << "Test failed: compressed binary framing." << endl;
+        failed++;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string>
+#include <iostream>
+
+#include <json_reader.hpp>
+#include <timestamp.hpp>
+
+using namespace std;
+using namespace Utils;
+
+// Number of times every command is read.
+#define READ_ROUNDS     200000
+#define KB              1024
+
+// Commands the way the clients send them.
+static const char *COMMANDS[] = {
+    "{\"type\":\"command\",\"name\":\"get_call_stack\",\"id\":1}",
+    "{\"type\":\"command\",\"name\":\"get_variables\",\"id\":\"a7\",\"query\":{\"stackElement\":0,\"path\":\"this\"}}",
+    "{\"type\":\"command\",\"name\":\"set_breakpoint\",\"id\":12,\"url\":\"file:\\/\\/\\/src\\/main.js\",\"line\":120,\"pending\":true}",
+    "{\"type\":\"command\",\"name\":\"evaluate\",\"id\":13,\"source\":\"a + b \\u2260 c\",\"stackElement\":1}"
+};
+
+static bool measure( const string &command, int rounds ) {
+    JSONReader reader;
+    JSONValue root;
+    bool result = true;
+    TimeStamp start;
+    for( int i = 0; i < rounds; i++ ) {
+        if( !reader.parse( command, root ) || !root.isObject() ) {
+            result = false;
+        }
+    }
+    uint64_t elapsed = ( TimeStamp() - start ).getNanos();
+    cout << "  " << command.size() << " bytes: " << elapsed / rounds << " ns per command, "
+         << static_cast<uint64_t>( command.size() ) * rounds * 1000 / ( elapsed ? elapsed : 1 ) << " MB/s" << endl;
+    return result;
+}
+
+int main( int argc, char **argv ) {
+
+    cout << "Typical commands:" << endl;
+    for( size_t i = 0; i < sizeof( COMMANDS ) / sizeof( COMMANDS[0] ); i++ ) {
+        if( !measure( COMMANDS[i], READ_ROUNDS ) ) {
+            cout << "Command rejected." << endl;
+            return 1;
+        }
+    }
+
+    // Evaluated source is the only part of the command which can be big.
+    cout << "Big sources:" << endl;
+    const size_t sizes[] = { 4 * KB, 64 * KB, 1024 * KB };
+    for( size_t i = 0; i < sizeof( sizes ) / sizeof( sizes[0] ); i++ ) {
+        string source;
+        while( source.size() < sizes[i] ) {
+            source += "var \\u00e9l\\u00e9ment = \\\"value\\\" + f(1, 2);\\n";
+        }
+        string command = "{\"type\":\"command\",\"name\":\"evaluate\",\"id\":1,\"source\":\"" + source + "\"}";
+        if( !measure( command, static_cast<int>( READ_ROUNDS * 64 / command.size() ) + 1 ) ) {
+            cout << "Command rejected." << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,456 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <iostream>
+
+#include <json_reader.hpp>
+
+using namespace std;
+using namespace Utils;
+
+// Number of random documents read by the round trip test.
+#define RANDOM_DOCUMENTS    20000
+#define RANDOM_MAX_DEPTH    5
+
+// Nesting limit of the reader.
+#define MAX_DEPTH           256
+
+struct ReaderCase {
+    const char *document;
+    size_t size;
+    bool accepted;
+};
+
+#define CASE( document, accepted ) { document, sizeof( document ) - 1, accepted }
+
+// Every document is judged the same way JSON.parse judges it, except the
+// ones which are not valid UTF-8.
+static const ReaderCase READER_CASES[] = {
+    CASE( "{}", true ),
+    CASE( "[]", true ),
+    CASE( " \t\r\n{ \"a\" : [ 1 , 2 ] } \n", true ),
+    CASE( "0", true ),
+    CASE( "-0", true ),
+    CASE( "-1.5e+10", true ),
+    CASE( "1E-2", true ),
+    CASE( "\"\"", true ),
+    CASE( "true", true ),
+    CASE( "false", true ),
+    CASE( "null", true ),
+    CASE( "\"\\\"\\\\\\/\\b\\f\\n\\r\\t\\u0041\"", true ),
+    CASE( "\"\\ud800\"", true ),
+    CASE( "\"\\udc00\\ud800\"", true ),
+    CASE( "\"\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\"", true ),
+    CASE( "\"\xEF\xBF\xBF\xF4\x8F\xBF\xBF\"", true ),
+    CASE( "", false ),
+    CASE( "   ", false ),
+    CASE( "01", false ),
+    CASE( "1.", false ),
+    CASE( ".5", false ),
+    CASE( "+1", false ),
+    CASE( "-", false ),
+    CASE( "1e", false ),
+    CASE( "0x10", false ),
+    CASE( "NaN", false ),
+    CASE( "Infinity", false ),
+    CASE( "tru", false ),
+    CASE( "nul", false ),
+    CASE( "True", false ),
+    CASE( "1 2", false ),
+    CASE( "[1 2]", false ),
+    CASE( "[1,]", false ),
+    CASE( "[,1]", false ),
+    CASE( "{\"a\":1,}", false ),
+    CASE( "{\"a\" 1}", false ),
+    CASE( "{'a':1}", false ),
+    CASE( "{a:1}", false ),
+    CASE( "{1:1}", false ),
+    CASE( "[1", false ),
+    CASE( "{\"a\":", false ),
+    CASE( "\"abc", false ),
+    CASE( "\"\\x\"", false ),
+    CASE( "\"\\u12\"", false ),
+    CASE( "\"\\u12G4\"", false ),
+    CASE( "\"tab\there\"", false ),
+    CASE( "\"new\nline\"", false ),
+    CASE( "\"nul\0byte\"", false ),
+    CASE( "\xEF\xBB\xBF{}", false ),
+    CASE( "{}\0", false ),
+    // Overlong forms.
+    CASE( "\"\xC0\xAF\"", false ),
+    CASE( "\"\xC1\xBF\"", false ),
+    CASE( "\"\xE0\x80\xAF\"", false ),
+    CASE( "\"\xF0\x80\x80\xAF\"", false ),
+    // Surrogates and code points above U+10FFFF.
+    CASE( "\"\xED\xA0\x80\"", false ),
+    CASE( "\"\xED\xBF\xBF\"", false ),
+    CASE( "\"\xF4\x90\x80\x80\"", false ),
+    CASE( "\"\xF5\x80\x80\x80\"", false ),
+    // Stray and truncated sequences.
+    CASE( "\"\x80\"", false ),
+    CASE( "\"\xBF\"", false ),
+    CASE( "\"\xFF\"", false ),
+    CASE( "\"\xC3\"", false ),
+    CASE( "\"\xE2\x82\"", false ),
+    CASE( "\"\xF0\x9F\x98\"", false ),
+    CASE( "\"\xE2\x82", false )
+};
+
+static bool testReaderCases() {
+    bool result = true;
+    JSONReader reader;
+    for( size_t i = 0; i < sizeof( READER_CASES ) / sizeof( READER_CASES[0] ); i++ ) {
+        const ReaderCase &test = READER_CASES[i];
+        JSONValue root;
+        if( reader.parse( test.document, test.size, root ) != test.accepted ) {
+            cout << "Document " << i << " should be " << ( test.accepted ? "accepted" : "rejected" ) << "." << endl;
+            result = false;
+        }
+    }
+    return result;
+}
+
+static bool readString( const char *document, const string &expected ) {
+    JSONReader reader;
+    JSONValue root;
+    return reader.parse( document, root ) && root.isString() && root.getString() == expected;
+}
+
+// Escapes are decoded to UTF-8. Unpaired surrogates cannot be encoded,
+// so they are replaced the same way the transcoder replaces them.
+static bool testEscapes() {
+    return readString( "\"\\u0041\\u00e9\\u20AC\"", "A\xC3\xA9\xE2\x82\xAC" ) &&
+           readString( "\"\\ud83d\\ude00\"", "\xF0\x9F\x98\x80" ) &&
+           readString( "\"\\ud800\"", "\xEF\xBF\xBD" ) &&
+           readString( "\"\\ud800\\u0041\"", "\xEF\xBF\xBD" "A" ) &&
+           readString( "\"\\udc00\\ud800\"", "\xEF\xBF\xBD\xEF\xBF\xBD" ) &&
+           readString( "\"\\u0000\"", string( 1, '\0' ) );
+}
+
+// Members are found the same way JSON.parse finds them and every value
+// knows where it comes from, so raw tokens can be echoed back.
+static bool testMembers() {
+    const string document = "{\"id\":  12.50 ,\"type\":\"a\",\"type\":\"command\",\"\\u0069d2\":[1,{}]}";
+    JSONReader reader;
+    JSONValue root;
+    if( !reader.parse( document, root ) || !root.isObject() || root.size() != 4 ) {
+        return false;
+    }
+    const JSONValue *id = root.find( "id" );
+    const JSONValue *type = root.find( "type" );
+    const JSONValue *id2 = root.find( "id2" );
+    return id && document.substr( id->getOffset(), id->getLength() ) == "12.50" && id->getNumber() == 12.5 &&
+           type && type->getString() == "command" &&
+           id2 && id2->getType() == JSONValue::TYPE_ARRAY && id2->size() == 2 &&
+           document.substr( id2->getOffset(), id2->getLength() ) == "[1,{}]" &&
+           !root.find( "name" );
+}
+
+static bool testDepth() {
+    JSONReader reader;
+    JSONValue root;
+    string nested = string( MAX_DEPTH, '[' ) + string( MAX_DEPTH, ']' );
+    string tooDeep = string( MAX_DEPTH + 1, '[' ) + string( MAX_DEPTH + 1, ']' );
+    return reader.parse( nested, root ) && !reader.parse( tooDeep, root ) && reader.getError();
+}
+
+// Generates random documents in two forms: the noisy one, full of spaces
+// and escapes, and the canonical one, which is what the reader should
+// understand out of the noisy one.
+class DocumentGenerator {
+public:
+    DocumentGenerator()
+        : _seed(12345) {
+    }
+    void generate( string &noisy, string &canonical ) {
+        noisy.clear();
+        canonical.clear();
+        // Only containers, so no prefix of the document is valid.
+        if( next( 2 ) ) {
+            generateObject( noisy, canonical, 0 );
+        } else {
+            generateArray( noisy, canonical, 0 );
+        }
+    }
+private:
+    uint32_t next( uint32_t range ) {
+        _seed = _seed * 1103515245 + 12345;
+        return ( _seed >> 8 ) % range;
+    }
+    void space( string &noisy ) {
+        static const char SPACES[] = { ' ', '\t', '\n', '\r' };
+        while( next( 4 ) == 0 ) {
+            noisy += SPACES[next( 4 )];
+        }
+    }
+    void generateValue( string &noisy, string &canonical, int depth ) {
+        switch( next( depth < RANDOM_MAX_DEPTH ? 6 : 4 ) ) {
+        case 0:
+            generateString( noisy, canonical );
+            break;
+        case 1:
+            generateNumber( noisy, canonical );
+            break;
+        case 2: {
+            static const char *LITERALS[] = { "true", "false", "null" };
+            const char *literal = LITERALS[next( 3 )];
+            noisy += literal;
+            canonical += literal;
+            break;
+        }
+        case 3:
+            generateString( noisy, canonical );
+            break;
+        case 4:
+            generateObject( noisy, canonical, depth + 1 );
+            break;
+        default:
+            generateArray( noisy, canonical, depth + 1 );
+            break;
+        }
+    }
+    void generateObject( string &noisy, string &canonical, int depth ) {
+        noisy += '{';
+        canonical += '{';
+        int members = next( 5 );
+        for( int i = 0; i < members; i++ ) {
+            if( i ) {
+                noisy += ',';
+                canonical += ',';
+            }
+            space( noisy );
+            generateString( noisy, canonical );
+            space( noisy );
+            noisy += ':';
+            canonical += ':';
+            space( noisy );
+            generateValue( noisy, canonical, depth );
+            space( noisy );
+        }
+        space( noisy );
+        noisy += '}';
+        canonical += '}';
+    }
+    void generateArray( string &noisy, string &canonical, int depth ) {
+        noisy += '[';
+        canonical += '[';
+        int elements = next( 5 );
+        for( int i = 0; i < elements; i++ ) {
+            if( i ) {
+                noisy += ',';
+                canonical += ',';
+            }
+            space( noisy );
+            generateValue( noisy, canonical, depth );
+            space( noisy );
+        }
+        space( noisy );
+        noisy += ']';
+        canonical += ']';
+    }
+    void generateNumber( string &noisy, string &canonical ) {
+        static const char *NUMBERS[] = { "0", "-0", "7", "-42", "3.25", "1e10", "-2.5E-3", "12345678901234567890" };
+        const char *number = NUMBERS[next( sizeof( NUMBERS ) / sizeof( NUMBERS[0] ) )];
+        noisy += number;
+        canonical += number;
+    }
+    void generateString( string &noisy, string &canonical ) {
+        static const uint32_t CHARACTERS[] = { 'a', 'Z', '0', ' ', '"', '\\', '/', '\n', '\t', 0x01, 0x1F,
+                0x7F, 0xE9, 0x7FF, 0x800, 0x20AC, 0xFFFD, 0xFFFF, 0x10000, 0x1F600, 0x10FFFF };
+        noisy += '"';
+        canonical += '"';
+        int length = next( 8 );
+        for( int i = 0; i < length; i++ ) {
+            uint32_t code = CHARACTERS[next( sizeof( CHARACTERS ) / sizeof( CHARACTERS[0] ) )];
+            appendNoisy( noisy, code );
+            appendCanonical( canonical, code );
+        }
+        noisy += '"';
+        canonical += '"';
+    }
+    void appendNoisy( string &noisy, uint32_t code ) {
+        bool mustEscape = code < 0x20 || code == '"' || code == '\\';
+        if( !mustEscape && next( 2 ) ) {
+            appendUTF8( noisy, code );
+            return;
+        }
+        char escape[16];
+        if( code >= 0x10000 ) {
+            uint32_t high = 0xD800 + ( ( code - 0x10000 ) >> 10 );
+            uint32_t low = 0xDC00 + ( ( code - 0x10000 ) & 0x3FF );
+            snprintf( escape, sizeof( escape ), next( 2 ) ? "\\u%04x\\u%04x" : "\\u%04X\\u%04X", high, low );
+        } else if( code == '\n' && next( 2 ) ) {
+            snprintf( escape, sizeof( escape ), "\\n" );
+        } else if( ( code == '"' || code == '\\' || code == '/' ) && next( 2 ) ) {
+            snprintf( escape, sizeof( escape ), "\\%c", static_cast<char>( code ) );
+        } else {
+            snprintf( escape, sizeof( escape ), next( 2 ) ? "\\u%04x" : "\\u%04X", code );
+        }
+        noisy += escape;
+    }
+public:
+    static void appendCanonical( string &canonical, uint32_t code ) {
+        if( code < 0x20 ) {
+            char escape[8];
+            snprintf( escape, sizeof( escape ), "\\u%04x", code );
+            canonical += escape;
+        } else if( code == '"' || code == '\\' ) {
+            canonical += '\\';
+            canonical += static_cast<char>( code );
+        } else {
+            appendUTF8( canonical, code );
+        }
+    }
+    static void appendUTF8( string &dest, uint32_t code ) {
+        if( code < 0x80 ) {
+            dest += static_cast<char>( code );
+        } else if( code < 0x800 ) {
+            dest += static_cast<char>( 0xC0 | ( code >> 6 ) );
+            dest += static_cast<char>( 0x80 | ( code & 0x3F ) );
+        } else if( code < 0x10000 ) {
+            dest += static_cast<char>( 0xE0 | ( code >> 12 ) );
+            dest += static_cast<char>( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+            dest += static_cast<char>( 0x80 | ( code & 0x3F ) );
+        } else {
+            dest += static_cast<char>( 0xF0 | ( code >> 18 ) );
+            dest += static_cast<char>( 0x80 | ( ( code >> 12 ) & 0x3F ) );
+            dest += static_cast<char>( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+            dest += static_cast<char>( 0x80 | ( code & 0x3F ) );
+        }
+    }
+private:
+    uint32_t _seed;
+};
+
+static void dumpString( string &out, const string &value ) {
+    out += '"';
+    for( size_t i = 0; i < value.size(); i++ ) {
+        unsigned char c = static_cast<unsigned char>( value[i] );
+        if( c < 0x20 || c == '"' || c == '\\' ) {
+            DocumentGenerator::appendCanonical( out, c );
+        } else {
+            out += static_cast<char>( c );
+        }
+    }
+    out += '"';
+}
+
+// Writes the value in the canonical form of the generator.
+static void dump( string &out, const JSONValue &value ) {
+    switch( value.getType() ) {
+    case JSONValue::TYPE_NULL:
+        out += "null";
+        break;
+    case JSONValue::TYPE_BOOLEAN:
+        out += value.getBoolean() ? "true" : "false";
+        break;
+    case JSONValue::TYPE_NUMBER:
+        out += value.getString();
+        break;
+    case JSONValue::TYPE_STRING:
+        dumpString( out, value.getString() );
+        break;
+    case JSONValue::TYPE_ARRAY:
+        out += '[';
+        for( size_t i = 0; i < value.size(); i++ ) {
+            if( i ) {
+                out += ',';
+            }
+            dump( out, value.get( i ) );
+        }
+        out += ']';
+        break;
+    case JSONValue::TYPE_OBJECT:
+        out += '{';
+        for( size_t i = 0; i < value.size(); i++ ) {
+            if( i ) {
+                out += ',';
+            }
+            dumpString( out, value.getName( i ) );
+            out += ':';
+            dump( out, value.get( i ) );
+        }
+        out += '}';
+        break;
+    }
+}
+
+// Random documents have to be read exactly the way they were generated
+// and none of their prefixes can be accepted.
+static bool testRandomDocuments() {
+    DocumentGenerator generator;
+    JSONReader reader;
+    string noisy, canonical, dumped;
+    for( int i = 0; i < RANDOM_DOCUMENTS; i++ ) {
+        generator.generate( noisy, canonical );
+        JSONValue root;
+        if( !reader.parse( noisy, root ) ) {
+            cout << "Rejected: " << noisy << " (" << reader.getError() << ")" << endl;
+            return false;
+        }
+        dumped.clear();
+        dump( dumped, root );
+        if( dumped != canonical ) {
+            cout << "Misread: " << noisy << endl;
+            return false;
+        }
+        for( size_t size = 0; size < noisy.size(); size++ ) {
+            if( reader.parse( noisy.data(), size, root ) ) {
+                cout << "Prefix accepted: " << noisy.substr( 0, size ) << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main( int argc, char **argv ) {
+
+    int failed = 0;
+
+    if( !testReaderCases() ) {
+        cout << "Test failed: reader cases." << endl;
+        failed++;
+    }
+
+    if( !testEscapes() ) {
+        cout << "Test failed: escapes." << endl;
+        failed++;
+    }
+
+    if( !testMembers() ) {
+        cout << "Test failed: members." << endl;
+        failed++;
+    }
+
+    if( !testDepth() ) {
+        cout << "Test failed: depth." << endl;
+        failed++;
+    }
+
+    if( !testRandomDocuments() ) {
+        cout << "Test failed: random documents." << endl;
+        failed++;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <threads.hpp>
+#include <timestamp.hpp>
+
+#include "tcp_harness.hpp"
+
+using namespace JSR;
+using namespace std;
+using namespace Utils;
+
+// Requests sent by each client and the biggest number of clients.
+#define LOAD_REQUESTS       500
+#define LOAD_MAX_CLIENTS    64
+
+// Many clients talk to the server at once. Latency of every single client
+// should stay flat as more clients are added.
+static bool measure( int port, int count ) {
+    JSRemoteDebuggerCfg cfg;
+    cfg.setTcpPort( port );
+    cfg.setMaxClients( count );
+    TestServer server( cfg );
+    if( server.start() ) {
+        cout << "Cannot start the server on port " << port << "." << endl;
+        return false;
+    }
+
+    vector<PingClient*> clients;
+    vector<Thread*> threads;
+    for( int i = 0; i < count; i++ ) {
+        clients.push_back( new PingClient( port, i, LOAD_REQUESTS ) );
+        threads.push_back( new Thread( *clients.back() ) );
+    }
+
+    TimeStamp start;
+    for( int i = 0; i < count; i++ ) {
+        threads[i]->start();
+    }
+    for( int i = 0; i < count; i++ ) {
+        threads[i]->join();
+    }
+    uint64_t elapsed = ( TimeStamp() - start ).getMicros();
+
+    bool result = true;
+    vector<uint64_t> latencies;
+    for( int i = 0; i < count; i++ ) {
+        if( clients[i]->isFailed() ) {
+            result = false;
+        }
+        latencies.insert( latencies.end(), clients[i]->getLatencies().begin(), clients[i]->getLatencies().end() );
+        delete threads[i];
+        delete clients[i];
+    }
+
+    server.stop();
+
+    uint64_t p50 = percentile( latencies, 0.5 );
+    uint64_t p99 = percentile( latencies, 0.99 );
+    cout << count << " clients, " << latencies.size() << " requests in " << elapsed / 1000 << " ms, "
+         << "p50 " << p50 << " us, p99 " << p99 << " us." << endl;
+
+    return result && latencies.size() == static_cast<size_t>( count * LOAD_REQUESTS );
+}
+
+int main( int argc, char **argv ) {
+
+    int port = argc > 1 ? atoi( argv[1] ) : JSR_CHECK_TCP_PORT;
+
+    for( int clients = 1; clients <= LOAD_MAX_CLIENTS; clients *= 8 ) {
+        if( !measure( port, clients ) ) {
+            cout << "Load of " << clients << " clients failed." << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
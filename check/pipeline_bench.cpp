@@ -0,0 +1,96 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <iostream>
+
+#include <timestamp.hpp>
+
+#include "tcp_harness.hpp"
+
+using namespace JSR;
+using namespace std;
+using namespace Utils;
+
+// Number of commands sent for every batch size.
+#define PIPELINE_COMMANDS   100000
+
+// Sends commands in batches written at once and waits for all the answers
+// before the next batch is sent.
+static bool runBatches( TestConnection &connection, int batchSize, uint64_t &elapsed ) {
+    string batch;
+    char command[128];
+    for( int i = 0; i < batchSize; i++ ) {
+        if( i % 2 ) {
+            snprintf( command, sizeof( command ), "0/{\"type\":\"get_variables\",\"id\":%d,\"path\":\"this\"}\n", i );
+        } else {
+            snprintf( command, sizeof( command ), "0/{\"type\":\"evaluate\",\"id\":%d,\"path\":\"a + b\"}\n", i );
+        }
+        batch += command;
+    }
+    string response;
+    TimeStamp start;
+    for( int sent = 0; sent < PIPELINE_COMMANDS; sent += batchSize ) {
+        if( !connection.send( batch ) ) {
+            return false;
+        }
+        for( int i = 0; i < batchSize; i++ ) {
+            if( !connection.readLine( response ) ) {
+                return false;
+            }
+        }
+    }
+    elapsed = ( TimeStamp() - start ).getMicros();
+    return true;
+}
+
+int main( int argc, char **argv ) {
+
+    int port = argc > 1 ? atoi( argv[1] ) : JSR_CHECK_TCP_PORT;
+
+    JSRemoteDebuggerCfg cfg;
+    cfg.setTcpPort( port );
+
+    TestServer server( cfg );
+    if( server.start() ) {
+        cout << "Cannot start the server on port " << port << "." << endl;
+        return 1;
+    }
+
+    TestConnection connection;
+    if( !connection.connect( port ) ) {
+        cout << "Cannot connect to the server." << endl;
+        return 1;
+    }
+
+    const int batches[] = { 1, 20, 200 };
+    for( size_t i = 0; i < sizeof( batches ) / sizeof( batches[0] ); i++ ) {
+        uint64_t elapsed;
+        if( !runBatches( connection, batches[i], elapsed ) ) {
+            cout << "Batches of " << batches[i] << " commands failed." << endl;
+            return 1;
+        }
+        cout << "Batches of " << batches[i] << " commands: " << PIPELINE_COMMANDS * 1000000ULL / ( elapsed ? elapsed : 1 )
+             << " commands/s." << endl;
+    }
+
+    return 0;
+}
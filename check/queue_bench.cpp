@@ -0,0 +1,161 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <sched.h>
+#include <string>
+#include <iostream>
+
+#include <threads.hpp>
+#include <timestamp.hpp>
+#include <client.hpp>
+
+using namespace JSR;
+using namespace std;
+using namespace Utils;
+
+// Number of commands passed through the queues in every test.
+#define QUEUE_COMMANDS  1000000
+#define PING_PONGS      100000
+
+// Both queues are used the way the clients use them: producer never
+// drops anything and consumer blocks while there is nothing to take.
+class BlockingAdapter {
+public:
+    BlockingAdapter()
+        : _queue(MAX_CLIENT_QUEUE_LENGTH) {
+    }
+    void put( Command &&command ) {
+        _queue.push( std::move( command ) );
+    }
+    Command take() {
+        return _queue.pop();
+    }
+private:
+    BlockingQueue<Command> _queue;
+};
+
+class SPSCAdapter {
+public:
+    SPSCAdapter()
+        : _queue(MAX_CLIENT_QUEUE_LENGTH) {
+    }
+    void put( Command &&command ) {
+        while( !_queue.add( std::move( command ) ) ) {
+            sched_yield();
+        }
+    }
+    Command take() {
+        return _queue.pop();
+    }
+private:
+    SPSCQueue<Command> _queue;
+};
+
+// Fills the queue as fast as possible.
+template<typename Queue>
+class Producer : public Runnable {
+public:
+    explicit Producer( Queue &queue )
+        : _queue(queue) {
+    }
+    void run() {
+        for( int i = 0; i < QUEUE_COMMANDS; i++ ) {
+            _queue.put( Command( 1, i, "{\"type\":\"info\",\"subtype\":\"paused\"}" ) );
+        }
+    }
+private:
+    Queue &_queue;
+};
+
+// Answers every command, like the JS engine answering the protocol thread.
+template<typename Queue>
+class Responder : public Runnable {
+public:
+    Responder( Queue &requests, Queue &responses )
+        : _requests(requests),
+          _responses(responses) {
+    }
+    void run() {
+        for( int i = 0; i < PING_PONGS; i++ ) {
+            _responses.put( _requests.take() );
+        }
+    }
+private:
+    Queue &_requests;
+    Queue &_responses;
+};
+
+template<typename Queue>
+static bool measureThroughput( const char *name ) {
+    Queue queue;
+    Producer<Queue> producer( queue );
+    Thread thread( producer );
+    TimeStamp start;
+    thread.start();
+    bool result = true;
+    for( int i = 0; i < QUEUE_COMMANDS; i++ ) {
+        if( queue.take().getContextId() != i ) {
+            result = false;
+        }
+    }
+    thread.join();
+    uint64_t elapsed = ( TimeStamp() - start ).getMicros();
+    cout << "  " << name << ": " << QUEUE_COMMANDS * 1000ULL / ( elapsed ? elapsed : 1 ) << " commands/ms" << endl;
+    return result;
+}
+
+template<typename Queue>
+static bool measurePingPong( const char *name ) {
+    Queue requests;
+    Queue responses;
+    Responder<Queue> responder( requests, responses );
+    Thread thread( responder );
+    thread.start();
+    bool result = true;
+    TimeStamp start;
+    for( int i = 0; i < PING_PONGS; i++ ) {
+        requests.put( Command( 1, i, "{\"type\":\"get_variables\"}" ) );
+        if( responses.take().getContextId() != i ) {
+            result = false;
+        }
+    }
+    uint64_t elapsed = ( TimeStamp() - start ).getNanos();
+    thread.join();
+    cout << "  " << name << ": " << elapsed / PING_PONGS << " ns per round trip" << endl;
+    return result;
+}
+
+int main( int argc, char **argv ) {
+
+    cout << "Throughput:" << endl;
+    if( !measureThroughput<BlockingAdapter>( "BlockingQueue" ) ||
+            !measureThroughput<SPSCAdapter>( "SPSCQueue" ) ) {
+        cout << "Commands reordered." << endl;
+        return 1;
+    }
+
+    cout << "Ping-pong:" << endl;
+    if( !measurePingPong<BlockingAdapter>( "BlockingQueue" ) ||
+            !measurePingPong<SPSCAdapter>( "SPSCQueue" ) ) {
+        cout << "Commands reordered." << endl;
+        return 1;
+    }
+
+    return 0;
+}
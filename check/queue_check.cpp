@@ -0,0 +1,248 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <sched.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <iostream>
+
+#include <threads.hpp>
+#include <timestamp.hpp>
+
+using namespace std;
+using namespace Utils;
+
+// Number of elements passed between the threads.
+#define QUEUE_ELEMENTS      1000000
+// Small capacity, so the ring buffer wraps around all the time.
+#define QUEUE_CAPACITY      8
+// Number of times the consumer is put to sleep and woken up.
+#define WAKE_UPS            200
+// Time after which the consumer is considered lost, in milliseconds.
+#define WAKE_UP_TIMEOUT     5000
+
+// Takes elements using the blocking pop and checks their order.
+class OrderedConsumer : public Runnable {
+public:
+    explicit OrderedConsumer( SPSCQueue<int> &queue )
+        : _queue(queue),
+          _failed(false) {
+    }
+    void run() {
+        for( int i = 0; i < QUEUE_ELEMENTS; i++ ) {
+            if( _queue.pop() != i ) {
+                _failed = true;
+                return;
+            }
+        }
+    }
+    bool isFailed() const {
+        return _failed;
+    }
+private:
+    SPSCQueue<int> &_queue;
+    bool _failed;
+};
+
+// Waits for single elements until the queue is interrupted.
+class WaitingConsumer : public Runnable {
+public:
+    explicit WaitingConsumer( SPSCQueue<int> &queue )
+        : _queue(queue),
+          _received(0),
+          _interrupted(false) {
+    }
+    void run() {
+        try {
+            while( true ) {
+                _queue.pop();
+                _received++;
+            }
+        } catch( InterruptionException &exc ) {
+            _interrupted = true;
+        }
+    }
+    int getReceived() const {
+        return _received.load();
+    }
+    bool isInterrupted() const {
+        return _interrupted.load();
+    }
+private:
+    SPSCQueue<int> &_queue;
+    std::atomic<int> _received;
+    std::atomic<bool> _interrupted;
+};
+
+// Waits for the consumer, a lost wake-up never ends otherwise.
+template<typename Predicate>
+static bool waitFor( Predicate predicate ) {
+    TimeStamp start;
+    while( !predicate() ) {
+        if( ( TimeStamp() - start ).getMicros() > WAKE_UP_TIMEOUT * 1000 ) {
+            return false;
+        }
+        sched_yield();
+    }
+    return true;
+}
+
+// Full queue refuses new elements and leaves them untouched.
+static bool testFull() {
+    SPSCQueue<string> queue( QUEUE_CAPACITY - 1 );
+    for( int i = 0; i < QUEUE_CAPACITY; i++ ) {
+        if( !queue.add( to_string( i ) ) ) {
+            return false;
+        }
+    }
+    string element = "rejected";
+    if( !queue.isFull() || queue.add( std::move( element ) ) || element != "rejected" ) {
+        return false;
+    }
+    // Room for exactly one element.
+    string first;
+    if( !queue.get( first ) || first != "0" || !queue.add( std::move( element ) ) || queue.add( string( "x" ) ) ) {
+        return false;
+    }
+    return queue.getCount() == QUEUE_CAPACITY;
+}
+
+// Elements keep their order while the positions wrap around the buffer.
+static bool testWrapAround() {
+    SPSCQueue<int> queue( QUEUE_CAPACITY );
+    int next = 0;
+    int expected = 0;
+    for( int round = 0; round < 1000; round++ ) {
+        int count = round % QUEUE_CAPACITY + 1;
+        for( int i = 0; i < count; i++ ) {
+            if( !queue.add( next++ ) ) {
+                return false;
+            }
+        }
+        int element;
+        for( int i = 0; i < count; i++ ) {
+            if( !queue.get( element ) || element != expected++ ) {
+                return false;
+            }
+        }
+        if( queue.get( element ) || !queue.isEmpty() ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Producer and consumer threads, the consumer sleeps whenever the
+// queue is empty and the producer spins whenever it's full.
+static bool testThreads() {
+    SPSCQueue<int> queue( QUEUE_CAPACITY );
+    OrderedConsumer consumer( queue );
+    Thread thread( consumer );
+    thread.start();
+    for( int i = 0; i < QUEUE_ELEMENTS; i++ ) {
+        while( !queue.add( i ) ) {
+            if( !waitFor( [&queue]() { return !queue.isFull(); } ) ) {
+                // The thread cannot be joined.
+                cout << "Consumer has stopped taking elements." << endl;
+                _exit( 1 );
+            }
+        }
+    }
+    thread.join();
+    return !consumer.isFailed() && queue.isEmpty();
+}
+
+// Consumer which is already sleeping is woken up by every new element,
+// also if it arrives just as the consumer is going to sleep.
+static bool testWakeUp() {
+    SPSCQueue<int> queue( QUEUE_CAPACITY );
+    WaitingConsumer consumer( queue );
+    Thread thread( consumer );
+    thread.start();
+    bool result = true;
+    for( int i = 0; i < WAKE_UPS && result; i++ ) {
+        if( i % 2 ) {
+            // Let it fall asleep.
+            usleep( 1000 );
+        }
+        queue.add( i );
+        result = waitFor( [&consumer, i]() { return consumer.getReceived() == i + 1; } );
+    }
+    queue.interrupt();
+    if( !waitFor( [&consumer]() { return consumer.isInterrupted(); } ) ) {
+        // The thread cannot be joined.
+        cout << "Consumer has not been interrupted." << endl;
+        _exit( 1 );
+    }
+    thread.join();
+    return result;
+}
+
+// Sleeping consumer is interrupted.
+static bool testInterrupt() {
+    for( int i = 0; i < WAKE_UPS; i++ ) {
+        SPSCQueue<int> queue( QUEUE_CAPACITY );
+        WaitingConsumer consumer( queue );
+        Thread thread( consumer );
+        thread.start();
+        if( i % 2 ) {
+            usleep( 1000 );
+        }
+        queue.interrupt();
+        if( !waitFor( [&consumer]() { return consumer.isInterrupted(); } ) ) {
+            cout << "Consumer has not been interrupted." << endl;
+            _exit( 1 );
+        }
+        thread.join();
+    }
+    return true;
+}
+
+int main( int argc, char **argv ) {
+
+    int failed = 0;
+
+    if( !testFull() ) {
+        cout << "Test failed: full queue." << endl;
+        failed++;
+    }
+
+    if( !testWrapAround() ) {
+        cout << "Test failed: wrap around." << endl;
+        failed++;
+    }
+
+    if( !testThreads() ) {
+        cout << "Test failed: producer and consumer threads." << endl;
+        failed++;
+    }
+
+    if( !testWakeUp() ) {
+        cout << "Test failed: waking up the consumer." << endl;
+        failed++;
+    }
+
+    if( !testInterrupt() ) {
+        cout << "Test failed: interrupting the consumer." << endl;
+        failed++;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <iostream>
+
+#include <timestamp.hpp>
+
+#include "tcp_harness.hpp"
+
+using namespace JSR;
+using namespace std;
+using namespace Utils;
+
+// Every response is streamed a few times and the best time is taken.
+#define STREAM_ROUNDS   3
+#define MB              ( 1024 * 1024 )
+
+// Answers "stream:<size>" with a response of the given size, just like
+// big get_source or evaluate responses.
+static void streamResponder( ClientManager &manager, Command &command ) {
+    size_t size = strtoul( command.getValue().c_str() + strlen( "stream:" ), nullptr, 10 );
+    Command response( command.getClientId(), command.getContextId(), string( size, 'x' ) );
+    manager.sendCommand( std::move( response ) );
+}
+
+static bool streamResponse( TestConnection &connection, size_t size, uint64_t &elapsed ) {
+    char request[64];
+    snprintf( request, sizeof( request ), "0/stream:%lu\n", static_cast<unsigned long>( size ) );
+    string response;
+    TimeStamp start;
+    if( !connection.send( request ) || !connection.readLine( response ) ) {
+        return false;
+    }
+    elapsed = ( TimeStamp() - start ).getMicros();
+    // Context ID prefix comes first.
+    return response.size() == size + 2;
+}
+
+int main( int argc, char **argv ) {
+
+    int port = argc > 1 ? atoi( argv[1] ) : JSR_CHECK_TCP_PORT;
+
+    JSRemoteDebuggerCfg cfg;
+    cfg.setTcpPort( port );
+    // The biggest response has to fit into the buffer.
+    cfg.setTcpBufferSize( 64 * MB );
+
+    TestServer server( cfg, streamResponder );
+    if( server.start() ) {
+        cout << "Cannot start the server on port " << port << "." << endl;
+        return 1;
+    }
+
+    TestConnection connection;
+    if( !connection.connect( port ) ) {
+        cout << "Cannot connect to the server." << endl;
+        return 1;
+    }
+
+    const size_t sizes[] = { 10 * MB, 25 * MB, 50 * MB };
+    for( size_t i = 0; i < sizeof( sizes ) / sizeof( sizes[0] ); i++ ) {
+        uint64_t best = 0;
+        for( int round = 0; round < STREAM_ROUNDS; round++ ) {
+            uint64_t elapsed;
+            if( !streamResponse( connection, sizes[i], elapsed ) ) {
+                cout << "Streaming " << sizes[i] / MB << " MB failed." << endl;
+                return 1;
+            }
+            if( round == 0 || elapsed < best ) {
+                best = elapsed;
+            }
+        }
+        cout << sizes[i] / MB << " MB response: " << best / 1000 << " ms, "
+             << sizes[i] / ( best ? best : 1 ) << " MB/s." << endl;
+    }
+
+    return 0;
+}
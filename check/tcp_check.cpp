@@ -0,0 +1,708 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <threads.hpp>
+#include <framing.hpp>
+#include <compression.hpp>
+
+#include <unix_protocol.hpp>
+
+#include "tcp_harness.hpp"
+
+using namespace JSR;
+using namespace std;
+using namespace Utils;
+
+// Many clients test: number of clients and requests sent by each of them.
+#define MANY_CLIENTS        16
+#define MANY_REQUESTS       100
+
+// Read buffer of the server used by the compression test.
+#define COMPRESSION_BUFFER  ( 64 * 1024 )
+
+// Number of clients and rounds used by the clients table test.
+#define SLOT_CLIENTS        8
+#define SLOT_ROUNDS         20000
+
+// Client which reports when it's deleted.
+class TrackedClient : public Client {
+public:
+    TrackedClient( int id, std::atomic<int> &deleted )
+        : Client(id),
+          _deleted(deleted),
+          _alive(true) {
+    }
+    ~TrackedClient() {
+        _alive = false;
+        _deleted++;
+    }
+    bool isAlive() const {
+        return _alive;
+    }
+private:
+    std::atomic<int> &_deleted;
+    volatile bool _alive;
+};
+
+// Gets and returns clients while they are being replaced.
+class ClientReader : public Runnable {
+public:
+    ClientReader( ClientManager &manager, std::atomic<bool> &stop )
+        : _manager(manager),
+          _stop(stop),
+          _failed(false) {
+    }
+    void run() {
+        while( !_stop.load() ) {
+            for( int id = 1; id <= SLOT_CLIENTS; id++ ) {
+                ClientPtrHolder<TrackedClient> client( _manager, id );
+                if( client ) {
+                    if( client->getID() != id || !client->isAlive() ) {
+                        _failed = true;
+                    }
+                }
+            }
+        }
+    }
+    bool isFailed() const {
+        return _failed;
+    }
+private:
+    ClientManager &_manager;
+    std::atomic<bool> &_stop;
+    bool _failed;
+};
+
+// Letters which can hardly be compressed.
+static string randomLetters( size_t size ) {
+    string result( size, ' ' );
+    uint32_t seed = 12345;
+    for( size_t i = 0; i < size; i++ ) {
+        seed = seed * 1103515245 + 12345;
+        result[i] = 'a' + ( seed >> 16 ) % 26;
+    }
+    return result;
+}
+
+// Answers "size:<n>" with a response of the given size.
+static void sizeResponder( ClientManager &manager, Command &command ) {
+    const string &value = command.getValue();
+    if( value.compare( 0, 5, "size:" ) == 0 ) {
+        size_t size = strtoul( value.c_str() + 5, nullptr, 10 );
+        manager.sendCommand( Command( command.getClientId(), command.getContextId(), randomLetters( size ) ) );
+    } else {
+        manager.sendCommand( std::move( command ) );
+    }
+}
+
+// Letters mixed with the bytes the text protocol cannot carry.
+static string binaryPayload( size_t size ) {
+    string result = randomLetters( size );
+    for( size_t i = 0; i < size; i += 7 ) {
+        result[i] = i % 2 ? '\n' : '\0';
+    }
+    return result;
+}
+
+static string encodeFrame( const string &payload, int contextId = 0, uint32_t flags = 0 ) {
+    FrameHeader header;
+    header.length = static_cast<uint32_t>( payload.size() );
+    header.contextId = contextId;
+    header.flags = flags;
+    char buffer[JSR_FRAME_HEADER_SIZE];
+    encodeFrameHeader( header, buffer );
+    return string( buffer, JSR_FRAME_HEADER_SIZE ) + payload;
+}
+
+static bool sendFrame( TestConnection &connection, const string &payload, int contextId = 0 ) {
+    return connection.send( encodeFrame( payload, contextId ) );
+}
+
+// Grants credit using the line or the frame, depending on the framing.
+static bool sendCredit( TestConnection &connection, bool binary, uint32_t credit ) {
+    if( binary ) {
+        uint8_t buffer[sizeof( uint32_t )];
+        encodeFrameUInt32( credit, buffer );
+        return connection.send( encodeFrame( string( reinterpret_cast<char*>( buffer ), sizeof( buffer ) ), 0, JSR_FRAME_FLAG_CREDIT ) );
+    }
+    char line[32];
+    snprintf( line, sizeof( line ), JSR_FRAME_PROTOCOL_CREDIT "%u\n", credit );
+    return connection.send( line );
+}
+
+static bool readFrame( TestConnection &connection, Inflater &inflater, string &payload, FrameHeader &header ) {
+    char buffer[JSR_FRAME_HEADER_SIZE];
+    if( !connection.read( buffer, JSR_FRAME_HEADER_SIZE ) ) {
+        return false;
+    }
+    decodeFrameHeader( buffer, header );
+    string data( header.length, '\0' );
+    if( header.length && !connection.read( &data[0], header.length ) ) {
+        return false;
+    }
+    payload.clear();
+    if( header.flags & JSR_FRAME_FLAG_DEFLATE ) {
+        return inflater.inflate( data.data(), data.size(), payload, COMPRESSION_BUFFER );
+    }
+    payload.swap( data );
+    return true;
+}
+
+static bool readFrame( TestConnection &connection, Inflater &inflater, string &payload ) {
+    FrameHeader header;
+    return readFrame( connection, inflater, payload, header );
+}
+
+// Switches the connection to the binary framing.
+static bool negotiate( TestConnection &connection, int port, const char *protocol, string &confirmed ) {
+    return connection.connect( port ) && connection.send( string( protocol ) + "\n" ) && connection.readLine( confirmed );
+}
+
+// Frames come back from the server untouched, however the network splits
+// them. Frames which cannot fit into the buffer close the connection.
+static bool testBinaryFraming( int port, bool compress ) {
+    JSRemoteDebuggerCfg cfg;
+    cfg.setTcpPort( port );
+    cfg.setTcpBufferSize( COMPRESSION_BUFFER );
+    TestServer server( cfg );
+    if( server.start() ) {
+        cout << "Cannot start the server on port " << port << "." << endl;
+        return false;
+    }
+    const char *protocol = compress ? JSR_FRAME_PROTOCOL_BINARY_DEFLATE : JSR_FRAME_PROTOCOL_BINARY;
+    TestConnection connection;
+    Inflater inflater;
+    string line;
+    if( !negotiate( connection, port, protocol, line ) || !inflater.init() ) {
+        return false;
+    }
+    if( line != protocol ) {
+        // Compression is not available, plain frames are used.
+        if( !compress || line != JSR_FRAME_PROTOCOL_BINARY ) {
+            return false;
+        }
+        compress = false;
+    }
+
+    bool result = true;
+    FrameHeader header;
+    string payload;
+    string small = binaryPayload( 100 );
+    if( !sendFrame( connection, small, 7 ) || !readFrame( connection, inflater, payload, header ) ||
+            payload != small || header.contextId != 7 || header.flags != 0 ||
+            header.length != small.size() ) {
+        cout << "  Small frame broken." << endl;
+        result = false;
+    }
+
+    // Split in the middle of the header and the payload.
+    string frame = encodeFrame( small, 8 );
+    const size_t cuts[] = { 0, 5, JSR_FRAME_HEADER_SIZE, JSR_FRAME_HEADER_SIZE + 50, frame.size() };
+    for( size_t i = 0; i + 1 < sizeof( cuts ) / sizeof( cuts[0] ); i++ ) {
+        if( !connection.send( frame.substr( cuts[i], cuts[i + 1] - cuts[i] ) ) ) {
+            return false;
+        }
+        usleep( 20000 );
+    }
+    if( !readFrame( connection, inflater, payload, header ) || payload != small || header.contextId != 8 ) {
+        cout << "  Split frame broken." << endl;
+        result = false;
+    }
+
+    // Frame which fills the whole buffer needs many reads.
+    string big = binaryPayload( COMPRESSION_BUFFER - JSR_FRAME_HEADER_SIZE );
+    if( !sendFrame( connection, big, 9 ) || !readFrame( connection, inflater, payload, header ) ||
+            payload != big || header.contextId != 9 ||
+            ( header.flags == JSR_FRAME_FLAG_DEFLATE ) != compress ) {
+        cout << "  Big frame broken." << endl;
+        result = false;
+    }
+
+    // Just one byte more than the buffer can hold.
+    if( !sendFrame( connection, big + "x", 10 ) || !connection.waitForData( 5000 ) ||
+            readFrame( connection, inflater, payload, header ) ) {
+        cout << "  Oversized frame accepted." << endl;
+        result = false;
+    }
+    return result;
+}
+
+// Once the first credit is granted, the server sends commands only as long
+// as there is some credit left, the rest waits for the next grant.
+static bool testCredit( int port, bool binary ) {
+    JSRemoteDebuggerCfg cfg;
+    cfg.setTcpPort( port );
+    TestServer server( cfg );
+    if( server.start() ) {
+        cout << "Cannot start the server on port " << port << "." << endl;
+        return false;
+    }
+    TestConnection connection;
+    Inflater inflater;
+    string line;
+    if( binary ) {
+        if( !negotiate( connection, port, JSR_FRAME_PROTOCOL_BINARY, line ) || line != JSR_FRAME_PROTOCOL_BINARY ) {
+            return false;
+        }
+    } else if( !connection.connect( port ) ) {
+        return false;
+    }
+    // The first command exceeds the credit, but it's sent anyway.
+    string first;
+    string second;
+    bool sent = binary ?
+            sendCredit( connection, binary, 1 ) && sendFrame( connection, "first" ) && sendFrame( connection, "second" ) :
+            sendCredit( connection, binary, 1 ) && connection.send( "0/first\n0/second\n" );
+    if( !sent || !( binary ? readFrame( connection, inflater, first ) : connection.readLine( first ) ) ) {
+        return false;
+    }
+    bool result = first == ( binary ? "first" : "0/first" );
+    if( connection.waitForData( 200 ) ) {
+        cout << "  Command sent without credit." << endl;
+        result = false;
+    }
+    if( !sendCredit( connection, binary, 100 ) ||
+            !( binary ? readFrame( connection, inflater, second ) : connection.readLine( second ) ) ) {
+        return false;
+    }
+    return result && second == ( binary ? "second" : "0/second" );
+}
+
+// Command which is too big to be sent cannot break the deflate stream.
+static bool testCompressedOversized( int port ) {
+    JSRemoteDebuggerCfg cfg;
+    cfg.setTcpPort( port );
+    cfg.setTcpBufferSize( COMPRESSION_BUFFER );
+    TestServer server( cfg, sizeResponder );
+    if( server.start() ) {
+        cout << "Cannot start the server on port " << port << "." << endl;
+        return false;
+    }
+    TestConnection connection;
+    Inflater inflater;
+    string line;
+    if( !connection.connect( port ) || !connection.send( JSR_FRAME_PROTOCOL_BINARY_DEFLATE "\n" ) ||
+            !connection.readLine( line ) || !inflater.init() ) {
+        return false;
+    }
+    if( line != JSR_FRAME_PROTOCOL_BINARY_DEFLATE ) {
+        // Compression is not available, nothing to check.
+        return line == JSR_FRAME_PROTOCOL_BINARY;
+    }
+    // The first response is dropped, the second one has to be readable.
+    string payload;
+    if( !sendFrame( connection, "size:200000" ) || !sendFrame( connection, "size:5000" ) ||
+            !readFrame( connection, inflater, payload ) ) {
+        return false;
+    }
+    return payload == randomLetters( 5000 );
+}
+
+// Socket of a running debuggee cannot be taken over, but the one
+// left by a debuggee which hasn't been stopped correctly can.
+static bool testUnixSocketInUse() {
+    char path[64];
+    snprintf( path, sizeof( path ), "/tmp/jsrdbg_check_%d.sock", static_cast<int>( getpid() ) );
+    JSRemoteDebuggerCfg cfg;
+    cfg.setUnixSocketPath( path );
+
+    bool result = true;
+    {
+        ClientManager manager;
+        EchoHandler handler( manager, nullptr );
+        UnixSocketProtocol running( manager, handler, cfg );
+        UnixSocketProtocol second( manager, handler, cfg );
+        if( running.init() || second.init() != JSR_ERROR_CANNOT_BIND_SOCKET ) {
+            result = false;
+        }
+    }
+
+    // Socket file without any listener.
+    int stale = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+    struct sockaddr_un address;
+    memset( &address, 0, sizeof( address ) );
+    address.sun_family = AF_UNIX;
+    strncpy( address.sun_path, path, sizeof( address.sun_path ) - 1 );
+    if( ::bind( stale, reinterpret_cast<struct sockaddr*>( &address ), sizeof( address ) ) ) {
+        result = false;
+    }
+    ::close( stale );
+    {
+        ClientManager manager;
+        EchoHandler handler( manager, nullptr );
+        UnixSocketProtocol restarted( manager, handler, cfg );
+        if( restarted.init() ) {
+            result = false;
+        }
+    }
+
+    ::unlink( path );
+    return result;
+}
+
+// A client marked to be removed but still in use doesn't count towards the limit.
+static bool testClientLimit() {
+    ClientManager manager( 1 );
+    Client *first = new Client( 1 );
+    if( manager.addClient( first ) ) {
+        return false;
+    }
+    Client *used = manager.getClient( 1 );
+    manager.removeClient( first );
+    bool result = manager.addClient( new Client( 2 ) ) == JSR_ERROR_NO_ERROR;
+    // The limit is still enforced for live clients.
+    Client *third = new Client( 3 );
+    if( manager.addClient( third ) != JSR_ERROR_TOO_MANY_CLIENTS ) {
+        result = false;
+    } else {
+        delete third;
+    }
+    // The same ID can be reused while the old client is still in use.
+    Client *second = manager.getClient( 2 );
+    manager.removeClient( second );
+    if( manager.addClient( new Client( 2 ) ) ) {
+        result = false;
+    }
+    manager.returnClient( second );
+    manager.returnClient( used );
+    manager.periodicCleanup();
+    if( manager.getClientsCount() != 1 ) {
+        result = false;
+    }
+    manager.stop();
+    return result;
+}
+
+// Client marked to be removed is deleted only after the last reference
+// is returned, even if its ID has been taken by a new client meanwhile.
+static bool testClientReferences() {
+    ClientManager manager;
+    std::atomic<int> deleted( 0 );
+    TrackedClient *old = new TrackedClient( 1, deleted );
+    if( manager.addClient( old ) ) {
+        return false;
+    }
+    bool result = true;
+    {
+        ClientPtrHolder<TrackedClient> first( manager, 1 );
+        ClientPtrHolder<TrackedClient> second( manager, 1 );
+        manager.removeClient( old );
+        ClientPtrHolder<TrackedClient> removed( manager, 1 );
+        if( &first != old || &second != old || removed ) {
+            result = false;
+        }
+        TrackedClient *current = new TrackedClient( 1, deleted );
+        if( manager.addClient( current ) ) {
+            return false;
+        }
+        ClientPtrHolder<TrackedClient> reused( manager, 1 );
+        if( &reused != current ) {
+            result = false;
+        }
+        first.release();
+        manager.periodicCleanup();
+        if( deleted.load() != 0 || !second->isAlive() || manager.getClientsCount() != 2 ) {
+            result = false;
+        }
+    }
+    manager.periodicCleanup();
+    if( deleted.load() != 1 || manager.getClientsCount() != 1 ) {
+        result = false;
+    }
+    if( manager.stop() || deleted.load() != 2 ) {
+        result = false;
+    }
+    return result;
+}
+
+// Clients are got and returned by other threads while they are being
+// removed and replaced by new ones with the same IDs.
+static bool testConcurrentClients() {
+    ClientManager manager;
+    std::atomic<int> deleted( 0 );
+    std::atomic<bool> stop( false );
+    TrackedClient *clients[SLOT_CLIENTS];
+    for( int i = 0; i < SLOT_CLIENTS; i++ ) {
+        clients[i] = new TrackedClient( i + 1, deleted );
+        if( manager.addClient( clients[i] ) ) {
+            return false;
+        }
+    }
+    ClientReader first( manager, stop );
+    ClientReader second( manager, stop );
+    Thread firstThread( first );
+    Thread secondThread( second );
+    firstThread.start();
+    secondThread.start();
+    bool result = true;
+    for( int round = 0; round < SLOT_ROUNDS; round++ ) {
+        int i = round % SLOT_CLIENTS;
+        manager.removeClient( clients[i] );
+        clients[i] = new TrackedClient( i + 1, deleted );
+        if( manager.addClient( clients[i] ) ) {
+            delete clients[i];
+            result = false;
+            break;
+        }
+        manager.periodicCleanup();
+    }
+    stop = true;
+    firstThread.join();
+    secondThread.join();
+    manager.periodicCleanup();
+    if( first.isFailed() || second.isFailed() || manager.getClientsCount() != SLOT_CLIENTS ) {
+        result = false;
+    }
+    // All the replaced clients are deleted once they are returned.
+    if( deleted.load() != SLOT_ROUNDS ) {
+        result = false;
+    }
+    if( manager.stop() || deleted.load() != SLOT_ROUNDS + SLOT_CLIENTS ) {
+        result = false;
+    }
+    return result;
+}
+
+// Only events which describe the whole state are coalesced and the newest
+// one goes to the end of the queue, so the order of events is kept.
+static bool testEventCoalescing() {
+    ClientManager manager( 1 );
+    manager.setOverflowPolicy( Command::PRIORITY_EVENT, JSRemoteDebuggerCfg::OVERFLOW_COALESCE );
+    Client *client = new Client( 1 );
+    if( manager.addClient( client ) ) {
+        return false;
+    }
+    char event[128];
+    Command paused( Command::BROADCAST, 1, "{\"type\":\"info\",\"subtype\":\"paused\",\"line\":1}" );
+    manager.broadcast( paused );
+    for( int i = 1; i < MAX_CLIENT_QUEUE_LENGTH; i++ ) {
+        snprintf( event, sizeof( event ), "{\"type\":\"info\",\"subtype\":\"breakpoint_set\",\"id\":%d}", i );
+        Command breakpoint( Command::BROADCAST, 1, event );
+        manager.broadcast( breakpoint );
+    }
+    Command newer( Command::BROADCAST, 1, "{\"type\":\"info\",\"subtype\":\"paused\",\"line\":2}" );
+    manager.broadcast( newer );
+    bool result = client->getCoalescedCount() == 1 && client->getDroppedCount() == 0;
+    // Distinct breakpoints cannot replace each other, the oldest one is dropped.
+    snprintf( event, sizeof( event ), "{\"type\":\"info\",\"subtype\":\"breakpoint_set\",\"id\":%d}", MAX_CLIENT_QUEUE_LENGTH );
+    Command breakpoint( Command::BROADCAST, 1, event );
+    manager.broadcast( breakpoint );
+    if( client->getCoalescedCount() != 1 || client->getDroppedCount() != 1 ) {
+        result = false;
+    }
+    Command out;
+    vector<string> events;
+    while( client->getOutQueue().get( out ) ) {
+        events.push_back( out.getValue() );
+    }
+    snprintf( event, sizeof( event ), "{\"type\":\"info\",\"subtype\":\"breakpoint_set\",\"id\":%d}", 2 );
+    if( events.size() != MAX_CLIENT_QUEUE_LENGTH || events.front() != event ||
+            events[events.size() - 2] != newer.getValue() || events.back() != breakpoint.getValue() ) {
+        result = false;
+    }
+    manager.stop();
+    return result;
+}
+
+// Responses addressed to a client are never dropped to make room, however
+// big they are, and they overtake the events. Only big broadcasts and the
+// commands marked explicitly are bulk transfers.
+static bool testBigResponses() {
+    ClientManager manager( 1, JSRemoteDebuggerCfg::SLOW_CLIENT_DROP );
+    Client *client = new Client( 1 );
+    if( manager.addClient( client ) ) {
+        return false;
+    }
+    const string big = randomLetters( JSR_BULK_COMMAND_SIZE );
+    Command bulk( Command::BROADCAST, 1, big );
+    manager.broadcast( bulk );
+    for( int i = 2; i < MAX_CLIENT_QUEUE_LENGTH; i++ ) {
+        Command event( Command::BROADCAST, 1, "{\"type\":\"info\",\"subtype\":\"breakpoint_set\"}" );
+        manager.broadcast( event );
+    }
+    bool result = bulk.getPriority() == Command::PRIORITY_BULK;
+    if( !manager.sendCommand( Command( 1, 1, big ) ) ) {
+        result = false;
+    }
+    // The queue is full now, so the slow client policy decides.
+    Command source( 1, 1, big );
+    source.setPriority( Command::PRIORITY_BULK );
+    if( manager.sendCommand( std::move( source ) ) || client->getDroppedCount() != 0 ) {
+        result = false;
+    }
+    Command out;
+    if( !client->getOutQueue().get( out ) || out.getPriority() != Command::PRIORITY_RESPONSE || out.getValue() != big ) {
+        result = false;
+    }
+    int count = 1;
+    while( client->getOutQueue().get( out ) ) {
+        count++;
+    }
+    // The bulk broadcast is the last one.
+    if( count != MAX_CLIENT_QUEUE_LENGTH || out.getPriority() != Command::PRIORITY_BULK ) {
+        result = false;
+    }
+    manager.stop();
+    return result;
+}
+
+// Commands sent without blocking are refused once the queue is full and
+// are left untouched, so they can be sent some other way.
+static bool testTrySendCommand() {
+    ClientManager manager( 1 );
+    if( manager.addClient( new Client( 1 ) ) ) {
+        return false;
+    }
+    bool result = true;
+    for( int i = 0; i < MAX_CLIENT_QUEUE_LENGTH; i++ ) {
+        if( !manager.trySendCommand( Command( 1, 1, "{\"type\":\"get_variables\"}" ) ) ) {
+            result = false;
+        }
+    }
+    Command command( 1, 1, "{\"type\":\"get_variables\",\"id\":1}" );
+    if( manager.trySendCommand( std::move( command ) ) || command.getValue() != "{\"type\":\"get_variables\",\"id\":1}" ) {
+        result = false;
+    }
+    if( manager.trySendCommand( Command( 2, 1, "{}" ) ) ) {
+        result = false;
+    }
+    manager.stop();
+    return result;
+}
+
+// Many clients talk to the server at once and every one of them gets
+// its own answers in order. Latency is measured by the load_bench.
+static bool testManyClients( int port ) {
+    JSRemoteDebuggerCfg cfg;
+    cfg.setTcpPort( port );
+    cfg.setMaxClients( MANY_CLIENTS );
+    TestServer server( cfg );
+    if( server.start() ) {
+        cout << "Cannot start the server on port " << port << "." << endl;
+        return false;
+    }
+
+    vector<PingClient*> clients;
+    vector<Thread*> threads;
+    for( int i = 0; i < MANY_CLIENTS; i++ ) {
+        clients.push_back( new PingClient( port, i, MANY_REQUESTS ) );
+        threads.push_back( new Thread( *clients.back() ) );
+    }
+    for( int i = 0; i < MANY_CLIENTS; i++ ) {
+        threads[i]->start();
+    }
+
+    bool result = true;
+    for( int i = 0; i < MANY_CLIENTS; i++ ) {
+        threads[i]->join();
+        if( clients[i]->isFailed() || clients[i]->getLatencies().size() != MANY_REQUESTS ) {
+            result = false;
+        }
+        delete threads[i];
+        delete clients[i];
+    }
+
+    server.stop();
+    return result;
+}
+
+int main( int argc, char **argv ) {
+
+    int port = argc > 1 ? atoi( argv[1] ) : JSR_CHECK_TCP_PORT;
+
+    int failed = 0;
+
+    if( !testClientLimit() ) {
+        cout << "Test failed: client limit." << endl;
+        failed++;
+    }
+
+    if( !testClientReferences() ) {
+        cout << "Test failed: client references." << endl;
+        failed++;
+    }
+
+    if( !testConcurrentClients() ) {
+        cout << "Test failed: concurrent clients." << endl;
+        failed++;
+    }
+
+    if( !testEventCoalescing() ) {
+        cout << "Test failed: event coalescing." << endl;
+        failed++;
+    }
+
+    if( !testBigResponses() ) {
+        cout << "Test failed: big responses." << endl;
+        failed++;
+    }
+
+    if( !testTrySendCommand() ) {
+        cout << "Test failed: sending without blocking." << endl;
+        failed++;
+    }
+
+    if( !testUnixSocketInUse() ) {
+        cout << "Test failed: Unix socket in use." << endl;
+        failed++;
+    }
+
+    if( !testBinaryFraming( port, false ) ) {
+        cout << "Test failed: binary framing." << endl;
+        failed++;
+    }
+
+    if( !testBinaryFraming( port, true ) ) {
+        cout << "Test failed: compressed binary framing." << endl;
+        failed++;
+    }
+
+    if( !testCredit( port, false ) ) {
+        cout << "Test failed: credit of the text protocol." << endl;
+        failed++;
+    }
+
+    if( !testCredit( port, true ) ) {
+        cout << "Test failed: credit of the binary framing." << endl;
+        failed++;
+    }
+
+    if( !testCompressedOversized( port ) ) {
+        cout << "Test failed: oversized compressed command." << endl;
+        failed++;
+    }
+
+    if( !testManyClients( port ) ) {
+        cout << "Test failed: many clients." << endl;
+        failed++;
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,250 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <algorithm>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include <timestamp.hpp>
+
+#include "tcp_harness.hpp"
+
+using namespace JSR;
+using namespace std;
+using namespace Utils;
+
+#define JSR_CHECK_READ_BUFFER   ( 64 * 1024 )
+
+EchoHandler::EchoHandler( ClientManager &manager, TestResponder responder )
+    : _manager(manager),
+      _responder(responder) {
+}
+
+void EchoHandler::handle( command_in_queue &queue, int signal ) {
+    Command command;
+    while( queue.get( command ) ) {
+        if( _responder ) {
+            _responder( _manager, command );
+        } else {
+            _manager.sendCommand( std::move( command ) );
+        }
+    }
+}
+
+TestServer::TestServer( const JSRemoteDebuggerCfg &cfg, TestResponder responder )
+    : _manager( cfg.getMaxClients(), cfg.getSlowClientPolicy(), cfg.getSlowClientTimeout() ),
+      _handler( _manager, responder ),
+      _protocol( _manager, _handler, cfg ),
+      _started( false ) {
+    _manager.setOverflowPolicy( Command::PRIORITY_EVENT, cfg.getEventOverflowPolicy() );
+    _manager.setOverflowPolicy( Command::PRIORITY_BULK, cfg.getBulkOverflowPolicy() );
+}
+
+TestServer::~TestServer() {
+    stop();
+}
+
+int TestServer::start() {
+    int rc = _protocol.init();
+    if( rc ) {
+        return rc;
+    }
+    rc = _protocol.startProtocol();
+    _started = rc == JSR_ERROR_NO_ERROR;
+    return rc;
+}
+
+void TestServer::stop() {
+    if( _started ) {
+        _protocol.stopProtocol();
+        _started = false;
+    }
+}
+
+ClientManager& TestServer::getClientManager() {
+    return _manager;
+}
+
+TestConnection::TestConnection()
+    : _socket(-1),
+      _buffer(JSR_CHECK_READ_BUFFER),
+      _offset(0),
+      _size(0) {
+}
+
+TestConnection::~TestConnection() {
+    close();
+}
+
+bool TestConnection::connect( int port ) {
+    close();
+    _socket = ::socket( AF_INET, SOCK_STREAM, 0 );
+    if( _socket < 0 ) {
+        return false;
+    }
+    // Latency is measured, so requests cannot wait for each other.
+    int noDelay = 1;
+    ::setsockopt( _socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof( noDelay ) );
+    struct sockaddr_in address;
+    memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_port = htons( port );
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    if( ::connect( _socket, reinterpret_cast<struct sockaddr*>( &address ), sizeof( address ) ) < 0 ) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool TestConnection::send( const string &data ) {
+    size_t sent = 0;
+    while( sent < data.size() ) {
+        ssize_t rc = ::send( _socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL );
+        if( rc < 0 ) {
+            if( errno == EINTR ) {
+                continue;
+            }
+            return false;
+        }
+        sent += rc;
+    }
+    return true;
+}
+
+bool TestConnection::readLine( string &line ) {
+    line.clear();
+    while( true ) {
+        const char *data = &_buffer[_offset];
+        const char *end = static_cast<const char*>( memchr( data, '\n', _size - _offset ) );
+        if( end ) {
+            line.append( data, end - data );
+            _offset += end - data + 1;
+            return true;
+        }
+        line.append( data, _size - _offset );
+        _offset = _size = 0;
+        ssize_t rc = ::recv( _socket, &_buffer[0], _buffer.size(), 0 );
+        if( rc < 0 && errno == EINTR ) {
+            continue;
+        } else if( rc <= 0 ) {
+            return false;
+        }
+        _size = rc;
+    }
+}
+
+bool TestConnection::read( char *buffer, size_t size ) {
+    while( size > 0 ) {
+        if( _offset == _size ) {
+            _offset = _size = 0;
+            ssize_t rc = ::recv( _socket, &_buffer[0], _buffer.size(), 0 );
+            if( rc < 0 && errno == EINTR ) {
+                continue;
+            } else if( rc <= 0 ) {
+                return false;
+            }
+            _size = rc;
+        }
+        size_t chunk = min( size, _size - _offset );
+        memcpy( buffer, &_buffer[_offset], chunk );
+        _offset += chunk;
+        buffer += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+
+bool TestConnection::waitForData( int timeout ) {
+    if( _offset < _size ) {
+        return true;
+    }
+    struct pollfd fd;
+    fd.fd = _socket;
+    fd.events = POLLIN;
+    fd.revents = 0;
+    int rc;
+    while( ( rc = ::poll( &fd, 1, timeout ) ) < 0 && errno == EINTR ) { }
+    return rc > 0;
+}
+
+void TestConnection::close() {
+    if( _socket >= 0 ) {
+        ::close( _socket );
+        _socket = -1;
+    }
+    _offset = _size = 0;
+}
+
+PingClient::PingClient( int port, int id, int requests )
+    : _port(port),
+      _id(id),
+      _requests(requests),
+      _failed(false) {
+    _latencies.reserve( requests );
+}
+
+void PingClient::run() {
+    TestConnection connection;
+    if( !connection.connect( _port ) ) {
+        _failed = true;
+        return;
+    }
+    char request[64];
+    string response;
+    for( int i = 0; i < _requests; i++ ) {
+        snprintf( request, sizeof( request ), "0/{\"client\":%d,\"ping\":%d}", _id, i );
+        TimeStamp start;
+        if( !connection.send( string( request ) + "\n" ) || !connection.readLine( response ) ) {
+            _failed = true;
+            return;
+        }
+        _latencies.push_back( ( TimeStamp() - start ).getMicros() );
+        // Answers cannot be mixed up between clients nor reordered.
+        if( response != string( request ) ) {
+            _failed = true;
+            return;
+        }
+    }
+}
+
+bool PingClient::isFailed() const {
+    return _failed;
+}
+
+const vector<uint64_t>& PingClient::getLatencies() const {
+    return _latencies;
+}
+
+uint64_t JSR::percentile( vector<uint64_t> &samples, double fraction ) {
+    if( samples.empty() ) {
+        return 0;
+    }
+    sort( samples.begin(), samples.end() );
+    size_t index = static_cast<size_t>( fraction * ( samples.size() - 1 ) );
+    return samples[index];
+}
@@ -0,0 +1,136 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CHECK_TCP_HARNESS_H_
+#define CHECK_TCP_HARNESS_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <jsrdbg.h>
+#include <threads.hpp>
+#include <client.hpp>
+#include <tcp_protocol.hpp>
+
+// Default port of the test server, can be changed by the first argument.
+#define JSR_CHECK_TCP_PORT  28089
+
+namespace JSR {
+
+/**
+ * Answers incoming command, it's called on the protocol thread.
+ */
+typedef void (*TestResponder)( ClientManager &manager, Command &command );
+
+/**
+ * Debugger stand-in which passes every incoming command to the responder,
+ * by default the command is sent back to the client it came from.
+ */
+class EchoHandler : public command_in_handler {
+public:
+    EchoHandler( ClientManager &manager, TestResponder responder );
+    void handle( command_in_queue &queue, int signal );
+private:
+    ClientManager &_manager;
+    TestResponder _responder;
+};
+
+/**
+ * TCP protocol together with its client's manager, serving the echo handler.
+ */
+class TestServer : public Utils::NonCopyable {
+public:
+    explicit TestServer( const JSRemoteDebuggerCfg &cfg, TestResponder responder = nullptr );
+    ~TestServer();
+    /**
+     * Binds the server socket and starts the protocol thread.
+     * @return Standard JSRDBG error code.
+     */
+    int start();
+    void stop();
+    ClientManager& getClientManager();
+private:
+    ClientManager _manager;
+    EchoHandler _handler;
+    TCPProtocol _protocol;
+    bool _started;
+};
+
+/**
+ * Blocking connection used by test clients.
+ */
+class TestConnection : public Utils::NonCopyable {
+public:
+    TestConnection();
+    ~TestConnection();
+    bool connect( int port );
+    bool send( const std::string &data );
+    /**
+     * Reads one line without its separator.
+     * @return False if the connection has been closed or failed.
+     */
+    bool readLine( std::string &line );
+    /**
+     * Reads exactly given number of bytes.
+     */
+    bool read( char *buffer, size_t size );
+    /**
+     * Waits for data which hasn't been read yet.
+     * @param timeout Maximum time to wait in milliseconds.
+     * @return False if there is nothing to read.
+     */
+    bool waitForData( int timeout );
+    void close();
+private:
+    int _socket;
+    std::vector<char> _buffer;
+    size_t _offset;
+    size_t _size;
+};
+
+/**
+ * Client which sends requests one by one and waits for every answer,
+ * checking that it's an echo of its own request.
+ */
+class PingClient : public Utils::Runnable {
+public:
+    PingClient( int port, int id, int requests );
+    void run();
+    bool isFailed() const;
+    /**
+     * Gets round-trip time of every request in microseconds.
+     */
+    const std::vector<uint64_t>& getLatencies() const;
+private:
+    int _port;
+    int _id;
+    int _requests;
+    bool _failed;
+    std::vector<uint64_t> _latencies;
+};
+
+/**
+ * Gets the given percentile of the samples, which are sorted in place.
+ */
+uint64_t percentile( std::vector<uint64_t> &samples, double fraction );
+
+}
+
+#endif /* CHECK_TCP_HARNESS_H_ */
@@ -0,0 +1,390 @@
+/*
+ * Unit tests for the SpiderMonkey Java Script Engine Debugger.
+ * Copyright (C) 2014-2015 Slawomir Wojtasiak
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <errno.h>
+#include <iconv.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <unicode.hpp>
+
+using namespace std;
+using namespace Utils;
+
+// Number of random strings compared with iconv for every kernel.
+#define RANDOM_STRINGS      20000
+
+typedef vector<uint16_t> UTF16String;
+
+struct UTF8Case {
+    const char *utf8;
+    size_t size;
+    uint16_t utf16[4];
+    size_t length;
+};
+
+#define UTF8_CASE( utf8, length, ... ) { utf8, sizeof( utf8 ) - 1, { __VA_ARGS__ }, length }
+
+// Every byte which is not a part of a well-formed sequence is replaced.
+static const UTF8Case UTF8_CASES[] = {
+    UTF8_CASE( "", 0, 0 ),
+    UTF8_CASE( "A", 1, 'A' ),
+    UTF8_CASE( "\x7F", 1, 0x7F ),
+    UTF8_CASE( "\xC2\x80", 1, 0x80 ),
+    UTF8_CASE( "\xC3\xA9", 1, 0xE9 ),
+    UTF8_CASE( "\xDF\xBF", 1, 0x7FF ),
+    UTF8_CASE( "\xE0\xA0\x80", 1, 0x800 ),
+    UTF8_CASE( "\xE2\x82\xAC", 1, 0x20AC ),
+    UTF8_CASE( "\xED\x9F\xBF", 1, 0xD7FF ),
+    UTF8_CASE( "\xEE\x80\x80", 1, 0xE000 ),
+    UTF8_CASE( "\xEF\xBF\xBF", 1, 0xFFFF ),
+    UTF8_CASE( "\xF0\x90\x80\x80", 2, 0xD800, 0xDC00 ),
+    UTF8_CASE( "\xF0\x9F\x98\x80", 2, 0xD83D, 0xDE00 ),
+    UTF8_CASE( "\xF4\x8F\xBF\xBF", 2, 0xDBFF, 0xDFFF ),
+    // Overlong forms.
+    UTF8_CASE( "\xC0\x80", 2, '?', '?' ),
+    UTF8_CASE( "\xC1\xBF", 2, '?', '?' ),
+    UTF8_CASE( "\xE0\x9F\xBF", 3, '?', '?', '?' ),
+    UTF8_CASE( "\xF0\x8F\xBF\xBF", 4, '?', '?', '?', '?' ),
+    // Surrogates.
+    UTF8_CASE( "\xED\xA0\x80", 3, '?', '?', '?' ),
+    UTF8_CASE( "\xED\xBF\xBF", 3, '?', '?', '?' ),
+    // Code points above U+10FFFF.
+    UTF8_CASE( "\xF4\x90\x80\x80", 4, '?', '?', '?', '?' ),
+    UTF8_CASE( "\xF5\x80\x80\x80", 4, '?', '?', '?', '?' ),
+    UTF8_CASE( "\xFF", 1, '?' ),
+    // Stray continuation bytes.
+    UTF8_CASE( "\x80", 1, '?' ),
+    UTF8_CASE( "\xBF\xBF", 2, '?', '?' ),
+    // Truncated sequences.
+    UTF8_CASE( "\xC3", 1, '?' ),
+    UTF8_CASE( "\xE2\x82", 2, '?', '?' ),
+    UTF8_CASE( "\xF0\x9F\x98", 3, '?', '?', '?' ),
+    UTF8_CASE( "\xE2\x82" "A", 3, '?', '?', 'A' ),
+    UTF8_CASE( "\xF0\x9F\x98\xC3\xA9", 4, '?', '?', '?', 0xE9 )
+};
+
+struct UTF16Case {
+    uint16_t utf16[4];
+    size_t length;
+    const char *utf8;
+    size_t size;
+};
+
+#define UTF16_CASE( utf8, length, ... ) { { __VA_ARGS__ }, length, utf8, sizeof( utf8 ) - 1 }
+
+// Unpaired surrogates are replaced.
+static const UTF16Case UTF16_CASES[] = {
+    UTF16_CASE( "", 0, 0 ),
+    UTF16_CASE( "A", 1, 'A' ),
+    UTF16_CASE( "\xC2\x80", 1, 0x80 ),
+    UTF16_CASE( "\xDF\xBF", 1, 0x7FF ),
+    UTF16_CASE( "\xE0\xA0\x80", 1, 0x800 ),
+    UTF16_CASE( "\xEF\xBF\xBF", 1, 0xFFFF ),
+    UTF16_CASE( "\xF0\x9F\x98\x80", 2, 0xD83D, 0xDE00 ),
+    UTF16_CASE( "\xF4\x8F\xBF\xBF", 2, 0xDBFF, 0xDFFF ),
+    UTF16_CASE( "?", 1, 0xD800 ),
+    UTF16_CASE( "?", 1, 0xDC00 ),
+    UTF16_CASE( "??", 2, 0xDC00, 0xD800 ),
+    UTF16_CASE( "?A", 2, 0xD83D, 'A' ),
+    UTF16_CASE( "?\xF0\x9F\x98\x80", 3, 0xD83D, 0xD83D, 0xDE00 ),
+    UTF16_CASE( "\xF0\x9F\x98\x80?", 3, 0xD83D, 0xDE00, 0xDE00 )
+};
+
+// ASCII runs around every case, so they are converted by the kernels
+// and the scalar code takes over at every possible position.
+static const size_t RUN_LENGTHS[] = { 0, 1, 15, 16, 17, 31, 32, 33, 64 };
+
+static string asciiRun( size_t length ) {
+    string run;
+    for( size_t i = 0; i < length; i++ ) {
+        run += static_cast<char>( 'a' + i % 26 );
+    }
+    return run;
+}
+
+static UTF16String toUTF16( const string &utf8 ) {
+    UTF16String result( getUTF16Length( utf8.data(), utf8.size() ) + 1 );
+    result.resize( convertUTF8ToUTF16( utf8.data(), utf8.size(), &result[0] ) );
+    return result;
+}
+
+static string toUTF8( const UTF16String &utf16 ) {
+    size_t length = getUTF8Length( utf16.empty() ? nullptr : &utf16[0], utf16.size() );
+    string result( length + 1, '\0' );
+    result.resize( convertUTF16ToUTF8( utf16.empty() ? nullptr : &utf16[0], utf16.size(), &result[0] ) );
+    return length == result.size() ? result : string( "length mismatch" );
+}
+
+static bool testUTF8Cases() {
+    bool result = true;
+    for( size_t i = 0; i < sizeof( UTF8_CASES ) / sizeof( UTF8_CASES[0] ); i++ ) {
+        const UTF8Case &test = UTF8_CASES[i];
+        for( size_t j = 0; j < sizeof( RUN_LENGTHS ) / sizeof( RUN_LENGTHS[0] ); j++ ) {
+            string run = asciiRun( RUN_LENGTHS[j] );
+            string input = run + string( test.utf8, test.size ) + run;
+            UTF16String expected( run.begin(), run.end() );
+            expected.insert( expected.end(), test.utf16, test.utf16 + test.length );
+            expected.insert( expected.end(), run.begin(), run.end() );
+            UTF16String output = toUTF16( input );
+            if( output != expected || getUTF16Length( input.data(), input.size() ) != expected.size() ) {
+                cout << "UTF-8 case " << i << " misconverted after " << RUN_LENGTHS[j] << " ASCII characters." << endl;
+                result = false;
+            }
+        }
+    }
+    return result;
+}
+
+static bool testUTF16Cases() {
+    bool result = true;
+    for( size_t i = 0; i < sizeof( UTF16_CASES ) / sizeof( UTF16_CASES[0] ); i++ ) {
+        const UTF16Case &test = UTF16_CASES[i];
+        for( size_t j = 0; j < sizeof( RUN_LENGTHS ) / sizeof( RUN_LENGTHS[0] ); j++ ) {
+            string run = asciiRun( RUN_LENGTHS[j] );
+            UTF16String input( run.begin(), run.end() );
+            input.insert( input.end(), test.utf16, test.utf16 + test.length );
+            input.insert( input.end(), run.begin(), run.end() );
+            if( toUTF8( input ) != run + string( test.utf8, test.size ) + run ) {
+                cout << "UTF-16 case " << i << " misconverted after " << RUN_LENGTHS[j] << " ASCII characters." << endl;
+                result = false;
+            }
+        }
+    }
+    return result;
+}
+
+// Conversions the way they were done before: iconv replacing every
+// unit it cannot convert, one at a time.
+static bool convertWithIconv( const char *to, const char *from, const char *data, size_t size,
+        size_t unitSize, string &output ) {
+    iconv_t cd = iconv_open( to, from );
+    if( cd == reinterpret_cast<iconv_t>( -1 ) ) {
+        return false;
+    }
+    // Every unit converts into at most 4 bytes.
+    string buffer( size * 4 + 16, '\0' );
+    char *in = const_cast<char*>( data );
+    size_t inLeft = size;
+    char *out = &buffer[0];
+    size_t outLeft = buffer.size();
+    bool result = true;
+    while( inLeft > 0 ) {
+        if( iconv( cd, &in, &inLeft, &out, &outLeft ) != static_cast<size_t>( -1 ) ) {
+            continue;
+        }
+        if( errno != EILSEQ && errno != EINVAL ) {
+            result = false;
+            break;
+        }
+        // Replacement character in the output encoding.
+        const char *replacement = unitSize == 1 ? "?\0" : "?";
+        size_t replacementSize = unitSize == 1 ? 2 : 1;
+        for( size_t i = 0; i < replacementSize; i++ ) {
+            *out++ = replacement[i];
+            outLeft--;
+        }
+        size_t skip = inLeft < unitSize ? inLeft : unitSize;
+        in += skip;
+        inLeft -= skip;
+    }
+    output.assign( &buffer[0], out - &buffer[0] );
+    iconv_close( cd );
+    return result;
+}
+
+class StringGenerator {
+public:
+    StringGenerator()
+        : _seed(54321) {
+    }
+    // Valid characters mixed with stray, overlong and truncated sequences.
+    string generateUTF8( bool valid ) {
+        string result;
+        int pieces = next( 12 );
+        for( int i = 0; i < pieces; i++ ) {
+            switch( next( valid ? 2 : 5 ) ) {
+            case 0:
+                result += asciiRun( next( 70 ) );
+                break;
+            case 1:
+                appendUTF8( result, generateCodePoint() );
+                break;
+            case 2:
+                result += static_cast<char>( 0x80 + next( 0x80 ) );
+                break;
+            case 3: {
+                string sequence;
+                appendUTF8( sequence, generateCodePoint() );
+                result += sequence.substr( 0, next( static_cast<uint32_t>( sequence.size() ) ) );
+                break;
+            }
+            default: {
+                static const char *MALFORMED[] = { "\xC0\xAF", "\xE0\x80\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80" };
+                result += MALFORMED[next( 4 )];
+                break;
+            }
+            }
+        }
+        return result;
+    }
+    // Pairs mixed with unpaired surrogates.
+    UTF16String generateUTF16() {
+        UTF16String result;
+        int pieces = next( 12 );
+        for( int i = 0; i < pieces; i++ ) {
+            if( next( 2 ) ) {
+                string run = asciiRun( next( 70 ) );
+                result.insert( result.end(), run.begin(), run.end() );
+            } else if( next( 4 ) ) {
+                UTF16String character = toUTF16( string() + generateCharacter() );
+                result.insert( result.end(), character.begin(), character.end() );
+            } else {
+                result.push_back( static_cast<uint16_t>( 0xD800 + next( 0x800 ) ) );
+            }
+        }
+        return result;
+    }
+private:
+    uint32_t next( uint32_t range ) {
+        _seed = _seed * 1103515245 + 12345;
+        return range ? ( _seed >> 8 ) % range : 0;
+    }
+    uint32_t generateCodePoint() {
+        switch( next( 3 ) ) {
+        case 0:
+            return 0x80 + next( 0x780 );
+        case 1: {
+            uint32_t code = 0x800 + next( 0xF800 );
+            return code >= 0xD800 && code <= 0xDFFF ? 0xFFFD : code;
+        }
+        default:
+            return 0x10000 + next( 0x100000 );
+        }
+    }
+    string generateCharacter() {
+        string result;
+        appendUTF8( result, generateCodePoint() );
+        return result;
+    }
+    static void appendUTF8( string &dest, uint32_t code ) {
+        if( code < 0x800 ) {
+            dest += static_cast<char>( 0xC0 | ( code >> 6 ) );
+            dest += static_cast<char>( 0x80 | ( code & 0x3F ) );
+        } else if( code < 0x10000 ) {
+            dest += static_cast<char>( 0xE0 | ( code >> 12 ) );
+            dest += static_cast<char>( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+            dest += static_cast<char>( 0x80 | ( code & 0x3F ) );
+        } else {
+            dest += static_cast<char>( 0xF0 | ( code >> 18 ) );
+            dest += static_cast<char>( 0x80 | ( ( code >> 12 ) & 0x3F ) );
+            dest += static_cast<char>( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+            dest += static_cast<char>( 0x80 | ( code & 0x3F ) );
+        }
+    }
+private:
+    uint32_t _seed;
+};
+
+// Random strings are converted exactly the way iconv converts them.
+static bool testAgainstIconv() {
+    StringGenerator generator;
+    for( int i = 0; i < RANDOM_STRINGS; i++ ) {
+        string utf8 = generator.generateUTF8( false );
+        string expected;
+        if( !convertWithIconv( "UTF-16LE", "UTF-8", utf8.data(), utf8.size(), 1, expected ) ) {
+            cout << "iconv failed." << endl;
+            return false;
+        }
+        UTF16String utf16 = toUTF16( utf8 );
+        if( utf16.size() * 2 != expected.size() || ( !utf16.empty() && expected.compare( 0, expected.size(),
+                reinterpret_cast<const char*>( &utf16[0] ), utf16.size() * 2 ) ) ) {
+            cout << "UTF-8 string " << i << " converted differently than by iconv." << endl;
+            return false;
+        }
+        utf16 = generator.generateUTF16();
+        if( !convertWithIconv( "UTF-8", "UTF-16LE", reinterpret_cast<const char*>( utf16.empty() ? nullptr : &utf16[0] ),
+                utf16.size() * 2, 2, expected ) ) {
+            cout << "iconv failed." << endl;
+            return false;
+        }
+        if( toUTF8( utf16 ) != expected ) {
+            cout << "UTF-16 string " << i << " converted differently than by iconv." << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool testRoundTrip() {
+    StringGenerator generator;
+    for( int i = 0; i < RANDOM_STRINGS; i++ ) {
+        string utf8 = generator.generateUTF8( true );
+        if( toUTF8( toUTF16( utf8 ) ) != utf8 ) {
+            cout << "String " << i << " changed by the round trip." << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main( int argc, char **argv ) {
+
+    if( !isNativeUTF16LE() ) {
+        cout << "Skipped, differential test needs a little-endian host." << endl;
+        return 0;
+    }
+
+    const UnicodeKernel kernels[] = { UNICODE_KERNEL_SCALAR, UNICODE_KERNEL_SSE2, UNICODE_KERNEL_AVX2 };
+    const char *names[] = { "scalar", "SSE2", "AVX2" };
+
+    int failed = 0;
+
+    for( size_t i = 0; i < sizeof( kernels ) / sizeof( kernels[0] ); i++ ) {
+
+        if( !setUnicodeKernel( kernels[i] ) ) {
+            cout << names[i] << " kernels not supported, skipped." << endl;
+            continue;
+        }
+
+        if( !testUTF8Cases() ) {
+            cout << "Test failed: UTF-8 cases, " << names[i] << " kernels." << endl;
+            failed++;
+        }
+
+        if( !testUTF16Cases() ) {
+            cout << "Test failed: UTF-16 cases, " << names[i] << " kernels." << endl;
+            failed++;
+        }
+
+        if( !testAgainstIconv() ) {
+            cout << "Test failed: iconv, " << names[i] << " kernels." << endl;
+            failed++;
+        }
+
+        if( !testRoundTrip() ) {
+            cout << "Test failed: round trip, " << names[i] << " kernels." << endl;
+            failed++;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
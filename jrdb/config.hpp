@@ -31,6 +31,8 @@ public:
         _port = JDB_CONFIG_DEFAULT_PORT;
         _host = "127.0.0.1";
         _verbose = false;
+        _binary = false;
+        _compress = false;
     }
 
     ~Configuration() {}
@@ -43,6 +45,14 @@ public:
         _host = host;
     }
 
+    const std::string &getSocketPath() const {
+        return _socketPath;
+    }
+
+    void setSocketPath( const std::string &socketPath ) {
+        _socketPath = socketPath;
+    }
+
     int getPort() const {
         return _port;
     }
@@ -59,10 +69,29 @@ public:
         _verbose = verbose;
     }
 
+    bool isBinary() const {
+        return _binary;
+    }
+
+    void setBinary(bool binary) {
+        _binary = binary;
+    }
+
+    bool isCompress() const {
+        return _compress;
+    }
+
+    void setCompress(bool compress) {
+        _compress = compress;
+    }
+
 private:
     std::string _host;
+    std::string _socketPath;
     int _port;
     bool _verbose;
+    bool _binary;
+    bool _compress;
 };
 
 #endif /* SRC_CONFIGURATION_HPP_ */
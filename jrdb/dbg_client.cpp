@@ -85,7 +85,12 @@ void MainEventHandler::handle( IEvent *event ) {
         string commandStr = debuggerEvent->str();
 
         int contextId = -1;
-        MozJSUtils::splitCommand( commandStr, contextId, commandStr );
+        if( debuggerEvent->hasContextId() ) {
+            // Binary frames carry context ID outside of the content.
+            contextId = debuggerEvent->getContextId();
+        } else {
+            MozJSUtils::splitCommand( commandStr, contextId, commandStr );
+        }
 
         DebuggerCommand command( contextId, commandStr );
 
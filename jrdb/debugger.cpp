@@ -20,12 +20,28 @@
 #include "debugger.hpp"
 
 DebuggerCommandEvent::DebuggerCommandEvent( const std::string &str )
-    : StringEvent(str) {
+    : StringEvent(str),
+      _hasContextId(false),
+      _contextId(-1) {
+}
+
+DebuggerCommandEvent::DebuggerCommandEvent( int contextId, const std::string &str )
+    : StringEvent(str),
+      _hasContextId(true),
+      _contextId(contextId) {
 }
 
 DebuggerCommandEvent::~DebuggerCommandEvent() {
 }
 
+bool DebuggerCommandEvent::hasContextId() const {
+    return _hasContextId;
+}
+
+int DebuggerCommandEvent::getContextId() const {
+    return _contextId;
+}
+
 DebuggerCommand::DebuggerCommand( int contextId, const std::string content )
     : _contextId( contextId ),
       _content( content ) {
@@ -30,7 +30,17 @@
 class DebuggerCommandEvent : public StringEvent {
 public:
     DebuggerCommandEvent( const std::string &str );
+    /**
+     * Creates an event for a command which context ID
+     * has been already extracted by the transport.
+     */
+    DebuggerCommandEvent( int contextId, const std::string &str );
     virtual ~DebuggerCommandEvent();
+    bool hasContextId() const;
+    int getContextId() const;
+private:
+    bool _hasContextId;
+    int _contextId;
 };
 
 /**
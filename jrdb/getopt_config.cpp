@@ -39,12 +39,18 @@ bool GetoptConfigParser::parse( Configuration &configuration ) {
             "  -v,  --verbose          enable verbose output\n" \
             "  -p,  --port             remote TCP port\n" \
             "  -h,  --host             remote domain or IP address\n" \
+            "  -s,  --socket           path of the local Unix domain socket\n" \
+            "  -b,  --binary           use length-prefixed binary framing\n" \
+            "  -z,  --compress         ask for compressed binary frames\n" \
             "       --help             display this help and exit\n\n" \
             "By default it tries to connect to 127.0.0.1 using port 8089.\n\n" \
             "Examples:\n" \
             "  jrdb --port=8080 --host=example.com   Connects to the debugger\n" \
             "                                        exposed by example.com on\n" \
-            "                                        port 8080.\n\n" \
+            "                                        port 8080.\n" \
+            "  jrdb --socket=/tmp/jsrdbg.sock        Connects to the debugger\n" \
+            "                                        listening at a local Unix\n" \
+            "                                        domain socket.\n\n" \
             "Report bugs to: slawomir@wojtasiak.com\n" \
             "pkg home page: <https://github.com/swojtasiak/jsrdbg>\n";
 
@@ -62,11 +68,14 @@ bool GetoptConfigParser::parse( Configuration &configuration ) {
             {"verbose", no_argument,       0,        'v'},
             {"port",    required_argument, 0,        'p'},
             {"host",    required_argument, 0,        'h'},
+            {"socket",  required_argument, 0,        's'},
+            {"binary",  no_argument,       0,        'b'},
+            {"compress", no_argument,      0,        'z'},
             {"help",    no_argument,       &is_help, 1},
             {0, 0, 0, 0}
         };
 
-        c = getopt_long(_argc, _argv, "vp:h:", long_options, &option_index);
+        c = getopt_long(_argc, _argv, "vp:h:s:bz", long_options, &option_index);
         if (c == -1) {
             /* No more options. */
             break;
@@ -87,6 +96,17 @@ bool GetoptConfigParser::parse( Configuration &configuration ) {
         case 'h':
             configuration.setHost(optarg);
             break;
+        case 's':
+            configuration.setSocketPath(optarg);
+            break;
+        case 'b':
+            configuration.setBinary(true);
+            break;
+        case 'z':
+            // Compression is available only for binary frames.
+            configuration.setBinary(true);
+            configuration.setCompress(true);
+            break;
         case '?':
             /* Unrecognized option. */
             result = false;
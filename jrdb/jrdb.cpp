@@ -174,13 +174,22 @@ int main(int argc, char **argv) {
 
     // Connect to a debugger instance.
     TCPClient *client;
-    int error = TCPClient::Connect( configuration.getHost(),
-            configuration.getPort(), &client );
+    int error;
+    if( !configuration.getSocketPath().empty() ) {
+        error = TCPClient::ConnectUnix( configuration.getSocketPath(), &client );
+    } else {
+        error = TCPClient::Connect( configuration.getHost(),
+                configuration.getPort(), &client );
+    }
     if( error ) {
         cout << strerror( errno ) << endl;
         exit(1);
     }
 
+    if( configuration.isBinary() ) {
+        client->requestBinaryFraming( configuration.isCompress() );
+    }
+
     // Initialize JS engine.
     DebuggerCtxImpl dbgCtx(rlConsumer, *client);
     JSDebugger dbg(dbgCtx);
@@ -194,7 +194,7 @@ int JSDebugger::init() {
     Utils::ResourceManager &jrdbRM = JRDB::GetResourceManager();
 
     // Registers module for client modules and utility modules.
-    if( !jsUtils.registerModuleLoader( global ) ||
+    if( !jsUtils.registerModuleLoader( global, false ) ||
             !jsUtils.addResourceManager( global, "client", jrdbRM ) ||
             !jsUtils.addResourceManager( global, "utils", Utils::GetResourceManager() ) ) {
         return JDB_ERROR_JS_CANNOT_REGISTER_MODULE_LOADER;
@@ -22,6 +22,7 @@
 #include <string.h>
 #include <sstream>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <pthread.h>
@@ -33,6 +34,7 @@
 #include "errors.hpp"
 #include "tcp_client.hpp"
 #include <log.hpp>
+#include <framing.hpp>
 
 #define QUEUE_GUARD     1024
 
@@ -57,7 +59,8 @@ int ClientDisconnectedEvent::getReason() {
 
 TCPClient::TCPClient( int socket )
     : _socket( socket),
-      _eventHandler(nullptr) {
+      _eventHandler(nullptr),
+      _framing(FRAMING_TEXT) {
 }
 
 TCPClient::~TCPClient() {
@@ -80,29 +83,70 @@ int TCPClient::getConsumerFD() {
 
 int TCPClient::handleBuffer() {
 
-    // Looking for a command separator.
     byte_vector &buffer = getConsumerBuffer();
-
-    for( byte_vector::size_type i = 0; i < buffer.size(); i++ ) {
-        int c = buffer[i];
-        if( c == '\n' ) {
-            // Separator has been found, so extract a command.
-            stringstream buff;
-            for( byte_vector::size_type j = 0; j < i; j++ ) {
-                buff << buffer[j];
+    const char *data = reinterpret_cast<const char*>( buffer.data() );
+    size_t size = buffer.size();
+    size_t offset = 0;
+
+    while( offset < size ) {
+        if( _framing == FRAMING_BINARY ) {
+            if( size - offset < JSR_FRAME_HEADER_SIZE ) {
+                break;
+            }
+            FrameHeader header;
+            decodeFrameHeader( data + offset, header );
+            if( header.flags & ~JSR_FRAME_FLAG_DEFLATE ) {
+                return JDB_ERROR_MALICIOUS_DATA;
+            }
+            if( size - offset - JSR_FRAME_HEADER_SIZE < header.length ) {
+                // Wait for the rest of the frame.
+                break;
+            }
+            const char *payload = data + offset + JSR_FRAME_HEADER_SIZE;
+            string content;
+            if( header.flags & JSR_FRAME_FLAG_DEFLATE ) {
+                if( !_inflater.inflate( payload, header.length, content, FD_MAX_BUFFER_SIZE ) ) {
+                    LoggerFactory::getLogger().error("Cannot decompress incoming frame.");
+                    return JDB_ERROR_DECOMPRESSION_FAILED;
+                }
+            } else {
+                content.assign( payload, header.length );
             }
-            // Remove command from the buffer.
-            buffer.erase(buffer.begin(), buffer.begin() + i + 1);
-            DebuggerCommandEvent *event = new DebuggerCommandEvent(buff.str());
-            consume( event );
-            // Reset counter.
-            i = 0;
-        } else if( c == '\0' ) {
-            // Protocol doesn't allow zeroes.
-            return JDB_ERROR_MALICIOUS_DATA;
+            offset += JSR_FRAME_HEADER_SIZE + header.length;
+            consume( new DebuggerCommandEvent( header.contextId, content ) );
+        } else {
+            // Looking for a command separator.
+            size_t end = offset + scanFrame( data + offset, size - offset );
+            if( end == size ) {
+                break;
+            }
+            if( data[end] == '\0' ) {
+                // Protocol doesn't allow zeroes.
+                return JDB_ERROR_MALICIOUS_DATA;
+            }
+            string content( data + offset, end - offset );
+            offset = end + 1;
+            if( _framing == FRAMING_NEGOTIATING ) {
+                // Debugger confirmed the switch, so everything what
+                // comes next is a binary frame.
+                if( content == JSR_FRAME_PROTOCOL_BINARY ) {
+                    _framing = FRAMING_BINARY;
+                    continue;
+                } else if( content == JSR_FRAME_PROTOCOL_BINARY_DEFLATE ) {
+                    if( !_inflater.init() ) {
+                        return JDB_ERROR_DECOMPRESSION_FAILED;
+                    }
+                    _framing = FRAMING_BINARY;
+                    continue;
+                }
+            }
+            consume( new DebuggerCommandEvent( content ) );
         }
     }
 
+    // Remove handled commands from the buffer at once.
+    buffer.erase( buffer.begin(), buffer.begin() + offset );
+
     return JDB_ERROR_NO_ERROR;
 }
 
@@ -120,22 +164,41 @@ int TCPClient::getProducerFD() {
 }
 
 int TCPClient::prepareBuffer() {
+    if( _framing == FRAMING_NEGOTIATING ) {
+        // Commands have to wait until the framing is confirmed.
+        return JDB_ERROR_NO_ERROR;
+    }
     if( !_outgoingCommands.empty() ) {
         vector<int8_t> &buffer = getProducerBuffer();
         // Put commands directly into the destination buffer.
         while( !_outgoingCommands.empty() ) {
             DebuggerCommand &cmd = _outgoingCommands.front();
+            const string &content = cmd.getContent();
+            if( _framing == FRAMING_BINARY ) {
+                if( content.size() + buffer.size() + JSR_FRAME_HEADER_SIZE < FD_MAX_BUFFER_SIZE ) {
+                    FrameHeader header;
+                    header.length = static_cast<uint32_t>( content.size() );
+                    header.contextId = cmd.getContextId();
+                    header.flags = 0;
+                    size_t pos = buffer.size();
+                    buffer.resize( pos + JSR_FRAME_HEADER_SIZE );
+                    encodeFrameHeader( header, &buffer[pos] );
+                    buffer.insert( buffer.end(), content.begin(), content.end() );
+                } else {
+                    LoggerFactory::getLogger().error("Output buffer is full, command ignored.");
+                }
+                _outgoingCommands.pop();
+                continue;
+            }
             // Copy command to the output buffer.
-            string content = cmd.getContent();
+            string line = content;
             if( cmd.getContextId() != -1 ) {
                 stringstream ss;
                 ss << cmd.getContextId() << '/' << content;
-                content = ss.str();
+                line = ss.str();
             }
-            if( content.size() + buffer.size() + 1 < FD_MAX_BUFFER_SIZE ) {
-                for(string::const_iterator it = content.begin(); it != content.end(); ++it) {
-                    buffer.push_back( *it );
-                }
+            if( line.size() + buffer.size() + 1 < FD_MAX_BUFFER_SIZE ) {
+                buffer.insert( buffer.end(), line.begin(), line.end() );
                 buffer.push_back( '\n' );
             } else {
                 LoggerFactory::getLogger().error("Output buffer is full, command ignored.");
@@ -154,6 +217,22 @@ void TCPClient::sendCommand( const DebuggerCommand &cmd ) {
     }
 }
 
+void TCPClient::requestBinaryFraming( bool compress ) {
+    if( _framing != FRAMING_TEXT ) {
+        return;
+    }
+    if( compress && !Inflater::isSupported() ) {
+        LoggerFactory::getLogger().error("Compression is not supported, using plain binary frames.");
+        compress = false;
+    }
+    // The request is sent before any queued command.
+    string request = compress ? JSR_FRAME_PROTOCOL_BINARY_DEFLATE : JSR_FRAME_PROTOCOL_BINARY;
+    request += '\n';
+    vector<int8_t> &buffer = getProducerBuffer();
+    buffer.insert( buffer.end(), request.begin(), request.end() );
+    _framing = FRAMING_NEGOTIATING;
+}
+
 void TCPClient::setEventHandler( IEventHandler *eventHandler ) {
     _eventHandler = eventHandler;
 }
@@ -197,6 +276,47 @@ int TCPClient::Connect( const std::string host, int port, TCPClient **client ) {
         return JDB_ERROR_CANNOT_CONNECT;
     }
 
+    return CreateClient( socket, client );
+}
+
+int TCPClient::ConnectUnix( const std::string path, TCPClient **client ) {
+
+    Logger &log = LoggerFactory::getLogger();
+
+    int socket;
+
+    struct sockaddr_un address;
+
+    if( path.size() >= sizeof( address.sun_path ) ) {
+        log.error("Socket path is too long: %s", path.c_str());
+        errno = ENAMETOOLONG;
+        return JDB_ERROR_CANNOT_CONNECT;
+    }
+
+    if( ( socket = ::socket( AF_UNIX, SOCK_STREAM, 0 ) ) == -1 ) {
+        log.error("Cannot create client socket: %d", errno);
+        return JDB_ERROR_CANNOT_CREATE_SOCKET;
+    }
+
+    ::memset( &address, 0, sizeof( address ) );
+    address.sun_family = AF_UNIX;
+    ::strncpy( address.sun_path, path.c_str(), sizeof( address.sun_path ) - 1 );
+
+    if( ::connect( socket, (struct sockaddr *)&address, sizeof( address ) ) < 0 ) {
+        int error = errno;
+        ::close( socket );
+        log.error("Cannot connect to the debugger: %d", error);
+        errno = error;
+        return JDB_ERROR_CANNOT_CONNECT;
+    }
+
+    return CreateClient( socket, client );
+}
+
+int TCPClient::CreateClient( int socket, TCPClient **client ) {
+
+    Logger &log = LoggerFactory::getLogger();
+
     // Set socket to nonblocking.
     int flags;
     if ( ( ( flags = ::fcntl( socket, F_GETFL, 0 ) ) < 0)
@@ -25,6 +25,7 @@
 
 #include "fsevents.hpp"
 #include "debugger.hpp"
+#include <compression.hpp>
 
 class ClientDisconnectedEvent : public IEvent {
 public:
@@ -73,6 +74,15 @@ public:
     // TCPClient
     void sendCommand( const DebuggerCommand &cmd );
 
+    /**
+     * Asks the debugger to switch the connection to the length-prefixed
+     * binary framing. Outgoing commands are held until the debugger
+     * confirms the switch.
+     * @param compress Asks for compression of incoming frames. Debugger
+     *                 is allowed to refuse it.
+     */
+    void requestBinaryFraming( bool compress );
+
     /**
      * Connects to the debugger. It allocated a new client object after connection.
      * If anything failed, internal error code is returned. Anyway every returned
@@ -85,13 +95,36 @@ public:
      */
     static int Connect( const std::string host, int port, TCPClient **client );
 
+    /**
+     * Connects to the debugger listening at a Unix domain socket.
+     * @param path Socket path.
+     * @param[out] client Client connected to the debugger.
+     * @return Internal error code.
+     */
+    static int ConnectUnix( const std::string path, TCPClient **client );
+
+private:
+    /**
+     * Makes the connected socket a nonblocking one and creates the client.
+     */
+    static int CreateClient( int socket, TCPClient **client );
+
 private:
+    enum Framing {
+        FRAMING_TEXT,
+        FRAMING_NEGOTIATING,
+        FRAMING_BINARY
+    };
     // Outgoing commands.
     std::queue<DebuggerCommand> _outgoingCommands;
     // TCP socket.
     int _socket;
     // Handles incoming commands.
     IEventHandler *_eventHandler;
+    // Current framing of the connection.
+    Framing _framing;
+    // Decompresses frames if debugger agreed to compress them.
+    Utils::Inflater _inflater;
 };
 
 #endif /* SRC_TCP_CLIENT_HPP_ */
@@ -43,6 +43,8 @@
 #define JSR_ERROR_DEBUGGER_NOT_INSTALLED                20
 #define JSR_ERROR_DEBUGGER_ALREADY_STARTED              21
 #define JSR_ERROR_DEBUGGER_NOT_STARTED                  22
+#define JSR_ERROR_POLLER_FAILED                         23
+#define JSR_ERROR_TOO_MANY_CLIENTS                      24
 
 #define JSR_ERROR_SM_CANNOT_CREATE_GLOBAL_OBJECT        100
 #define JSR_ERROR_SM_CANNOT_WRAP_OBJECT                 101
@@ -90,10 +92,17 @@ public:
     // to use one-based source code lines.
     JSDbgEngineOptions &setSourceCodeDisplacement( int displacement );
     int getSourceCodeDisplacement() const;
+    // Compiles the debugger scripts once per process and shares their
+    // bytecode between all the contexts the debugger is installed into.
+    // Shared scripts are compiled without compile-and-go optimizations,
+    // so it pays off only if there are many contexts.
+    JSDbgEngineOptions &shareCompiledScripts();
+    bool isShareCompiledScripts() const;
 private:
     bool _suspended;
     bool _continue;
     int _displacement;
+    bool _shareScripts;
 };
 
 // Describes state change hint. When command is
@@ -56,6 +56,14 @@ public:
 #define JSR_DEFAULT_TCP_PORT 8089
 #define JSR_DEFAULT_TCP_BINDING_IP ""
 #define JSR_DEFAULT_TCP_BUFFER_SIZE (1024 * 1024 * 50)
+#define JSR_DEFAULT_COMPRESSION_THRESHOLD 1024
+#define JSR_DEFAULT_UNIX_SOCKET_PATH "/tmp/jsrdbg.sock"
+#define JSR_DEFAULT_UNIX_SOCKET_MODE 0600
+#define JSR_DEFAULT_MAX_CLIENTS 8
+#define JSR_DEFAULT_SLOW_CLIENT_POLICY JSRemoteDebuggerCfg::SLOW_CLIENT_DISCONNECT
+#define JSR_DEFAULT_SLOW_CLIENT_TIMEOUT 5000
+#define JSR_DEFAULT_EVENT_OVERFLOW_POLICY JSRemoteDebuggerCfg::OVERFLOW_DROP_OLDEST
+#define JSR_DEFAULT_BULK_OVERFLOW_POLICY JSRemoteDebuggerCfg::OVERFLOW_DROP_OLDEST
 
 /**
  * Debugger configuration.
@@ -66,7 +74,34 @@ public:
     /* Type of the protocol used to connect with a debugger. */
     enum JSRProtocolType {
         /* Ordinal TCP/IP v4. */
-        PROTOCOL_TCP_IP
+        PROTOCOL_TCP_IP,
+        /* Unix domain socket, available only on Unix like systems. */
+        PROTOCOL_UNIX_SOCKET
+    };
+
+    /* What to do with a command if the client's queue is full. */
+    enum JSRSlowClientPolicy {
+        /* Wait for the free space, but no longer than the timeout. The
+         * command is dropped after the timeout. */
+        SLOW_CLIENT_WAIT,
+        /* Drop the command at once. */
+        SLOW_CLIENT_DROP,
+        /* Wait for the free space, but no longer than the timeout. The
+         * client is disconnected after the timeout. */
+        SLOW_CLIENT_DISCONNECT
+    };
+
+    /* What to do with an asynchronous command if the client's queue is full.
+     * Such commands never wait for the free space. */
+    enum JSROverflowPolicy {
+        /* Drop the oldest command of the same class. */
+        OVERFLOW_DROP_OLDEST,
+        /* Replace a queued event which describes the whole state the same
+         * way (e.g. an older 'paused' or 'contexts_list' event) or drop the
+         * oldest command if there is none. */
+        OVERFLOW_COALESCE,
+        /* Disconnect the client. */
+        OVERFLOW_DISCONNECT
     };
 
     /**
@@ -130,7 +165,30 @@ public:
      */
     void setTcpPort(int tcpPort);
     /**
-     * Gets used protocol. Currently only TCP is supported.
+     * Gets path of the Unix domain socket the server should listen at.
+     * Used only by PROTOCOL_UNIX_SOCKET.
+     * @return Socket path.
+     */
+    const std::string& getUnixSocketPath() const;
+    /**
+     * Sets path of the Unix domain socket. Stale socket left at this
+     * path by a previous instance is removed before binding.
+     * @param path Socket path.
+     */
+    void setUnixSocketPath(const char *path);
+    /**
+     * Gets permissions of the Unix domain socket file.
+     * @return Permissions, 0600 by default.
+     */
+    int getUnixSocketMode() const;
+    /**
+     * Sets permissions of the Unix domain socket file, which
+     * control who is able to connect to the debugger.
+     * @param mode Permissions.
+     */
+    void setUnixSocketMode(int mode);
+    /**
+     * Gets used protocol.
      * @return Protocol.
      */
     JSRProtocolType getProtocol() const;
@@ -149,6 +207,78 @@ public:
      * @param scriptLoader Script's loader.
      */
     void setScriptLoader(IJSScriptLoader *scriptLoader);
+    /**
+     * Gets maximum number of clients which can be connected to the
+     * debugger at the same time. Connections exceeding this limit
+     * are closed just after they are accepted.
+     * @return Maximum number of clients, 0 means no limit.
+     */
+    int getMaxClients() const;
+    /**
+     * Sets maximum number of simultaneously connected clients.
+     * @param maxClients Maximum number of clients, 0 means no limit.
+     */
+    void setMaxClients(int maxClients);
+    /**
+     * Gets minimal size of the command which is compressed before it's
+     * sent. Compression is used only if the client asks for it.
+     * @return Size in bytes, 1KB by default.
+     */
+    size_t getCompressionThreshold() const;
+    /**
+     * Sets minimal size of the compressed command.
+     * @param threshold Size in bytes.
+     */
+    void setCompressionThreshold(size_t threshold);
+    /**
+     * Gets policy used when a command cannot be sent to the client,
+     * because it doesn't read previous commands fast enough. Commands
+     * are sent by the JS engine thread, so this is what protects the
+     * application from being blocked by a stalled client.
+     * @return Policy, SLOW_CLIENT_DISCONNECT by default.
+     */
+    JSRSlowClientPolicy getSlowClientPolicy() const;
+    /**
+     * Sets policy for slow clients.
+     * @param policy Policy.
+     */
+    void setSlowClientPolicy(JSRSlowClientPolicy policy);
+    /**
+     * Gets maximum time the JS engine thread waits for a slow client.
+     * @return Timeout in milliseconds, 5s by default.
+     */
+    int getSlowClientTimeout() const;
+    /**
+     * Sets maximum time the JS engine thread waits for a slow client.
+     * @param timeout Timeout in milliseconds. Negative value means no
+     *                limit, which is safe only if the client is trusted.
+     */
+    void setSlowClientTimeout(int timeout);
+    /**
+     * Gets policy used for broadcasted events (e.g. 'paused' or
+     * 'breakpoint_set') which cannot be queued, because the client
+     * doesn't read previous commands or hasn't granted enough credit.
+     * The slow client policy above applies to all the commands
+     * addressed to a concrete client.
+     * @return Policy, OVERFLOW_DROP_OLDEST by default.
+     */
+    JSROverflowPolicy getEventOverflowPolicy() const;
+    /**
+     * Sets overflow policy for broadcasted events.
+     * @param policy Policy.
+     */
+    void setEventOverflowPolicy(JSROverflowPolicy policy);
+    /**
+     * Gets overflow policy used for broadcasted bulk transfers, which
+     * are broadcasted commands of 64KB or bigger.
+     * @return Policy, OVERFLOW_DROP_OLDEST by default.
+     */
+    JSROverflowPolicy getBulkOverflowPolicy() const;
+    /**
+     * Sets overflow policy for bulk transfers.
+     * @param policy Policy.
+     */
+    void setBulkOverflowPolicy(JSROverflowPolicy policy);
 private:
     // IP address/Host we should listen on.
     std::string _tcpHost;
@@ -160,8 +290,31 @@ private:
     JSRProtocolType _protocol;
     // Component responsible for providing scripts source code.
     IJSScriptLoader *_scriptLoader;
+    // Maximum number of connected clients.
+    int _maxClients;
+    // Commands smaller than this are not compressed.
+    size_t _compressionThreshold;
+    // Unix domain socket path and its permissions.
+    std::string _unixSocketPath;
+    int _unixSocketMode;
+    // Handling of clients which do not read their commands.
+    JSRSlowClientPolicy _slowClientPolicy;
+    int _slowClientTimeout;
+    // Handling of asynchronous commands which cannot be queued.
+    JSROverflowPolicy _eventOverflowPolicy;
+    JSROverflowPolicy _bulkOverflowPolicy;
 };
 
+/**
+ * Handle which can be waited for by the host's event loop: a file
+ * descriptor on POSIX systems and an event HANDLE on Windows.
+ */
+#ifdef _WIN32
+typedef void* JSRPollHandle;
+#else
+typedef int JSRPollHandle;
+#endif
+
 /**
  * Base interface for debugger implementation. Destined
  * for internal use only.
@@ -177,6 +330,7 @@ public:
     virtual int stop() = 0;
     virtual int interrupt( JSContext *ctx ) = 0;
     virtual int handlePendingCommands( JSContext *ctx ) = 0;
+    virtual int getPollHandle( JSContext *ctx, JSRPollHandle &handle ) = 0;
     virtual int removeDebuggee( JSContext *ctx, JS::HandleObject debuggee ) = 0;
     virtual int addDebuggee( JSContext *ctx, JS::HandleObject debuggee ) = 0;
 };
@@ -225,10 +379,23 @@ public:
      * @return Error code.
      */
     virtual int handlePendingCommands( JSContext *ctx );
+    /**
+     * Gets handle which becomes readable (signaled on Windows) exactly when
+     * there are pending commands for the context, so it can be added to the
+     * application's own event loop (epoll, libuv etc.) and handlePendingCommands
+     * called only when it's needed. The handle is owned by the debugger, it's
+     * valid until the debugger is uninstalled and it must not be read from.
+     *
+     * @param ctx JSContext handling the debuggee.
+     * @param handle Output parameter for the handle.
+     * @return Error code.
+     */
+    virtual int getPollHandle( JSContext *ctx, JSRPollHandle &handle );
     /**
      * Starts a debugger instance.
      * This method have to be called from the JS engine thread.
-     * Starts a new thread in the background if protocol is PROTOCOL_TCP_IP.
+     * Starts a new thread in the background for PROTOCOL_TCP_IP and
+     * PROTOCOL_UNIX_SOCKET.
      * @return Error code.
      */
     virtual int start();
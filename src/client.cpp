@@ -20,10 +20,12 @@
 #include "client.hpp"
 
 #include <vector>
+#include <string.h>
 #include <map>
 #include <string>
 
 #include <jsrdbg.h>
+#include <json_reader.hpp>
 
 using namespace JSR;
 using namespace Utils;
@@ -45,27 +47,48 @@ int ClientEvent::getID() const {
 
 /* Command. */
 
+// Body of commands created without any content.
+static const std::string EMPTY_COMMAND;
+
 Command::Command()
     : _clientId(0),
-      _contextId(0) {
+      _contextId(0),
+      _priority(PRIORITY_RESPONSE) {
 }
 
 Command::Command( int clientId, int engineId, const std::string &command )
-    : _command( command ),
+    : _command( std::make_shared<const std::string>( command ) ),
+      _clientId( clientId ),
+      _contextId( engineId ){
+    guessPriority();
+}
+
+Command::Command( int clientId, int engineId, std::string &&command )
+    : _command( std::make_shared<const std::string>( std::move( command ) ) ),
       _clientId( clientId ),
       _contextId( engineId ){
+    guessPriority();
 }
 
 Command::Command( int clientId, int engineId, char *buffer, int offset, size_t size )
-    : _command( buffer, offset, size ),
+    : _command( std::make_shared<const std::string>( buffer, offset, size ) ),
       _clientId( clientId ),
       _contextId( engineId ) {
+    guessPriority();
 }
 
 Command::Command( const Command &command )
     : _command(command._command),
       _clientId(command._clientId),
-      _contextId(command._contextId) {
+      _contextId(command._contextId),
+      _priority(command._priority) {
+}
+
+Command::Command( Command &&command )
+    : _command( std::move( command._command ) ),
+      _clientId( command._clientId ),
+      _contextId( command._contextId ),
+      _priority( command._priority ) {
 }
 
 Command& Command::operator=( const Command &command ) {
@@ -73,6 +96,17 @@ Command& Command::operator=( const Command &command ) {
         _command = command._command;
         _clientId = command._clientId;
         _contextId = command._contextId;
+        _priority = command._priority;
+    }
+    return *this;
+}
+
+Command& Command::operator=( Command &&command ) {
+    if (this != &command) {
+        _command = std::move( command._command );
+        _clientId = command._clientId;
+        _contextId = command._contextId;
+        _priority = command._priority;
     }
     return *this;
 }
@@ -89,15 +123,79 @@ int Command::getContextId() const {
 }
 
 const std::string& Command::getValue() const {
-    return _command;
+    return _command ? *_command : EMPTY_COMMAND;
+}
+
+Command::Priority Command::getPriority() const {
+    return _priority;
+}
+
+void Command::setPriority( Priority priority ) {
+    _priority = priority;
+}
+
+// Events which carry the whole state, so only the newest one matters. Other
+// events (e.g. 'breakpoint_set') describe a single change and can never be
+// coalesced, because the client would lose the state.
+static const char *const COALESCED_EVENTS[] = {
+    "contexts_list",
+    "breakpoints_list",
+    "paused",
+    "pc",
+    nullptr
+};
+
+bool Command::getCoalescingKind( std::string &kind ) const {
+    JSONReader reader;
+    JSONValue root;
+    if( !reader.parse( getValue(), root ) || !root.isObject() ) {
+        return false;
+    }
+    const JSONValue *type = root.find( "type" );
+    const JSONValue *subtype = root.find( "subtype" );
+    if( !type || !type->isString() || type->getString() != "info" || !subtype || !subtype->isString() ) {
+        return false;
+    }
+    for( const char *const *event = COALESCED_EVENTS; *event; event++ ) {
+        if( subtype->getString() == *event ) {
+            kind = *event;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Command::isCoalescedBy( const Command &command, const std::string &kind ) const {
+    if( _contextId != command._contextId || _priority != command._priority ) {
+        return false;
+    }
+    // Commands which do not even mention the kind are not parsed at all.
+    std::string queuedKind;
+    return getValue().find( kind ) != std::string::npos && getCoalescingKind( queuedKind ) && queuedKind == kind;
+}
+
+void Command::guessPriority() {
+    // Responses to the client's own requests are never moved behind
+    // the events, no matter how big they are. Bulk transfers of sources
+    // are marked explicitly by the senders.
+    if( _clientId != BROADCAST ) {
+        _priority = PRIORITY_RESPONSE;
+    } else if( _command->size() >= JSR_BULK_COMMAND_SIZE ) {
+        _priority = PRIORITY_BULK;
+    } else {
+        _priority = PRIORITY_EVENT;
+    }
 }
 
 /* Client. */
 
 Client::Client( int id ) :
         _inCommands(MAX_CLIENT_QUEUE_LENGTH),
-        _outCommands(MAX_CLIENT_QUEUE_LENGTH),
-        _clientID(id) {
+        _outCommands(MAX_CLIENT_QUEUE_LENGTH, Command::PRIORITIES),
+        _clientID(id),
+        _droppedCount(0),
+        _coalescedCount(0),
+        _slot(nullptr) {
 }
 
 Client::~Client() {
@@ -114,7 +212,7 @@ int Client::getID() const {
     return _clientID;
 }
 
-BlockingQueue<Command>& Client::getInQueue() {
+command_in_queue& Client::getInQueue() {
     return _inCommands;
 }
 
@@ -122,13 +220,48 @@ BlockingQueue<Command>& Client::getOutQueue() {
     return _outCommands;
 }
 
+int Client::getDroppedCount() const {
+    return _droppedCount.load();
+}
+
+int Client::getCoalescedCount() const {
+    return _coalescedCount.load();
+}
+
+void Client::recordDropped() {
+    _droppedCount++;
+}
+
+void Client::recordCoalesced() {
+    _coalescedCount++;
+}
+
 /* Client's manager */
 
-ClientManager::ClientManager()
-    : _log(LoggerFactory::getLogger()) {
+ClientManager::ClientManager( int maxClients, JSRemoteDebuggerCfg::JSRSlowClientPolicy slowClientPolicy, int slowClientTimeout )
+    : _log(LoggerFactory::getLogger()),
+      _clientsCount(0),
+      _markedCount(0),
+      _maxClients(maxClients),
+      _slowClientPolicy(slowClientPolicy),
+      _slowClientTimeout(slowClientTimeout),
+      _droppedCount(0),
+      _coalescedCount(0) {
+    for( int i = 0; i < Command::PRIORITIES; i++ ) {
+        _overflowPolicies[i] = JSRemoteDebuggerCfg::OVERFLOW_DROP_OLDEST;
+    }
+    _overflowPolicies[Command::PRIORITY_EVENT] = JSR_DEFAULT_EVENT_OVERFLOW_POLICY;
+    _overflowPolicies[Command::PRIORITY_BULK] = JSR_DEFAULT_BULK_OVERFLOW_POLICY;
 }
 
 ClientManager::~ClientManager() {
+    // Clients are disposed by 'stop', only the table is freed here.
+    ClientSlotChunk *chunk = _slots.next.load();
+    while( chunk ) {
+        ClientSlotChunk *next = chunk->next.load();
+        delete chunk;
+        chunk = next;
+    }
 }
 
 void ClientManager::start() {
@@ -140,37 +273,164 @@ int ClientManager::addClient( Client *client ) {
         return JSR_ERROR_ILLEGAL_ARGUMENT;
     }
 
+    int clientId = client->getID();
+    bool replaced = false;
+
     {
         MutexLock lock( _mutex );
-        _clients.insert( std::pair<int,ClientWrapper>( client->getID(), ClientWrapper( client ) ) );
+
+        ClientSlot *freeSlot = nullptr;
+        ClientSlotChunk *last = nullptr;
+
+        for( ClientSlotChunk *chunk = &_slots; chunk; chunk = chunk->next.load() ) {
+            for( int i = 0; i < SLOT_CHUNK_SIZE; i++ ) {
+                ClientSlot &slot = chunk->slots[i];
+                unsigned int state = slot.state.load( std::memory_order_acquire );
+                if( !( state & SLOT_USED ) ) {
+                    if( !freeSlot ) {
+                        freeSlot = &slot;
+                    }
+                } else if( slot.id.load( std::memory_order_relaxed ) == clientId ) {
+                    // Identifiers can be reused (e.g. socket descriptors), so there might be
+                    // a client with the same ID which is waiting for the periodic cleanup.
+                    if( !( state & SLOT_REMOVED ) ) {
+                        _log.error( "Client with id: %d already exists.", clientId );
+                        return JSR_ERROR_ILLEGAL_ARGUMENT;
+                    }
+                    // Removed slots cannot be acquired by ID anymore, so if the old client
+                    // is still in use, it's just left for the periodic cleanup and the new
+                    // one takes another slot.
+                    if( tryFreeSlot( slot ) ) {
+                        replaced = true;
+                        if( !freeSlot ) {
+                            freeSlot = &slot;
+                        }
+                    }
+                }
+            }
+            last = chunk;
+        }
+
+        // Clients marked to be removed are already disconnected.
+        if( _maxClients > 0 && _clientsCount.load() - _markedCount.load() >= _maxClients ) {
+            return JSR_ERROR_TOO_MANY_CLIENTS;
+        }
+
+        if( !freeSlot ) {
+            ClientSlotChunk *chunk = new ClientSlotChunk();
+            freeSlot = &chunk->slots[0];
+            last->next.store( chunk, std::memory_order_release );
+        }
+
+        // Client becomes visible for readers together with the state.
+        client->_slot = freeSlot;
+        freeSlot->client.store( client, std::memory_order_relaxed );
+        freeSlot->id.store( clientId, std::memory_order_relaxed );
+        freeSlot->state.store( SLOT_USED, std::memory_order_release );
+        _clientsCount++;
+    }
+
+    if( replaced ) {
+        ClientEvent event(EVENT_CODE_CLIENT_REMOVED, clientId);
+        fire(event);
     }
 
-    ClientEvent event(EVENT_CODE_CLIENT_ADDED, client->getID());
+    ClientEvent event(EVENT_CODE_CLIENT_ADDED, clientId);
     fire(event);
     return JSR_ERROR_NO_ERROR;
 }
 
+void ClientManager::setOverflowPolicy( Command::Priority priority, JSRemoteDebuggerCfg::JSROverflowPolicy policy ) {
+    _overflowPolicies[priority] = policy;
+}
+
 void ClientManager::broadcast( Command &command ) {
-    vector<int> ids;
-    // Collect all clients identificators.
+    // Every client is protected from removing only while the
+    // command is added to its queue. No lock is needed.
+    for( ClientSlotChunk *chunk = &_slots; chunk; chunk = chunk->next.load( std::memory_order_acquire ) ) {
+        for( int i = 0; i < SLOT_CHUNK_SIZE; i++ ) {
+            ClientSlot &slot = chunk->slots[i];
+            // Clients which are going to be removed are ignored.
+            Client *client = acquireSlot( slot );
+            if( client ) {
+                deliverAsync( *client, command );
+                releaseSlot( slot );
+            }
+        }
+    }
+}
 
-    {
-        MutexLock lock( _mutex );
+void ClientManager::recordDropped( Client &client ) {
+    client.recordDropped();
+    _droppedCount++;
+    if( client.getDroppedCount() == 1 ) {
+        // Just the first one, it could flood the log otherwise.
+        _log.warn( "Client %d cannot keep up, asynchronous commands are being dropped.", client.getID() );
+    }
+}
 
-        for( map<int,ClientWrapper>::iterator it = _clients.begin(); it != _clients.end(); it++ ) {
-            ids.push_back(it->first);
+// Commands which cannot be added are left untouched by the queue,
+// so they can be forwarded more than once here.
+template<typename C>
+bool ClientManager::deliverAsync( Client &client, C &&command ) {
+    BlockingQueue<Command> &queue = client.getOutQueue();
+    if( queue.add( std::forward<C>( command ) ) ) {
+        return true;
+    }
+    switch( _overflowPolicies[command.getPriority()] ) {
+    case JSRemoteDebuggerCfg::OVERFLOW_DISCONNECT:
+        _log.warn( "Queue of client %d is full, disconnecting.", client.getID() );
+        client.disconnect();
+        recordDropped( client );
+        return false;
+    case JSRemoteDebuggerCfg::OVERFLOW_COALESCE: {
+        Command event( command );
+        std::string kind;
+        if( event.getCoalescingKind( kind ) &&
+                queue.replace( std::forward<C>( command ), [&event, &kind]( const Command &queued ) { return queued.isCoalescedBy( event, kind ); } ) ) {
+            client.recordCoalesced();
+            _coalescedCount++;
+            return true;
         }
+        // Nothing to replace, so just make some room.
+        return deliverDroppingOldest( client, std::forward<C>( command ) );
+    }
+    default:
+        return deliverDroppingOldest( client, std::forward<C>( command ) );
     }
+}
 
-    // Now having all identificators collected, try to send commands to clients
-    // that are in conjunction with these identificators.
-    for( vector<int>::iterator it = ids.begin(); it != ids.end(); it++ ) {
-        ClientPtrHolder<Client> client( *this, *it );
-        // Ignore clients that have been removed in this time window.
-        if( client ) {
-            client->getOutQueue().add( command );
+template<typename C>
+bool ClientManager::deliverDroppingOldest( Client &client, C &&command ) {
+    // Fails if the queue is full of commands of other priorities.
+    bool dropped;
+    bool added = client.getOutQueue().addDroppingOldest( std::forward<C>( command ), dropped );
+    if( dropped || !added ) {
+        recordDropped( client );
+    }
+    return added;
+}
+
+template<typename C>
+bool ClientManager::deliver( Client &client, C &&command ) {
+    // Overflow policies apply only to the broadcasted commands, the client
+    // waits for every single response addressed to it, bulk ones included.
+    BlockingQueue<Command> &queue = client.getOutQueue();
+    if( _slowClientPolicy == JSRemoteDebuggerCfg::SLOW_CLIENT_DROP ) {
+        if( !queue.add( std::forward<C>( command ) ) ) {
+            _log.warn( "Queue of client %d is full, command dropped.", client.getID() );
+            return false;
+        }
+    } else if( !queue.push( std::forward<C>( command ), _slowClientTimeout ) ) {
+        if( _slowClientPolicy == JSRemoteDebuggerCfg::SLOW_CLIENT_DISCONNECT ) {
+            _log.warn( "Client %d doesn't read its commands, disconnecting.", client.getID() );
+            client.disconnect();
+        } else {
+            _log.warn( "Client %d doesn't read its commands, command dropped.", client.getID() );
         }
+        return false;
     }
+    return true;
 }
 
 bool ClientManager::sendCommand( Command &command ) {
@@ -180,7 +440,22 @@ bool ClientManager::sendCommand( Command &command ) {
     } else {
         ClientPtrHolder<Client> client( *this, command.getClientId() );
         if( client ) {
-            client->getOutQueue().push( command );
+            result = deliver( *client, command );
+        } else {
+            result = false;
+        }
+    }
+    return result;
+}
+
+bool ClientManager::sendCommand( Command &&command ) {
+    bool result = true;
+    if( command.getClientId() == Command::BROADCAST ) {
+        broadcast( command );
+    } else {
+        ClientPtrHolder<Client> client( *this, command.getClientId() );
+        if( client ) {
+            result = deliver( *client, std::move( command ) );
         } else {
             result = false;
         }
@@ -188,14 +463,32 @@ bool ClientManager::sendCommand( Command &command ) {
     return result;
 }
 
+bool ClientManager::trySendCommand( Command &&command ) {
+    if( command.getClientId() == Command::BROADCAST ) {
+        return false;
+    }
+    ClientPtrHolder<Client> client( *this, command.getClientId() );
+    return client && client->getOutQueue().add( std::move( command ) );
+}
+
 void ClientManager::removeClient( Client *client ) {
     if( !client ) {
         _log.error( "Cannot remove NULL client." );
         return;
     }
-    int clientId = 0;
+    int clientId = client->getID();
     int eventCode = 0;
-    tryRemoveClient( client, eventCode );
+    if( client->getDroppedCount() || client->getCoalescedCount() ) {
+        _log.info( "Client %d: %d commands dropped, %d coalesced.", clientId,
+                client->getDroppedCount(), client->getCoalescedCount() );
+    }
+    {
+        MutexLock lock( _mutex );
+        ClientSlot *slot = findSlot( client );
+        if( slot ) {
+            tryRemoveSlot( *slot, eventCode );
+        }
+    }
     // Events cannot be fired inside the critical section
     // just because they might be blocked by actions which use
     // client manager from different threads, so it could
@@ -206,39 +499,78 @@ void ClientManager::removeClient( Client *client ) {
     }
 }
 
-bool ClientManager::tryRemoveClient(Client *client, int &eventCode) {
-    // Only this block should be synchronized.
-    MutexLock lock( _mutex );
-    int clientId = client->getID();
-    bool remove = false;
-    // Remove the client if it exists.
-    std::map<int,ClientWrapper>::iterator it = _clients.find( clientId );
-    if( it != _clients.end() ) {
-        ClientWrapper &wrapper = it->second;
-        if( !wrapper.isMarkedToRemove() ) {
-            if( wrapper.isRemovable() ) {
-                remove = true;
-            } else {
-                wrapper.markRemove();
-                eventCode = EVENT_CODE_CLIENT_MARKED_TO_REMOVE;
-            }
-        } else if ( wrapper.isRemovable() ) {
-            remove = true;
-        }
-        if( remove ) {
-            wrapper.deleteClient();
-            _clients.erase( it );
-            eventCode = EVENT_CODE_CLIENT_REMOVED;
+bool ClientManager::tryRemoveSlot( ClientSlot &slot, int &eventCode ) {
+    // New references cannot be taken from now on.
+    unsigned int state = slot.state.fetch_or( SLOT_REMOVED, std::memory_order_acq_rel );
+    if( !( state & SLOT_REMOVED ) ) {
+        _markedCount++;
+    }
+    if( tryFreeSlot( slot ) ) {
+        eventCode = EVENT_CODE_CLIENT_REMOVED;
+        return true;
+    }
+    if( !( state & SLOT_REMOVED ) ) {
+        eventCode = EVENT_CODE_CLIENT_MARKED_TO_REMOVE;
+    }
+    return false;
+}
+
+bool ClientManager::tryFreeSlot( ClientSlot &slot ) {
+    // Counter cannot grow once the slot is marked, so if it's
+    // zero now, nobody is going to use the client anymore.
+    if( slot.state.load( std::memory_order_acquire ) != ( SLOT_USED | SLOT_REMOVED ) ) {
+        return false;
+    }
+    delete slot.client.load( std::memory_order_relaxed );
+    slot.client.store( nullptr, std::memory_order_relaxed );
+    slot.state.store( 0, std::memory_order_release );
+    _clientsCount--;
+    _markedCount--;
+    return true;
+}
+
+ClientSlot* ClientManager::findSlot( Client *client ) {
+    // Slot is not changed as long as the client is in the table.
+    ClientSlot *slot = client->_slot;
+    if( slot && slot->client.load( std::memory_order_relaxed ) == client &&
+            ( slot->state.load( std::memory_order_acquire ) & SLOT_USED ) ) {
+        return slot;
+    }
+    return nullptr;
+}
+
+Client* ClientManager::acquireSlot( ClientSlot &slot ) {
+    unsigned int state = slot.state.load( std::memory_order_relaxed );
+    while( ( state & SLOT_USED ) && !( state & SLOT_REMOVED ) ) {
+        if( slot.state.compare_exchange_weak( state, state + 1,
+                std::memory_order_acquire, std::memory_order_relaxed ) ) {
+            return slot.client.load( std::memory_order_relaxed );
         }
     }
-    return remove;
+    return nullptr;
+}
+
+void ClientManager::releaseSlot( ClientSlot &slot ) {
+    // Slot marked to be removed is freed by the periodic cleanup.
+    slot.state.fetch_sub( 1, std::memory_order_release );
 }
 
 Client* ClientManager::getClient( int id ) {
-    MutexLock lock( _mutex );
-    std::map<int,ClientWrapper>::iterator it = _clients.find( id );
-    if( it != _clients.end() ) {
-        return it->second.getClient();
+    for( ClientSlotChunk *chunk = &_slots; chunk; chunk = chunk->next.load( std::memory_order_acquire ) ) {
+        for( int i = 0; i < SLOT_CHUNK_SIZE; i++ ) {
+            ClientSlot &slot = chunk->slots[i];
+            if( slot.id.load( std::memory_order_relaxed ) != id ) {
+                continue;
+            }
+            Client *client = acquireSlot( slot );
+            if( client ) {
+                // Slot might have been reused before it was acquired.
+                if( slot.id.load( std::memory_order_relaxed ) == id ) {
+                    return client;
+                }
+                releaseSlot( slot );
+            }
+        }
     }
     return nullptr;
 }
@@ -248,16 +580,22 @@ void ClientManager::returnClient( Client *client ) {
         _log.error( "Cannot return NULL client." );
         return;
     }
-    MutexLock lock( _mutex );
-    std::map<int,ClientWrapper>::iterator it = _clients.find( client->getID() );
-    if( it != _clients.end() ) {
-        it->second.returnClient( client );
+    // Client cannot be moved to another slot as long as it's not returned.
+    ClientSlot *slot = findSlot( client );
+    if( slot ) {
+        releaseSlot( *slot );
     } else {
         _log.error( "Cannot return client with id: %d, because it doesn't exist in the manager.", client->getID() );
     }
 }
 
 void ClientManager::periodicCleanup() {
+    // It's called by the protocol on every loop, so
+    // do not lock anything if there is nothing to do.
+    if( _markedCount.load() == 0 ) {
+        return;
+    }
+
     // Vector of clients that were removed.
     vector<int> removedClients;
 
@@ -265,17 +603,13 @@ void ClientManager::periodicCleanup() {
         MutexLock lock( _mutex );
 
         // Remove client's as soon as they can be removed.
-        map<int,ClientWrapper>::iterator it = _clients.begin();
-        while (it != _clients.end()) {
-            if (it->second.isMarkedToRemove() && it->second.isRemovable()) {
-                int clientId = it->second.getClient()->getID();
-                it->second.deleteClient();
-                map<int,ClientWrapper>::iterator toErase = it;
-                ++it;
-                _clients.erase(toErase);
-                removedClients.push_back(clientId);
-            } else {
-                ++it;
+        for( ClientSlotChunk *chunk = &_slots; chunk; chunk = chunk->next.load() ) {
+            for( int i = 0; i < SLOT_CHUNK_SIZE; i++ ) {
+                ClientSlot &slot = chunk->slots[i];
+                int clientId = slot.id.load( std::memory_order_relaxed );
+                if( tryFreeSlot( slot ) ) {
+                    removedClients.push_back( clientId );
+                }
             }
         }
     }
@@ -297,16 +631,19 @@ int ClientManager::stop() {
     {
         MutexLock lock( _mutex );
 
-        map<int,ClientWrapper> clients = _clients;
-        for( map<int,ClientWrapper>::iterator it = clients.begin(); it != clients.end(); it++ ) {
-            int eventCode;
-            Client *client = it->second.getClient();
-            int clientId = client->getID();
-            if( tryRemoveClient( client, eventCode ) ) {
-                removedClients.push_back( clientId );
+        for( ClientSlotChunk *chunk = &_slots; chunk; chunk = chunk->next.load() ) {
+            for( int i = 0; i < SLOT_CHUNK_SIZE; i++ ) {
+                ClientSlot &slot = chunk->slots[i];
+                if( slot.state.load( std::memory_order_acquire ) & SLOT_USED ) {
+                    int eventCode;
+                    int clientId = slot.id.load( std::memory_order_relaxed );
+                    if( tryRemoveSlot( slot, eventCode ) ) {
+                        removedClients.push_back( clientId );
+                    }
+                }
             }
         }
-        empty = _clients.empty();
+        empty = _clientsCount.load() == 0;
     }
 
     // Fire events about removed clients.
@@ -321,49 +658,23 @@ int ClientManager::stop() {
 }
 
 int ClientManager::getClientsCount() {
-    MutexLock lock( _mutex );
-    int clients = static_cast<int>(_clients.size());
-    return clients;
-}
-
-ClientManager::ClientWrapper::ClientWrapper(Client *client) {
-   this->client = client;
-   this->counter = 0;
-   this->removed = false;
-}
-
-ClientManager::ClientWrapper::ClientWrapper(const ClientWrapper &cpy) {
-   this->client = cpy.client;
-   this->counter = cpy.counter;
-   this->removed = cpy.removed;
-}
-
-Client* ClientManager::ClientWrapper::getClient() {
-    counter++;
-    return client;
-}
-
-void ClientManager::ClientWrapper::returnClient( Client *client ) {
-    counter--;
-}
-
-bool ClientManager::ClientWrapper::isConnected() {
-    return client && client->isConnected();
+    return _clientsCount.load();
 }
 
-bool ClientManager::ClientWrapper::isRemovable() {
-    return counter == 0;
+int ClientManager::getDroppedCount() const {
+    return _droppedCount.load();
 }
 
-void ClientManager::ClientWrapper::markRemove() {
-    removed = true;
+int ClientManager::getCoalescedCount() const {
+    return _coalescedCount.load();
 }
 
-bool ClientManager::ClientWrapper::isMarkedToRemove() {
-    return removed;
+ClientSlot::ClientSlot()
+    : client(nullptr),
+      id(-1),
+      state(0) {
 }
 
-void ClientManager::ClientWrapper::deleteClient() {
-    delete client;
-    client = nullptr;
+ClientManager::ClientSlotChunk::ClientSlotChunk()
+    : next(nullptr) {
 }
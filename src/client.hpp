@@ -22,13 +22,19 @@
 
 #include <string>
 #include <map>
+#include <memory>
+#include <atomic>
 #include <algorithm>
 
+#include <jsrdbg.h>
+
 #include <utils.hpp>
 #include <threads.hpp>
 #include <log.hpp>
 
 #define MAX_CLIENT_QUEUE_LENGTH 4096
+// Broadcasted commands of this size or bigger are treated as bulk transfers.
+#define JSR_BULK_COMMAND_SIZE   (64 * 1024)
 
 namespace JSR {
 
@@ -45,27 +51,78 @@ private:
 };
 
 /**
- * Represents one command.
+ * Represents one command. The command body is immutable and shared
+ * between all the copies of the command, so copying a command costs
+ * just a reference counter increment. It's what makes broadcasting
+ * cheap, every client gets a copy of the same body.
+ *
+ * Every command has also a priority which decides about the order in which
+ * outgoing commands are sent to the client. Responses are sent before the
+ * broadcasted events and both of them before the bulk transfers, so an
+ * interactive request is never stuck behind the asynchronous traffic.
+ * Commands addressed to a client are responses and big broadcasts are bulk
+ * transfers by default. Senders of sources mark them as bulk explicitly.
  */
 class Command {
 public:
     static const int BROADCAST = -1;
+    enum Priority {
+        PRIORITY_RESPONSE = 0,
+        PRIORITY_EVENT,
+        PRIORITY_BULK
+    };
+    static const int PRIORITIES = 3;
     Command();
     Command( int clientId, int contextId, const std::string &command );
+    /**
+     * Takes over the string, so the command body is never copied.
+     */
+    Command( int clientId, int contextId, std::string &&command );
     Command( int clientId, int contextId, char *buffer, int offset, size_t size );
     Command( const Command &command );
+    Command( Command &&command );
     Command& operator =( const Command &command );
+    Command& operator =( Command &&command );
     virtual ~Command();
     virtual const std::string& getValue() const;
     virtual int getClientId() const;
     virtual int getContextId() const;
+    Priority getPriority() const;
+    void setPriority( Priority priority );
+    /**
+     * Gets kind of the event if it describes the whole state of something
+     * (e.g. list of contexts), so an older event of the same kind can be
+     * replaced by the newer one if the client cannot keep up.
+     * @param kind Subtype of the event.
+     * @return False if the command can never be coalesced.
+     */
+    bool getCoalescingKind( std::string &kind ) const;
+    /**
+     * Returns true if the command can be replaced by an event of given
+     * kind, context and priority.
+     */
+    bool isCoalescedBy( const Command &command, const std::string &kind ) const;
 private:
-    std::string _command;
+    void guessPriority();
+    std::shared_ptr<const std::string> _command;
     int _clientId;
     int _contextId;
+    Priority _priority;
 };
 
+/**
+ * Puts commands into the output queue lanes according to their priorities.
+ */
+inline int getQueueLane( const Command &command ) {
+    return command.getPriority();
+}
+
 typedef Utils::BlockingQueue<Command> command_queue;
+// Incoming commands have exactly one producer and one consumer.
+typedef Utils::SPSCQueue<Command> command_in_queue;
+typedef Utils::QueueSignalHandler<Command, Utils::SPSCQueue> command_in_handler;
+
+struct ClientSlot;
 
 /**
  * Default implementation of the client class.
@@ -98,30 +155,77 @@ public:
      */
     virtual int getID() const;
     /**
-     * Gets input blocking queue.
+     * Gets input queue. Commands are put there by the protocol thread and
+     * taken by the signal handler of the queue.
      */
-    virtual Utils::BlockingQueue<Command>& getInQueue();
+    virtual command_in_queue& getInQueue();
     /**
      * Gets output blocking queue.
      */
     virtual Utils::BlockingQueue<Command>& getOutQueue();
+    /**
+     * Gets number of outgoing commands dropped by the overflow policies.
+     */
+    int getDroppedCount() const;
+    /**
+     * Gets number of outgoing commands replaced by newer ones of the same kind.
+     */
+    int getCoalescedCount() const;
+    /**
+     * Counters are updated by the client's manager while it's
+     * delivering commands.
+     */
+    void recordDropped();
+    void recordCoalesced();
 private:
     // Queue for input commands.
-    Utils::BlockingQueue<Command> _inCommands;
+    command_in_queue _inCommands;
     // Queue for output commands.
     Utils::BlockingQueue<Command> _outCommands;
     // Client's ID.
     int _clientID;
+    // Commands which haven't been delivered as they were.
+    std::atomic<int> _droppedCount;
+    std::atomic<int> _coalescedCount;
+    // Slot of the manager the client has been added to, so
+    // the client can be returned without searching the table.
+    ClientSlot *_slot;
+    friend class ClientManager;
+};
+
+/**
+ * One entry of the clients table of the ClientManager.
+ */
+struct ClientSlot {
+    ClientSlot();
+    std::atomic<Client*> client;
+    std::atomic<int> id;
+    // Reference counter combined with the SLOT_* flags of the manager.
+    std::atomic<unsigned int> state;
 };
 
 /**
  * Component responsible for managing all the client
  * used by the server. It's mainly responsible for
  * the disposing procedure.
+ *
+ * Clients are kept in a flat table of slots. Every slot has an atomic
+ * state consisting of a reference counter and flags, so clients can be
+ * got, returned and iterated over without any lock. Mutex is used only
+ * by operations changing the set of clients.
  */
 class ClientManager : public Utils::EventEmitter {
 public:
-    ClientManager();
+    /**
+     * Creates client's manager.
+     * @param maxClients Maximum number of clients, 0 means no limit.
+     * @param slowClientPolicy What to do if client's queue is full.
+     * @param slowClientTimeout Maximum time to wait for a slow client
+     *                          in milliseconds, negative means no limit.
+     */
+    explicit ClientManager( int maxClients = 0,
+            JSRemoteDebuggerCfg::JSRSlowClientPolicy slowClientPolicy = JSR_DEFAULT_SLOW_CLIENT_POLICY,
+            int slowClientTimeout = JSR_DEFAULT_SLOW_CLIENT_TIMEOUT );
     virtual ~ClientManager();
 public:
     /**
@@ -133,7 +237,8 @@ public:
      * just informing the manager that there is a client
      * that should be disposed later, when the manager is shut
      * down.
-     * @return Standard JSRDBG error code in case of critical exceptions.
+     * @return Standard JSRDBG error code in case of critical exceptions
+     *         or JSR_ERROR_TOO_MANY_CLIENTS if the limit of clients is reached.
      */
     virtual int addClient( Client *client );
     /**
@@ -143,21 +248,46 @@ public:
      * and freeing everything.
      */
     virtual void removeClient( Client *client );
+    /**
+     * Sets policy used for commands of given priority if the client's queue
+     * is full. Commands of PRIORITY_RESPONSE follow the slow client policy,
+     * unless they are broadcasted.
+     */
+    void setOverflowPolicy( Command::Priority priority, JSRemoteDebuggerCfg::JSROverflowPolicy policy );
     /**
      * Sends given command to all registered clients. This
      * is not blocking operation, so if there is no space left
-     * in a queue, client is silently ignored when broadcasting.
+     * in a queue, the overflow policy decides what happens.
      * @param command Command to send.
      */
     virtual void broadcast( Command &command );
     /**
      * Sends command to client or client if it's a broadcasting command.
-     * If command is destined for concrete client the operation is blocking
-     * if client's queue is full.
+     * If command is destined for concrete client and client's queue is full
+     * the operation blocks or not, depending on the slow client policy,
+     * but never longer than the configured timeout. Events and bulk
+     * transfers never block, they follow their overflow policies instead.
      * @param command Command to be send.
-     * @return True if command has been send successfully, or false otherwise (no client found).
+     * @return True if command has been send successfully, or false otherwise
+     *         (no client found or command dropped due to the slow client policy).
      */
     virtual bool sendCommand( Command &command );
+    /**
+     * Sends command the same way the version above does, but the command
+     * is moved into the client's queue, so its body is not copied. Command
+     * is still copied for every client if it's a broadcasting one.
+     * @param command Command to be send.
+     * @return True if command has been send successfully, or false otherwise (no client found).
+     */
+    virtual bool sendCommand( Command &&command );
+    /**
+     * Sends command to the client only if there is free space in its queue,
+     * so it never blocks nor drops anything. Broadcasting commands are
+     * not supported.
+     * @param command Command to be send, it's left untouched on failure.
+     * @return False if there is no such a client or its queue is full.
+     */
+    virtual bool trySendCommand( Command &&command );
     /**
      * Gets a client for given ID. This method increments
      * internal counter which is then used to prevent the
@@ -187,26 +317,87 @@ public:
      */
     virtual int getClientsCount();
     /**
-     * Applies the given function to every client.
+     * Gets number of commands dropped by the overflow policies
+     * since the manager has been created, for all the clients.
+     */
+    int getDroppedCount() const;
+    /**
+     * Gets number of coalesced commands for all the clients.
+     */
+    int getCoalescedCount() const;
+    /**
+     * Applies the given function to every client which is
+     * not marked to be removed.
      */
     template <typename Function> void forEach(Function func) {
-        Utils::MutexLock lock(_mutex);
-        std::for_each(begin(_clients), end(_clients),
-            [&](std::map<int, ClientWrapper>::value_type& val) {
-                Client* client = val.second.getClient();
-                Utils::OnScopeExit returnClient([&] { val.second.returnClient(client); });
-                func(client);
-        });
+        for( ClientSlotChunk *chunk = &_slots; chunk; chunk = chunk->next.load( std::memory_order_acquire ) ) {
+            for( int i = 0; i < SLOT_CHUNK_SIZE; i++ ) {
+                ClientSlot &slot = chunk->slots[i];
+                Client *client = acquireSlot( slot );
+                if( client ) {
+                    Utils::OnScopeExit returnClient([&] { releaseSlot( slot ); });
+                    func(client);
+                }
+            }
+        }
     }
 private:
+    static const int SLOT_CHUNK_SIZE = 32;
+    // Slots are allocated in chunks which are neither moved nor freed
+    // as long as the manager exists, so they can be read without locking.
+    struct ClientSlotChunk {
+        ClientSlotChunk();
+        ClientSlot slots[SLOT_CHUNK_SIZE];
+        std::atomic<ClientSlotChunk*> next;
+    };
+    // Slot contains a client.
+    static const unsigned int SLOT_USED = 0x80000000u;
+    // Client is marked to be removed, so it cannot be acquired anymore.
+    static const unsigned int SLOT_REMOVED = 0x40000000u;
+    /**
+     * Increments reference counter of the slot.
+     * @return Client or NULL if there is no client or it's marked to be removed.
+     */
+    Client* acquireSlot( ClientSlot &slot );
+    void releaseSlot( ClientSlot &slot );
+    /**
+     * Gets used slot of given client, the table is not searched. Client
+     * must not be removed in the meantime, so either the client has to be
+     * acquired or the mutex has to be locked.
+     */
+    ClientSlot* findSlot( Client *client );
+    /**
+     * Deletes the client if the slot is marked to be
+     * removed and not used. Has to be called by the owner
+     * of the mutex.
+     * @return True if the slot has been freed.
+     */
+    bool tryFreeSlot( ClientSlot &slot );
     /**
      * Tries to remove client and marks it as
      * one to be removed if it cannot be removed.
-     * @param client Client to be removed.
+     * @param slot Slot of the client to be removed.
      * @param eventCode Event's code.
      * @return True if operation succeeded and client has been removed.
      */
-    bool tryRemoveClient( Client *client, int &eventCode );
+    bool tryRemoveSlot( ClientSlot &slot, int &eventCode );
+    /**
+     * Puts command addressed to the client into its queue according to
+     * the slow client policy, whatever its priority is.
+     * @return False if command has been dropped.
+     */
+    template<typename C>
+    bool deliver( Client &client, C &&command );
+    /**
+     * Puts command into the client's queue according to the overflow policy,
+     * so it never blocks.
+     * @return False if command has been dropped.
+     */
+    template<typename C>
+    bool deliverAsync( Client &client, C &&command );
+    template<typename C>
+    bool deliverDroppingOldest( Client &client, C &&command );
+    void recordDropped( Client &client );
 public:
     // Client has been added to the manager.
     static const int EVENT_CODE_CLIENT_ADDED = 1;
@@ -214,33 +405,26 @@ public:
     static const int EVENT_CODE_CLIENT_REMOVED = 2;
     // Client has been marked to be removed as soon as possible.
     static const int EVENT_CODE_CLIENT_MARKED_TO_REMOVE = 3;
-private:
-    // Handles the reference counting logic.
-    class ClientWrapper {
-    public:
-        explicit ClientWrapper(Client *client);
-        ClientWrapper(const ClientWrapper &cpy);
-        Client* getClient();
-        void returnClient( Client *client );
-        bool isConnected();
-        bool isRemovable();
-        void markRemove();
-        bool isMarkedToRemove();
-        void deleteClient();
-    private:
-        // A pointer to the client itself.
-        Client *client;
-        // A kind of reference counter.
-        int counter;
-        // True if client is marked to be removed when possible.
-        bool removed;
-    };
 protected:
     Utils::Logger &_log;
-    // Synchronized set of available clients.
+    // Synchronizes changes of the set of clients.
     Utils::Mutex _mutex;
-    // Map of managed clients.
-    std::map<int,ClientWrapper> _clients;
+    // First chunk of the clients table.
+    ClientSlotChunk _slots;
+    // Number of clients in the table, including ones marked to be removed.
+    std::atomic<int> _clientsCount;
+    // Number of clients marked to be removed.
+    std::atomic<int> _markedCount;
+    // Maximum number of clients, 0 means no limit.
+    int _maxClients;
+    // Handling of clients which do not read their commands.
+    JSRemoteDebuggerCfg::JSRSlowClientPolicy _slowClientPolicy;
+    int _slowClientTimeout;
+    // Handling of asynchronous commands, indexed by their priorities.
+    JSRemoteDebuggerCfg::JSROverflowPolicy _overflowPolicies[Command::PRIORITIES];
+    // Statistics of the overflow policies.
+    std::atomic<int> _droppedCount;
+    std::atomic<int> _coalescedCount;
 };
 
 /**
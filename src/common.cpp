@@ -24,7 +24,8 @@ using namespace JSR;
 JSDbgEngineOptions::JSDbgEngineOptions()
     : _suspended(false),
       _continue(false),
-      _displacement(0) {
+      _displacement(0),
+      _shareScripts(false) {
 }
 
 JSDbgEngineOptions::~JSDbgEngineOptions() {
@@ -56,3 +57,12 @@ JSDbgEngineOptions &JSDbgEngineOptions::setSourceCodeDisplacement( int displacem
 int JSDbgEngineOptions::getSourceCodeDisplacement() const {
     return _displacement;
 }
+
+JSDbgEngineOptions &JSDbgEngineOptions::shareCompiledScripts() {
+    _shareScripts = true;
+    return *this;
+}
+
+bool JSDbgEngineOptions::isShareCompiledScripts() const {
+    return _shareScripts;
+}
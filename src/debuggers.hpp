@@ -28,6 +28,7 @@
 
 #include <threads.hpp>
 #include <log.hpp>
+#include <pool.hpp>
 
 #include "client.hpp"
 #include "js_dbg_engine.hpp"
@@ -53,6 +54,16 @@ public:
     DebuggerAction( const DebuggerAction &cpy );
     virtual ~DebuggerAction();
     virtual ActionResult execute( JSContext *ctx, Debugger &debugger ) = 0;
+    /**
+     * Actions are created for every incoming command and every
+     * target context, so they are allocated from a shared pool.
+     */
+    static void* operator new( size_t size );
+    static void operator delete( void *ptr, size_t size );
+    /**
+     * Gets the pool, so allocations can be observed.
+     */
+    static Utils::MemoryPool& getPool();
 protected:
     Utils::Logger &_log;
 };
@@ -71,6 +82,7 @@ public:
     virtual int uninstall( JSContext *cx ) = 0;
     virtual int interrupt( JSContext *cx ) = 0;
     virtual int handlePendingCommands( JSContext *cx ) = 0;
+    virtual int getPollHandle( JSContext *cx, JSRPollHandle &handle ) = 0;
     virtual int registerDebuggee(JSContext *cx, JS::HandleObject debuggee) = 0;
     virtual int unregisterDebuggee( JSContext *cx, JS::HandleObject debuggee ) = 0;
     virtual JSDebuggerEngine* getEngine( JSContext *cx ) const;
@@ -666,6 +666,8 @@
                     env.print( 'New script has been loaded: ' + script.url );
                 }
                 
+                stateMirror.scriptLoaded( script );
+
                 // Register pending breakpoints if there are any.
                 dbg.registerPendingBreakpoints( script );
                 
@@ -718,6 +720,7 @@
                 if( breakpoint.url === script.url ) {
                     try {
                         this._setBreakpointCore( script, breakpoint );
+                        stateMirror.revokeBreakpoints();
                         try {
                             env.sendCommand( BROADCAST, ProtocolStrategy.command_BREAKPOINT_SET( breakpoint ) );
                         } catch( exc ) {
@@ -815,6 +818,8 @@
 
             this._storage.breakpoints[breakpoint.id] = breakpoint;
 
+            stateMirror.revokeBreakpoints();
+
             return breakpoint;
         },
         
@@ -837,6 +842,9 @@
                     deleted.push(id);
                 }
             }
+            if( deleted.length > 0 ) {
+                stateMirror.revokeBreakpoints();
+            }
             return deleted;
         },
         
@@ -863,6 +871,7 @@
         deleteAllBreakpoints: function() {
             this._dbg.clearAllBreakpoints();
             this._storage.breakpoints = {};
+            stateMirror.revokeBreakpoints();
         },
         
         /**
@@ -1550,7 +1559,10 @@
             'get_breakpoints': {
                 needPause: false,
                 fn: function( ctx ) {
-                    ctx.sendCommand( ProtocolStrategy.command_BREAKPOINTS_LIST( ctx.debuggerMediator.getAllBreakpoints() ) );
+                    let packet = ProtocolStrategy.command_BREAKPOINTS_LIST( ctx.debuggerMediator.getAllBreakpoints() );
+                    // Published before the request ID is added.
+                    stateMirror.publishBreakpoints( packet );
+                    ctx.sendCommand( packet );
                     return HC_RES_IGNORE;
                 }
             },
@@ -1664,7 +1676,9 @@
                     let script = scriptsRepository.getScriptSourceCode( ctx.command.url, -1, null );
                     if( script ) {
                         let sourceCode = script.getAllSourceLines();
-                        ctx.sendCommand( ProtocolStrategy.command_SEND_SCRIPT( ctx.command.url, sourceCode, env.options.sourceDisplacement ) );
+                        let packet = ProtocolStrategy.command_SEND_SCRIPT( ctx.command.url, sourceCode, env.options.sourceDisplacement );
+                        stateMirror.publishSource( ctx.command.url, packet );
+                        ctx.sendCommand( packet, true );
                     } else {
                         throw new DbgException( "Script not found: " + ctx.command.url, ERROR_CODE_SCRIPT_NOT_FOUND );
                     }
@@ -1772,14 +1786,15 @@
             ctx.debuggerMediator = this._debuggerMediator;
             ctx.stateHandlerFactory = this._stateHandlerFactory;
             
-            // Sends a generic command to the client.
-            ctx.sendCommand = function( cmd ) {
+            // Sends a generic command to the client. Sources and other
+            // big responses are marked as bulk transfers.
+            ctx.sendCommand = function( cmd, bulk ) {
                 // Send id back if there is any.
                 if( id ) {
                     cmd.id = id;
                 }
                 try {
-                    env.sendCommand( clientId, cmd );
+                    env.sendCommand( clientId, cmd, !!bulk );
                 } catch( exc ) {
                     // Throwing exception has no sense in this case, because
                     // it won't be sent to the client anyway. In addition remember
@@ -1875,6 +1890,60 @@
         
     };
 
+    /**
+     * Publishes responses to read-only commands, so the native part of the
+     * debugger can answer them on its own while the debuggee is running. Every
+     * response has to be revoked as soon as the state it describes changes.
+     */
+    function StateMirror() {
+        this._sources = {};
+    }
+
+    StateMirror.prototype = {
+
+        /**
+         * Publishes the response or revokes it if null is given.
+         */
+        publish: function( command, key, packet ) {
+            try {
+                env.publishResponse( command, key, packet );
+            } catch( exc ) {
+                // The command is just handled by the engine then.
+                Utils.logException( exc );
+            }
+        },
+
+        publishBreakpoints: function( packet ) {
+            this.publish( 'get_breakpoints', '', packet );
+        },
+
+        revokeBreakpoints: function() {
+            this.publish( 'get_breakpoints', '', null );
+        },
+
+        publishSource: function( url, packet ) {
+            this._sources[url] = true;
+            this.publish( 'get_source', url, packet );
+        },
+
+        /**
+         * Revokes responses which don't take the new script into account.
+         */
+        scriptLoaded: function( script ) {
+            var url = script.url;
+            if( !url || url === 'debugger eval code' ) {
+                return;
+            }
+            if( this._sources[url] ) {
+                delete this._sources[url];
+                this.publish( 'get_source', url, null );
+            }
+        }
+
+    };
+
+    var stateMirror = new StateMirror();
+
     function ScriptRepository() {
         (function(dest) {
             var scripts = {};
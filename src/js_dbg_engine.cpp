@@ -219,8 +219,8 @@ namespace MozJS {
     */
    static JSBool JSR_fn_sendCommand( JSContext *cx, unsigned argc, Value *vp ) {
 
-       if( argc != 2 ) {
-           JS_ReportError( cx, "Function should be called with exactly two arguments." );
+       if( argc != 2 && argc != 3 ) {
+           JS_ReportError( cx, "Function should be called with two or three arguments." );
            return JS_FALSE;
        }
 
@@ -238,7 +238,7 @@ namespace MozJS {
 
        int clientId = args.get(0).toInt32();
 
-       // Convert object into UTF-16 string using standard stringify logic.
+       // Convert object into UTF-8 string using standard stringify logic.
        Value jsCommandStr = args.get(1);
 
        MozJSUtils jsUtils(cx);
@@ -265,8 +265,11 @@ namespace MozJS {
            }
        }
 
+       // Optional flag marks bulk transfers.
+       bool bulk = argc > 2 && args.get(2).isBoolean() && args.get(2).toBoolean();
+
        // Send command using provided handler.
-       if( !engine->getEngineEventHandler().sendCommand( clientId, engine->getContextId(), commandStr ) ) {
+       if( !engine->getEngineEventHandler().sendCommand( clientId, engine->getContextId(), commandStr, bulk ) ) {
            log.warn( "JSR_fn_sendCommand: Engine couldn't send a command for client: %d", clientId );
            if( !JS_IsExceptionPending( cx ) ) {
                JS_ReportError( cx, "Cannot send command, probably client has already been disconnected." );
@@ -277,12 +280,65 @@ namespace MozJS {
        return JS_TRUE;
    }
 
+   /**
+    * Publishes response to a read-only command or revokes it if null is passed.
+    */
+   static JSBool JSR_fn_publishResponse( JSContext *cx, unsigned argc, Value *vp ) {
+
+       if( argc != 3 ) {
+           JS_ReportError( cx, "Function should be called with exactly three arguments." );
+           return JS_FALSE;
+       }
+
+       Logger &log = LoggerFactory::getLogger();
+
+       // Gets engine for context.
+       JSDebuggerEngine *engine = JSDebuggerEngine::getEngineForContext(cx);
+       if( !engine ) {
+           log.error("JSR_fn_publishResponse: There is no engine installed for given context." );
+           JS_ReportError( cx, "There is no engine installed for given context." );
+           return JS_FALSE;
+       }
+
+       CallArgs args = CallArgsFromVp(argc, vp);
+
+       MozJSUtils jsUtils(cx);
+
+       string command, key;
+       if( !jsUtils.toUTF8( args.get(0), command ) || !jsUtils.toUTF8( args.get(1), key ) ) {
+           log.error("JSR_fn_publishResponse: Cannot convert command name into UTF-8." );
+           JS_ReportError( cx, "Cannot convert command name into UTF-8." );
+           return JS_FALSE;
+       }
+
+       JSEngineEventHandler &handler = engine->getEngineEventHandler();
+
+       if( args.get(2).isNullOrUndefined() ) {
+           handler.revokeResponse( cx, command, key );
+       } else {
+           string response;
+           if( !jsUtils.stringifyToUtf8( args.get(2), response ) ) {
+               log.error("JSR_fn_publishResponse: Cannot stringify response, error: %d", jsUtils.getLastError() );
+               if( !JS_IsExceptionPending( cx ) ) {
+                   JS_ReportError( cx, "Cannot stringify response." );
+               }
+               return JS_FALSE;
+           }
+           handler.publishResponse( cx, command, key, response );
+       }
+
+       args.rval().setUndefined();
+
+       return JS_TRUE;
+   }
+
    static JSFunctionSpec JSR_EngineEnvironmentFuntions[] = {
        { "getSourceSafe", JSOP_WRAPPER ( JSR_fn_getSourceSafe ), 0, JSPROP_PERMANENT | JSPROP_ENUMERATE },
        { "print", JSOP_WRAPPER ( JSR_fn_print ), 0, JSPROP_PERMANENT | JSPROP_ENUMERATE },
        { "loadScriptSource", JSOP_WRAPPER (JSR_fn_loadScript), 0, JSPROP_PERMANENT | JSPROP_ENUMERATE },
        { "waitForCommand", JSOP_WRAPPER (JSR_fn_waitForCommand), 0, JSPROP_PERMANENT | JSPROP_ENUMERATE },
        { "sendCommand", JSOP_WRAPPER (JSR_fn_sendCommand), 0, JSPROP_PERMANENT | JSPROP_ENUMERATE },
+       { "publishResponse", JSOP_WRAPPER (JSR_fn_publishResponse), 0, JSPROP_PERMANENT | JSPROP_ENUMERATE },
        JS_FS_END
    };
 
@@ -372,7 +428,7 @@ int JSDebuggerEngine::install() {
     }
 #endif
 
-    if( !jsUtils.registerModuleLoader( debuggerGlobal ) ) {
+    if( !jsUtils.registerModuleLoader( debuggerGlobal, _options.isShareCompiledScripts() ) ) {
         _log.error( "JSDebuggerEngine::install: Cannot install module loader." );
         return JSR_ERROR_SM_CANNOT_REGISTER_MODULE_LOADER;
     }
@@ -396,8 +452,6 @@ int JSDebuggerEngine::install() {
         return JSR_ERROR_SM_CANNOT_DEFINE_FUNCTION;
     }
 
-    const string script = resource->toString();
-
     // Prepares 'engine.options' object.
     RootedObject envOptions( _ctx, JS_NewObject( _ctx, nullptr, nullptr, nullptr ) );
     if( envOptions ) {
@@ -415,7 +469,7 @@ int JSDebuggerEngine::install() {
     }
 
     Value retval;
-    if( !jsUtils.evaluateUtf8Script( debuggerGlobal, script,  "mozjs_dbg.js", &retval ) ) {
+    if( !jsUtils.evaluateResource( debuggerGlobal, *resource, "mozjs_dbg.js", &retval, _options.isShareCompiledScripts() ) ) {
         _log.error( "JSDebuggerEngine::install: Cannot evaluate hosted debugging code." );
         return JSR_ERROR_SM_CANNOT_EVALUATE_SCRIPT;
     }
@@ -478,60 +532,63 @@ int JSDebuggerEngine::uninstall() {
 
 bool JSDebuggerEngine::sendCommand( int clientId, const std::string &command, DebuggerStateHint &engineState ) {
 
-    bool result = true;
-
     try {
 
-        // Enter into the debugger compartment.
-        JSAutoRequest req(_ctx);
-        JSAutoCompartment cr(_ctx, _debuggerGlobal);
-
         JCharEncoder encoder;
-        jstring jcommand = encoder.utf8ToWide( command );
+        return sendCommand( clientId, encoder.utf8ToWide( command ), engineState );
+
+    } catch( EncodingFailedException & ) {
+        // Probably out of memory or not supported encoding, wait for the next execution.
+        _log.error("CommandAction:: Cannot convert incoming command to UTF-16.");
+        return false;
+    }
+}
 
-        // We are not interested in exceptions inside
-        // the command handler, they are silently ignored
-        // just because we do not have any logging facility yet.
-        JSExceptionState *excState = JS_SaveExceptionState(_ctx);
+bool JSDebuggerEngine::sendCommand( int clientId, const jstring &jcommand, DebuggerStateHint &engineState ) {
 
-        RootedValue parsedCommand(_ctx);
-        if( !JS_ParseJSON( _ctx, jcommand.c_str(), jcommand.size(), &parsedCommand ) ) {
-            _log.error( "CommandAction:: Cannot parse debugger command. Syntax error in the JSON structure." );
-            result = false;
-        }
+    bool result = true;
+
+    // Enter into the debugger compartment.
+    JSAutoRequest req(_ctx);
+    JSAutoCompartment cr(_ctx, _debuggerGlobal);
 
-        if( result ) {
+    // We are not interested in exceptions inside
+    // the command handler, they are silently ignored
+    // just because we do not have any logging facility yet.
+    JSExceptionState *excState = JS_SaveExceptionState(_ctx);
 
-            Value argv[] = {
-               JS_NumberValue( clientId ),
-               parsedCommand
-            };
+    RootedValue parsedCommand(_ctx);
+    if( !JS_ParseJSON( _ctx, jcommand.c_str(), jcommand.size(), &parsedCommand ) ) {
+        _log.error( "CommandAction:: Cannot parse debugger command. Syntax error in the JSON structure." );
+        result = false;
+    }
 
-            Value jsResult;
-            if( !JS_CallFunctionName( _ctx, _debuggerModule, "handleCommand", 2, argv, &jsResult ) ) {
-               _log.error("CommandAction:: Cannot invoke 'handleCommand' method.");
-               result = false;
-            } else {
-                // Check if command handler should block and wait for incoming commands.
-                engineState = static_cast<DebuggerStateHint>( jsResult.toInt32() );
-            }
+    if( result ) {
 
-        }
+        Value argv[] = {
+           JS_NumberValue( clientId ),
+           parsedCommand
+        };
 
-        if( JS_IsExceptionPending( _ctx ) ) {
-            MozJSUtils jsUtils(_ctx);
-            _log.error( "CommandAction:: Pending exception found: %s : %s", jsUtils.getPendingExceptionMessage().c_str(), jsUtils.getPendingExceptionStack().c_str() );
-            result = false;
+        Value jsResult;
+        if( !JS_CallFunctionName( _ctx, _debuggerModule, "handleCommand", 2, argv, &jsResult ) ) {
+           _log.error("CommandAction:: Cannot invoke 'handleCommand' method.");
+           result = false;
+        } else {
+            // Check if command handler should block and wait for incoming commands.
+            engineState = static_cast<DebuggerStateHint>( jsResult.toInt32() );
         }
 
-        JS_RestoreExceptionState(_ctx, excState);
+    }
 
-    } catch( EncodingFailedException & ) {
-        // Probably out of memory or not supported encoding, wait for the next execution.
-        _log.error("CommandAction:: Cannot convert incoming command to UTF-16.");
+    if( JS_IsExceptionPending( _ctx ) ) {
+        MozJSUtils jsUtils(_ctx);
+        _log.error( "CommandAction:: Pending exception found: %s : %s", jsUtils.getPendingExceptionMessage().c_str(), jsUtils.getPendingExceptionStack().c_str() );
         result = false;
     }
 
+    JS_RestoreExceptionState(_ctx, excState);
+
     return result;
 }
 
@@ -671,3 +728,9 @@ JSEngineEventHandler::JSEngineEventHandler() {
 
 JSEngineEventHandler::~JSEngineEventHandler() {
 }
+
+void JSEngineEventHandler::publishResponse( JSContext *ctx, const string &command, const string &key, string &response ) {
+}
+
+void JSEngineEventHandler::revokeResponse( JSContext *ctx, const string &command, const string &key ) {
+}
@@ -27,6 +27,7 @@
 
 #include <threads.hpp>
 #include <log.hpp>
+#include <encoding.hpp>
 
 namespace JSR {
 
@@ -46,10 +47,13 @@ public:
     /**
      * Receives commands sent by engine itself.
      * @param clientId Client id.
-     * @param command JSON formated command.
+     * @param command JSON formated command. Engine doesn't use it after
+     *                the call, so it can be taken over by the handler.
+     * @param bulk True if the command is a bulk transfer, e.g. a source
+     *             code, which shouldn't hold back other commands.
      * @return True if command has been sent successfully.
      */
-    virtual bool sendCommand( int clientId, int contextId, std::string &command ) = 0;
+    virtual bool sendCommand( int clientId, int contextId, std::string &command, bool bulk ) = 0;
     /**
      * Called when debugger is going to pause. This method is
      * blocked one. Debugger is blocked until this method returns.
@@ -59,6 +63,20 @@ public:
      * has been interrupted and is going to shutdown.
      */
     virtual bool waitForCommand( JSContext *ctx, bool suspended ) = 0;
+    /**
+     * Publishes response to a read-only command, so it can be sent
+     * without involving the engine until it's revoked. Handlers which
+     * don't support it just ignore the response.
+     * @param command Name of the command.
+     * @param key Argument the response is valid for or an empty string.
+     * @param response JSON formated response without request ID. Engine
+     *                 doesn't use it after the call, so it can be taken over.
+     */
+    virtual void publishResponse( JSContext *ctx, const std::string &command, const std::string &key, std::string &response );
+    /**
+     * Revokes response published for the command.
+     */
+    virtual void revokeResponse( JSContext *ctx, const std::string &command, const std::string &key );
 };
 
 // Generic JS engine debugger implementation.
@@ -102,6 +120,11 @@ public:
      * @return True if command has been handled correctly.
      */
     bool sendCommand( int clientId, const std::string &command, DebuggerStateHint &engineState );
+    /**
+     * Sends command which has been already converted to UTF-16, so
+     * the conversion doesn't have to be done on the JS engine thread.
+     */
+    bool sendCommand( int clientId, const Utils::jstring &command, DebuggerStateHint &engineState );
     /**
      * Gets a handler responsible for handling events emitted
      * by JS engine.
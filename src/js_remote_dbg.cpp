@@ -20,14 +20,17 @@
 #include "js_remote_dbg.hpp"
 
 #include <iostream>
+#include <atomic>
 
 #include <jsdbg_common.h>
 #include <jsapi.h>
 #include <jsdbgapi.h>
 #include <js_utils.hpp>
 #include <encoding.hpp>
+#include <poll_signal.hpp>
 
 #include "message_builder.hpp"
+#include "response_mirror.hpp"
 #include "version.h"
 
 using namespace JSR;
@@ -36,9 +39,57 @@ using namespace std;
 using namespace Utils;
 
 #define ENGINE_DATA(x) static_cast<DbgContextData*>( x->getTag() )
+// Maximum number of free debugger actions kept in the pool.
+#define JSR_ACTION_POOL_MAX_FREE 256
+
+// Commands supported by the debugger engine (see DbgCommandFactory in mozjs_dbg.js).
+static const char *JSR_ENGINE_COMMANDS[] = {
+    "step", "step_out", "next", "continue", "stop", "set_breakpoint", "delete_breakpoint",
+    "get_breakpoints", "delete_all_breakpoints", "pc", "pause", "get_stacktrace",
+    "get_variables", "evaluate", "get_source", "get_all_source_urls", nullptr
+};
 
 namespace MozJS {
 
+    /**
+     * Makes the action queue pollable by the application's event loop.
+     */
+    class ActionQueueSignal : public QueueSignalHandler<DebuggerAction*> {
+    public:
+        ActionQueueSignal()
+            : _initialized( false ) {
+        }
+        bool init() {
+            return _initialized = _signal.init();
+        }
+        bool isInitialized() const {
+            return _initialized;
+        }
+        poll_handle getHandle() const {
+            return _signal.getHandle();
+        }
+        void handle( action_queue &queue, int signal ) {
+            if( signal == action_queue::SIGNAL_NEW_ELEMENT ) {
+                _signal.set();
+            }
+        }
+        /**
+         * Resets the signal after the queue has been drained. It's set
+         * again if actions have been added in the meantime.
+         */
+        void update( action_queue &queue ) {
+            if( _initialized ) {
+                _signal.reset();
+                if( queue.getCount() > 0 ) {
+                    _signal.set();
+                }
+            }
+        }
+    private:
+        PollSignal _signal;
+        bool _initialized;
+    };
+
     /**
      * Private data for JSContext.
      */
@@ -49,12 +100,18 @@ namespace MozJS {
         JSOperationCallback callbackChain;
         // Debugger instance.
         SpiderMonkeyDebugger *debugger;
+        // Signals the application that there are actions in the queue.
+        ActionQueueSignal actionSignal;
         // Action queue dedicated for the engine instance.
         action_queue actionQueue;
         // JS context id.
         int contextId;
         // True if engine is paused.
         bool paused;
+        // Number of commands queued for the engine, but not executed yet.
+        std::atomic<int> pendingCommands;
+        // Responses to read-only commands published by the engine.
+        ResponseMirror mirror;
     } DbgContextData;
 
     /**
@@ -157,6 +214,8 @@ namespace MozJS {
                         }
                     }
 
+                    ctxData->actionSignal.update( queue );
+
 
                 } catch( InterruptionException & ) {
                     // Loop has been interrupted.
@@ -220,12 +279,28 @@ DebuggerAction::DebuggerAction()
 DebuggerAction::~DebuggerAction() {
 }
 
+// The biggest of the actions, others fit into the same blocks.
+static MemoryPool ActionPool( sizeof( CommandAction ), JSR_ACTION_POOL_MAX_FREE );
+
+void* DebuggerAction::operator new( size_t size ) {
+    return ActionPool.allocate( size );
+}
+
+void DebuggerAction::operator delete( void *ptr, size_t size ) {
+    ActionPool.release( ptr, size );
+}
+
+MemoryPool& DebuggerAction::getPool() {
+    return ActionPool;
+}
+
 /*****************/
 /* CommandAction */
 /*****************/
 
-CommandAction::CommandAction( ClientManager &clientManager, Command &command )
+CommandAction::CommandAction( ClientManager &clientManager, int clientId, const std::shared_ptr<const jstring> &command )
     : _clientManager(clientManager),
+      _clientId( clientId ),
       _command( command ) {
 }
 
@@ -244,7 +319,7 @@ ActionResult CommandAction::execute( JSContext *ctx, Debugger &dbg ) {
     // need to synchronize it.
     JSDebuggerEngine *engine = dbg.getEngine( ctx );
     if( engine ) {
-        if( engine->sendCommand( _command.getClientId(), _command.getValue(), state ) ) {
+        if( engine->sendCommand( _clientId, *_command, state ) ) {
             actionResult.hint = state;
         } else {
             actionResult.result = ActionResult::DA_FAILED;
@@ -254,6 +329,10 @@ ActionResult CommandAction::execute( JSContext *ctx, Debugger &dbg ) {
         actionResult.result = ActionResult::DA_FAILED;
     }
 
+    if( engine && ENGINE_DATA( engine ) ) {
+        ENGINE_DATA( engine )->pendingCommands--;
+    }
+
     return actionResult;
 
 }
@@ -296,7 +375,7 @@ SpiderMonkeyDebugger::~SpiderMonkeyDebugger() {
  * all this, we can handle every incoming command just in here
  * in a nonblocking way.
  */
-void SpiderMonkeyDebugger::handle( command_queue &queue, int signal ) {
+void SpiderMonkeyDebugger::handle( command_in_queue &queue, int signal ) {
 
     Command command;
 
@@ -333,15 +412,25 @@ void SpiderMonkeyDebugger::handle( command_queue &queue, int signal ) {
             Command command( clientId, command.getContextId(),
                     MessageFactory::getInstance()->prepareServerVersion( JSRDBG_VERSION, requestId ) );
 
-            _clientManager.sendCommand( command );
+            _clientManager.sendCommand( std::move( command ) );
 
         } else {
 
+            // Commands are parsed here, so the malformed ones never reach
+            // the JS engine and the read-only ones can be answered at once.
+            JSONValue request;
+            if( !checkCommand( command, request ) ) {
+                continue;
+            }
+
             // It sends the command to the debugger through the
             // dedicated blocking queue. Notice that it's not a
             // blocking queue.
             int contextId = command.getContextId();
 
+            // UTF-16 form of the command, converted only if an engine needs it.
+            std::shared_ptr<const jstring> wideCommand;
+
             map_context_iterator it = _contextMap.end();
 
             if( contextId != -1 ) {
@@ -359,8 +448,8 @@ void SpiderMonkeyDebugger::handle( command_queue &queue, int signal ) {
                     JSDebuggerEngine *engine = JSDebuggerEngine::getEngineForContext( ctx );
 
                     if( engine ) {
-                        // Sends command directly to the queue dedicated for given engine.
-                        sendCommandToQueue( ctx, ENGINE_DATA( engine )->actionQueue, command );
+                        // Sends command directly to the given engine.
+                        sendCommandToEngine( engine, command, request, wideCommand );
                     } else {
                         _log.error( "Engine not found for context: %d", it->first );
                     }
@@ -383,7 +472,8 @@ void SpiderMonkeyDebugger::handle( command_queue &queue, int signal ) {
                 for( map_context_iterator it = _contextMap.begin(); it != _contextMap.end(); it++ ) {
                     JSDebuggerEngine *engine = JSDebuggerEngine::getEngineForContext(it->second.context);
                     if( engine ) {
-                        sendCommandToQueue( engine->getJSContext(), ENGINE_DATA( engine )->actionQueue, command );
+                        // Command is converted to UTF-16 once and shared by all the engines.
+                        sendCommandToEngine( engine, command, request, wideCommand );
                     }
                 }
 
@@ -392,6 +482,63 @@ void SpiderMonkeyDebugger::handle( command_queue &queue, int signal ) {
     }
 }
 
+/**
+ * Rejects commands the debugger engine would reject anyway. Errors are
+ * reported exactly the same way the engine reports them.
+ */
+bool SpiderMonkeyDebugger::checkCommand( const Command &command, JSONValue &request ) {
+
+    const string &value = command.getValue();
+
+    JSONReader reader;
+    if( !reader.parse( value, request ) ) {
+        _log.error( "SpiderMonkeyDebugger::checkCommand: Malformed command: %s Offset: %d", reader.getError(), static_cast<int>( reader.getErrorOffset() ) );
+        sendErrorMessage( command.getClientId(), MessageFactory::CE_COMMAND_FAILED, "Malformed command." );
+        return false;
+    }
+
+    string requestId;
+    const JSONValue *id = request.isObject() ? request.find( "id" ) : nullptr;
+    if( id && id->isTruthy() ) {
+        requestId = value.substr( id->getOffset(), id->getLength() );
+    }
+
+    MessageFactory::EngineErrorCode errorCode;
+    string msg;
+
+    const JSONValue *type = request.isObject() ? request.find( "type" ) : nullptr;
+    const JSONValue *name = request.isObject() ? request.find( "name" ) : nullptr;
+    if( !type || !type->isString() || type->getString() != "command" ) {
+        errorCode = MessageFactory::EE_NOT_A_COMMAND_PACKAGE;
+        msg = "Not a command packet.";
+    } else if( !name || !name->isTruthy() ) {
+        errorCode = MessageFactory::EE_NO_COMMAND_NAME;
+        msg = "Command name not found.";
+    } else if( name->isString() ) {
+        const char **engineCommand = JSR_ENGINE_COMMANDS;
+        while( *engineCommand && name->getString() != *engineCommand ) {
+            engineCommand++;
+        }
+        if( *engineCommand ) {
+            return true;
+        }
+        errorCode = MessageFactory::EE_UNKNOWN_COMMAND;
+        msg = "Unknown command.";
+    } else {
+        // Let the engine decide what to do with it.
+        return true;
+    }
+
+    Command error( command.getClientId(), command.getContextId(),
+            MessageFactory::getInstance()->prepareEngineError( errorCode, msg, requestId ) );
+
+    if( !_clientManager.sendCommand( std::move( error ) ) ) {
+        _log.error( "SpiderMonkeyDebugger::checkCommand: Cannot send command to client: %d", command.getClientId() );
+    }
+
+    return false;
+}
+
 /* Extracts optional request ID from the system command. */
 std::string SpiderMonkeyDebugger::extractRequestId( const std::string &command ) {
     int separator = command.find('/');
@@ -416,8 +563,8 @@ void SpiderMonkeyDebugger::sendErrorMessage( int clientId, JSR::MessageFactory::
     // No context found, so inform the client.
     Command command( clientId, -1, MessageFactory::getInstance()->prepareErrorMessage( errorCode, msg ) );
 
-    if( !_clientManager.sendCommand( command ) ) {
-        _log.error( "SpiderMonkeyDebugger::sendErrorMessage: Cannot send command to client: %d", command.getClientId() );
+    if( !_clientManager.sendCommand( std::move( command ) ) ) {
+        _log.error( "SpiderMonkeyDebugger::sendErrorMessage: Cannot send command to client: %d", clientId );
     }
 
 }
@@ -442,15 +589,43 @@ void SpiderMonkeyDebugger::sendContextsList( int clientId, int contextId, const
 
     Command command( clientId, contextId, MessageFactory::getInstance()->prepareContextList( contexts, requestId ) );
 
-    _clientManager.sendCommand( command );
+    _clientManager.sendCommand( std::move( command ) );
 }
 
 /**
- * Sends a command to a queue. The command is send in a form of a debugger action.
+ * Sends a command to the engine. Read-only commands are answered straight away
+ * using responses published by the engine, but only if there are no other
+ * commands waiting for the engine, so the client never gets a response which
+ * doesn't reflect its earlier commands. The protocol thread cannot wait for
+ * slow clients, so if the client's queue is full the engine answers instead.
  */
-void SpiderMonkeyDebugger::sendCommandToQueue( JSContext *ctx, action_queue &queue, Command &command ) {
+void SpiderMonkeyDebugger::sendCommandToEngine( JSDebuggerEngine *engine, const Command &command, const JSONValue &request, std::shared_ptr<const jstring> &wideCommand ) {
+
+    DbgContextData *ctxData = ENGINE_DATA( engine );
+
+    string response;
+    if( ctxData->pendingCommands == 0 && ctxData->mirror.answer( request, command.getValue(), response ) ) {
+        Command answer( command.getClientId(), engine->getContextId(), std::move( response ) );
+        const JSONValue *name = request.find( "name" );
+        if( name && name->getString() == "get_source" ) {
+            // The same way the engine sends sources.
+            answer.setPriority( Command::PRIORITY_BULK );
+        }
+        if( _clientManager.trySendCommand( std::move( answer ) ) ) {
+            return;
+        }
+        _log.debug( "SpiderMonkeyDebugger::sendCommandToEngine: Queue of client %d is full, command goes to the engine.", command.getClientId() );
+    }
 
-    DebuggerAction *commandAction = new CommandAction( _clientManager, command );
+    sendCommandToQueue( engine->getJSContext(), ctxData->actionQueue, command, wideCommand );
+}
+
+/**
+ * Sends a command to a queue. The command is send in a form of a debugger action.
+ * It's converted to UTF-16 unless the conversion has been already done for
+ * another queue.
+ */
+void SpiderMonkeyDebugger::sendCommandToQueue( JSContext *ctx, action_queue &queue, const Command &command, std::shared_ptr<const jstring> &wideCommand ) {
 
     // Warn the client.
     if( queue.getCount() >= 2 ) {
@@ -463,16 +638,35 @@ void SpiderMonkeyDebugger::sendCommandToQueue( JSContext *ctx, action_queue &que
                         "If the application being debugged is blocked on a system call or something,\\n"
                         "try to resume it for a while in order to execute a piece of JavaScript code." ) );
 
-        _clientManager.sendCommand( warning );
+        _clientManager.sendCommand( std::move( warning ) );
+
+    }
+
+    DbgContextData *ctxData = ENGINE_DATA( JSDebuggerEngine::getEngineForContext( ctx ) );
 
+    if( !wideCommand ) {
+        try {
+            JCharEncoder encoder;
+            wideCommand = std::make_shared<const jstring>( encoder.utf8ToWide( command.getValue() ) );
+        } catch( EncodingFailedException & ) {
+            _log.error( "SpiderMonkeyDebugger::sendCommandToQueue: Cannot convert incoming command to UTF-16." );
+            sendErrorMessage( command.getClientId(), MessageFactory::CE_COMMAND_FAILED, "Cannot convert command to UTF-16." );
+            return;
+        }
     }
 
+    DebuggerAction *commandAction = new CommandAction( _clientManager, command.getClientId(), wideCommand );
+
+    // Counted before the action becomes visible to the engine.
+    ctxData->pendingCommands++;
+
     if( queue.add( commandAction ) ) {
         // Inform runtime about new debugger commands. The runtime
         // will handle it as soon as possible, but we cannot
         // guarantee when. It's a bit similar to JS setTimeout(fn,0).
         JS_TriggerOperationCallback( JS_GetRuntime( ctx ) );
     } else {
+        ctxData->pendingCommands--;
         delete commandAction;
         _log.error( "Queue is full, so the incoming command has been ignored in order not to block the main loop." );
     }
@@ -583,6 +777,13 @@ int SpiderMonkeyDebugger::install( JSContext *cx, const string &contextName, con
         ctxData->debugger = this;
         ctxData->contextId = contextId;
         ctxData->paused = false;
+        ctxData->pendingCommands = 0;
+
+        if( ctxData->actionSignal.init() ) {
+            ctxData->actionQueue.setSignalHandler( &ctxData->actionSignal );
+        } else {
+            _log.error( "SpiderMonkeyDebugger::install: Cannot create poll handle for context: %d", contextId );
+        }
 
         JSContextDescriptor desc;
         desc.context = cx;
@@ -677,6 +878,24 @@ int SpiderMonkeyDebugger::handlePendingCommands( JSContext *cx ) {
     return JSR_ERROR_NO_ERROR;
 }
 
+int SpiderMonkeyDebugger::getPollHandle( JSContext *cx, JSRPollHandle &handle ) {
+    MutexLock locker(_lock);
+
+    JSDebuggerEngine *engine = JSDebuggerEngine::getEngineForContext(cx);
+    if ( !engine ) {
+        return JSR_ERROR_SM_DEBUGGER_IS_NOT_INSTALLED;
+    }
+
+    DbgContextData *ctxData = ENGINE_DATA(engine);
+    if( !ctxData->actionSignal.isInitialized() ) {
+        return JSR_ERROR_INTERNAL_PIPE_FAILED;
+    }
+
+    handle = ctxData->actionSignal.getHandle();
+
+    return JSR_ERROR_NO_ERROR;
+}
+
 int SpiderMonkeyDebugger::uninstall( JSContext *cx ) {
 
     MutexLock locker(_lock);
@@ -722,24 +941,42 @@ int SpiderMonkeyDebugger::loadScript( JSContext *cx, std::string file, std::stri
 
 }
 
-bool SpiderMonkeyDebugger::sendCommand( int clientId, int contextId, std::string &commandRaw ) {
+bool SpiderMonkeyDebugger::sendCommand( int clientId, int contextId, std::string &commandRaw, bool bulk ) {
 
     // Prepare a command and sent it to the client. Notice that we
     // use byte buffer directly here, so user will get utf8 encoded
-    // content.
-    Command command( clientId, contextId, commandRaw );
+    // content. The buffer is taken over, so it's not copied.
+    Command command( clientId, contextId, std::move( commandRaw ) );
+    if( bulk ) {
+        command.setPriority( Command::PRIORITY_BULK );
+    }
 
     // As long as the command is not a broadcast one,
     // this is a blocking operation, so debuggee/debugger
     // will be blocked as long as the code is sent to the client's
     // output queue.
-    return _clientManager.sendCommand( command );
+    return _clientManager.sendCommand( std::move( command ) );
 }
 
 bool SpiderMonkeyDebugger::waitForCommand( JSContext *cx, bool suspended ) {
     return JSR_CommandLoop( cx, true, suspended );
 }
 
+void SpiderMonkeyDebugger::publishResponse( JSContext *cx, const std::string &command, const std::string &key, std::string &response ) {
+    JSDebuggerEngine *engine = JSDebuggerEngine::getEngineForContext( cx );
+    // Engine's data is not available until the engine is installed.
+    if( engine && ENGINE_DATA( engine ) ) {
+        ENGINE_DATA( engine )->mirror.publish( command, key, response );
+    }
+}
+
+void SpiderMonkeyDebugger::revokeResponse( JSContext *cx, const std::string &command, const std::string &key ) {
+    JSDebuggerEngine *engine = JSDebuggerEngine::getEngineForContext( cx );
+    if( engine && ENGINE_DATA( engine ) ) {
+        ENGINE_DATA( engine )->mirror.revoke( command, key );
+    }
+}
+
 const JSRemoteDebuggerCfg &SpiderMonkeyDebugger::getDebuggerConf() const {
     return _cfg;
 }
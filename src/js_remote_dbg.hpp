@@ -26,10 +26,13 @@
 #include "debuggers.hpp"
 
 #include <map>
+#include <memory>
 #include <vector>
 
 #include <threads.hpp>
 #include <log.hpp>
+#include <encoding.hpp>
+#include <json_reader.hpp>
 
 #include "client.hpp"
 #include "message_builder.hpp"
@@ -37,15 +40,19 @@
 
 namespace JSR {
 
-// Command sent to the debugger engine by one of the clients.
+// Command sent to the debugger engine by one of the clients. The command
+// is converted to UTF-16 before it's queued, so the conversion doesn't
+// take the JS engine's time. Broadcasted commands are converted once and
+// shared by actions of all the contexts.
 class CommandAction : public DebuggerAction {
 public:
-    CommandAction( ClientManager &clientManager, Command &command );
+    CommandAction( ClientManager &clientManager, int clientId, const std::shared_ptr<const Utils::jstring> &command );
     virtual ~CommandAction();
     virtual ActionResult execute( JSContext *ctx, Debugger &debugger );
 private:
     ClientManager &_clientManager;
-    Command _command;
+    int _clientId;
+    std::shared_ptr<const Utils::jstring> _command;
 };
 
 // Breaks paused debugger.
@@ -77,7 +84,7 @@ typedef std::map< int, JSContextDescriptor >::iterator map_context_iterator;
  * JS engine.
  */
 class SpiderMonkeyDebugger : public Debugger,
-    public Utils::QueueSignalHandler<Command>,
+    public command_in_handler,
     protected Utils::EventHandler {
 public:
     SpiderMonkeyDebugger( ClientManager &manager, const JSRemoteDebuggerCfg &cfg );
@@ -86,6 +93,7 @@ public:
     int uninstall( JSContext *cx );
     int interrupt( JSContext *cx );
     int handlePendingCommands( JSContext *cx );
+    int getPollHandle( JSContext *cx, JSRPollHandle &handle );
     int registerDebuggee( JSContext *cx, JS::HandleObject debuggee );
     int unregisterDebuggee( JSContext *cx, JS::HandleObject debuggee );
     const JSRemoteDebuggerCfg &getDebuggerConf() const;
@@ -95,16 +103,20 @@ public:
 public:
     // JS Engine events handlers.
     int loadScript( JSContext *cx, std::string file, std::string &script );
-    bool sendCommand( int clientId, int contextId, std::string &command );
+    bool sendCommand( int clientId, int contextId, std::string &command, bool bulk );
     bool waitForCommand( JSContext *cx, bool suspended );
+    void publishResponse( JSContext *cx, const std::string &command, const std::string &key, std::string &response );
+    void revokeResponse( JSContext *cx, const std::string &command, const std::string &key );
 public:
-    void handle( command_queue &queue, int signal );
+    void handle( command_in_queue &queue, int signal );
 protected:
     void handle( Utils::Event &event );
 private:
     void sendErrorMessage( int clientId, JSR::MessageFactory::ErrorCode errorCode, const std::string &msg );
     void sendContextsList( int clientId, int contextId, const std::string &requestId );
-    void sendCommandToQueue( JSContext *ctx, action_queue &queue, Command &command );
+    void sendCommandToQueue( JSContext *ctx, action_queue &queue, const Command &command, std::shared_ptr<const Utils::jstring> &wideCommand );
+    void sendCommandToEngine( JSDebuggerEngine *engine, const Command &command, const Utils::JSONValue &request, std::shared_ptr<const Utils::jstring> &wideCommand );
+    bool checkCommand( const Command &command, Utils::JSONValue &request );
     bool isSystemCommand( const std::string &command, const std::string &commandName );
     std::string extractRequestId( const std::string &command );
 private:
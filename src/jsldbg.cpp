@@ -44,7 +44,7 @@ public:
     }
 
     // Event from debugger engine.
-    bool sendCommand( int clientId, int contextId, std::string &command ) {
+    bool sendCommand( int clientId, int contextId, std::string &command, bool bulk ) {
         return _localDebugger.handleCommand( command );
     }
 
@@ -33,6 +33,7 @@
 #include "protocol.hpp"
 #ifdef __unix__
 #include "tcp_protocol.hpp"
+#include "unix_protocol.hpp"
 #elif defined(_WIN32)
 #include "tcp_protocol_win32.hpp"
 #endif
@@ -46,7 +47,10 @@ using namespace std;
 class ClientManagerFactory {
 public:
     static ClientManager *createClientManager( const JSRemoteDebuggerCfg &cfg ) {
-        return new ClientManager();
+        ClientManager *manager = new ClientManager( cfg.getMaxClients(), cfg.getSlowClientPolicy(), cfg.getSlowClientTimeout() );
+        manager->setOverflowPolicy( Command::PRIORITY_EVENT, cfg.getEventOverflowPolicy() );
+        manager->setOverflowPolicy( Command::PRIORITY_BULK, cfg.getBulkOverflowPolicy() );
+        return manager;
     }
 };
 
@@ -60,6 +64,10 @@ public:
             return new TCPProtocol( clientManager, debugger, cfg );
 #elif defined(_WIN32)
             return new TCPProtocolWin32( clientManager, debugger, cfg );
+#endif
+#ifdef __unix__
+        case JSRemoteDebuggerCfg::PROTOCOL_UNIX_SOCKET:
+            return new UnixSocketProtocol( clientManager, debugger, cfg );
 #endif
         default:
             return nullptr;
@@ -112,6 +120,10 @@ public:
         return _debugger->handlePendingCommands(ctx);
     }
 
+    int getPollHandle( JSContext *ctx, JSRPollHandle &handle ) {
+        return _debugger->getPollHandle( ctx, handle );
+    }
+
     int start() {
 
         MutexLock lock( _mutex );
@@ -222,6 +234,10 @@ int JSRemoteDebugger::handlePendingCommands( JSContext *ctx ) {
     return _impl->handlePendingCommands( ctx );
 }
 
+int JSRemoteDebugger::getPollHandle( JSContext *ctx, JSRPollHandle &handle ) {
+    return _impl->getPollHandle( ctx, handle );
+}
+
 int JSRemoteDebugger::start() {
     return _impl->start();
 }
@@ -247,7 +263,15 @@ JSRemoteDebuggerCfg::JSRemoteDebuggerCfg( JSRProtocolType protocol, int tcpPort,
       _tcpPort( tcpPort ),
       _tcpBufferSize( tcpBufferSize ),
       _protocol(protocol),
-      _scriptLoader(nullptr) {
+      _scriptLoader(nullptr),
+      _maxClients(JSR_DEFAULT_MAX_CLIENTS),
+      _compressionThreshold(JSR_DEFAULT_COMPRESSION_THRESHOLD),
+      _unixSocketPath(JSR_DEFAULT_UNIX_SOCKET_PATH),
+      _unixSocketMode(JSR_DEFAULT_UNIX_SOCKET_MODE),
+      _slowClientPolicy(JSR_DEFAULT_SLOW_CLIENT_POLICY),
+      _slowClientTimeout(JSR_DEFAULT_SLOW_CLIENT_TIMEOUT),
+      _eventOverflowPolicy(JSR_DEFAULT_EVENT_OVERFLOW_POLICY),
+      _bulkOverflowPolicy(JSR_DEFAULT_BULK_OVERFLOW_POLICY) {
 }
 
 JSRemoteDebuggerCfg::JSRemoteDebuggerCfg( const JSRemoteDebuggerCfg &cpy ) {
@@ -256,6 +280,14 @@ JSRemoteDebuggerCfg::JSRemoteDebuggerCfg( const JSRemoteDebuggerCfg &cpy ) {
     _tcpBufferSize = cpy._tcpBufferSize;
     _protocol = cpy._protocol;
     _scriptLoader = cpy._scriptLoader;
+    _maxClients = cpy._maxClients;
+    _compressionThreshold = cpy._compressionThreshold;
+    _unixSocketPath = cpy._unixSocketPath;
+    _unixSocketMode = cpy._unixSocketMode;
+    _slowClientPolicy = cpy._slowClientPolicy;
+    _slowClientTimeout = cpy._slowClientTimeout;
+    _eventOverflowPolicy = cpy._eventOverflowPolicy;
+    _bulkOverflowPolicy = cpy._bulkOverflowPolicy;
 }
 
 JSRemoteDebuggerCfg::~JSRemoteDebuggerCfg() {
@@ -268,6 +300,14 @@ JSRemoteDebuggerCfg& JSRemoteDebuggerCfg::operator=( const JSRemoteDebuggerCfg &
         _tcpBufferSize = cpy._tcpBufferSize;
         _protocol = cpy._protocol;
         _scriptLoader = cpy._scriptLoader;
+        _maxClients = cpy._maxClients;
+        _compressionThreshold = cpy._compressionThreshold;
+        _unixSocketPath = cpy._unixSocketPath;
+        _unixSocketMode = cpy._unixSocketMode;
+        _slowClientPolicy = cpy._slowClientPolicy;
+        _slowClientTimeout = cpy._slowClientTimeout;
+        _eventOverflowPolicy = cpy._eventOverflowPolicy;
+        _bulkOverflowPolicy = cpy._bulkOverflowPolicy;
     }
     return *this;
 }
@@ -316,6 +356,74 @@ void JSRemoteDebuggerCfg::setTcpPort(int tcpPort) {
     _tcpPort = tcpPort;
 }
 
+int JSRemoteDebuggerCfg::getMaxClients() const {
+    return _maxClients;
+}
+
+void JSRemoteDebuggerCfg::setMaxClients(int maxClients) {
+    _maxClients = maxClients;
+}
+
+size_t JSRemoteDebuggerCfg::getCompressionThreshold() const {
+    return _compressionThreshold;
+}
+
+void JSRemoteDebuggerCfg::setCompressionThreshold(size_t threshold) {
+    _compressionThreshold = threshold;
+}
+
+const std::string& JSRemoteDebuggerCfg::getUnixSocketPath() const {
+    return _unixSocketPath;
+}
+
+void JSRemoteDebuggerCfg::setUnixSocketPath(const char *path) {
+    if( path != nullptr ) {
+        _unixSocketPath = path;
+    } else {
+        _unixSocketPath = "";
+    }
+}
+
+int JSRemoteDebuggerCfg::getUnixSocketMode() const {
+    return _unixSocketMode;
+}
+
+void JSRemoteDebuggerCfg::setUnixSocketMode(int mode) {
+    _unixSocketMode = mode;
+}
+
+JSRemoteDebuggerCfg::JSRSlowClientPolicy JSRemoteDebuggerCfg::getSlowClientPolicy() const {
+    return _slowClientPolicy;
+}
+
+void JSRemoteDebuggerCfg::setSlowClientPolicy(JSRSlowClientPolicy policy) {
+    _slowClientPolicy = policy;
+}
+
+int JSRemoteDebuggerCfg::getSlowClientTimeout() const {
+    return _slowClientTimeout;
+}
+
+void JSRemoteDebuggerCfg::setSlowClientTimeout(int timeout) {
+    _slowClientTimeout = timeout;
+}
+
+JSRemoteDebuggerCfg::JSROverflowPolicy JSRemoteDebuggerCfg::getEventOverflowPolicy() const {
+    return _eventOverflowPolicy;
+}
+
+void JSRemoteDebuggerCfg::setEventOverflowPolicy(JSROverflowPolicy policy) {
+    _eventOverflowPolicy = policy;
+}
+
+JSRemoteDebuggerCfg::JSROverflowPolicy JSRemoteDebuggerCfg::getBulkOverflowPolicy() const {
+    return _bulkOverflowPolicy;
+}
+
+void JSRemoteDebuggerCfg::setBulkOverflowPolicy(JSROverflowPolicy policy) {
+    _bulkOverflowPolicy = policy;
+}
+
 IJSRemoteDbg::IJSRemoteDbg() {
 }
 
@@ -77,6 +77,13 @@ string MessageFactory::prepareErrorMessage( ErrorCode errorCode, const string &m
     return ss.str();
 }
 
+string MessageFactory::prepareEngineError( EngineErrorCode errorCode, const string &msg, const string &requestId ) {
+    stringstream ss;
+    ss << "{\"type\":\"error\",\"message\":\"" << msg << "\",\"code\":" << errorCode
+       << ",\"id\":" << ( requestId.empty() ? "null" : requestId ) << "}";
+    return ss.str();
+}
+
 string MessageFactory::prepareWarningMessage( WarnCode warnCode, const string &msg ) {
     stringstream ss;
     ss << "{\"type\":\"warn\",\"code\":" << warnCode << ",\"message\":\"" << msg << "\"}";
@@ -43,11 +43,22 @@ public:
     enum WarnCode {
         CW_ENGINE_PAUSED = 1
     };
+    // Errors reported by the debugger engine (see mozjs_dbg.js).
+    enum EngineErrorCode {
+        EE_UNKNOWN_COMMAND = 1,
+        EE_NO_COMMAND_NAME = 2,
+        EE_NOT_A_COMMAND_PACKAGE = 3
+    };
     static MessageFactory *getInstance();
     std::string prepareContextList( const std::vector<JSContextState> &ctxList, const std::string &requestId );
     std::string prepareServerVersion( const std::string &version, const std::string &requestId );
     std::string prepareErrorMessage( ErrorCode errorCode, const std::string &msg );
     std::string prepareWarningMessage( WarnCode warnCode, const std::string &msg );
+    /**
+     * Prepares error the same way the debugger engine does it.
+     * @param requestId JSON encoded request ID or an empty string.
+     */
+    std::string prepareEngineError( EngineErrorCode errorCode, const std::string &msg, const std::string &requestId );
 private:
     MessageFactory();
     ~MessageFactory();
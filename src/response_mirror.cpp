@@ -0,0 +1,120 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "response_mirror.hpp"
+
+using namespace std;
+using namespace JSR;
+using namespace Utils;
+
+namespace {
+
+    // Read-only commands which can be answered by the mirror and the names
+    // of arguments which their responses depend on. The list of all the
+    // sources isn't mirrored, because scripts are collected silently.
+    struct MirroredCommand {
+        const char *name;
+        const char *key;
+    };
+
+    const MirroredCommand MIRRORED_COMMANDS[] = {
+        { "get_breakpoints", nullptr },
+        { "get_source", "url" },
+        { nullptr, nullptr }
+    };
+
+}
+
+ResponseMirror::ResponseMirror() {
+}
+
+ResponseMirror::~ResponseMirror() {
+}
+
+void ResponseMirror::publish( const string &command, const string &key, string &response ) {
+    shared_ptr<const string> body = make_shared<const string>( std::move( response ) );
+    MutexLock locker( _mutex );
+    _responses[make_pair( command, key )] = body;
+}
+
+void ResponseMirror::revoke( const string &command, const string &key ) {
+    MutexLock locker( _mutex );
+    _responses.erase( make_pair( command, key ) );
+}
+
+bool ResponseMirror::answer( const JSONValue &request, const string &raw, string &response ) {
+
+    if( !request.isObject() ) {
+        return false;
+    }
+
+    const JSONValue *type = request.find( "type" );
+    const JSONValue *name = request.find( "name" );
+    if( !type || !type->isString() || type->getString() != "command" || !name || !name->isString() ) {
+        return false;
+    }
+
+    const MirroredCommand *command = MIRRORED_COMMANDS;
+    while( command->name && name->getString() != command->name ) {
+        command++;
+    }
+    if( !command->name ) {
+        return false;
+    }
+
+    string key;
+    if( command->key ) {
+        const JSONValue *arg = request.find( command->key );
+        if( !arg || !arg->isString() ) {
+            return false;
+        }
+        key = arg->getString();
+    }
+
+    shared_ptr<const string> body;
+    {
+        MutexLock locker( _mutex );
+        response_map::const_iterator it = _responses.find( make_pair( name->getString(), key ) );
+        if( it == _responses.end() ) {
+            return false;
+        }
+        body = it->second;
+    }
+
+    if( body->size() < 2 || (*body)[body->size() - 1] != '}' ) {
+        return false;
+    }
+
+    const JSONValue *id = request.find( "id" );
+    if( id && id->isTruthy() ) {
+        // The same way the engine does, ID is the last field.
+        response.reserve( body->size() + id->getLength() + 8 );
+        response.assign( *body, 0, body->size() - 1 );
+        if( response.find_last_not_of( " \t\r\n" ) != response.find( '{' ) ) {
+            response += ',';
+        }
+        response += "\"id\":";
+        response.append( raw, id->getOffset(), id->getLength() );
+        response += '}';
+    } else {
+        response = *body;
+    }
+
+    return true;
+}
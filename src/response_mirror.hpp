@@ -0,0 +1,74 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SRC_RESPONSE_MIRROR_HPP_
+#define SRC_RESPONSE_MIRROR_HPP_
+
+#include <string>
+#include <map>
+#include <memory>
+
+#include <threads.hpp>
+#include <utils.hpp>
+#include <json_reader.hpp>
+
+namespace JSR {
+
+/**
+ * Responses to read-only commands (breakpoints, script URLs and sources)
+ * published by the debugger engine, so they can be sent straight from the
+ * protocol thread even if the JS engine is busy. The engine publishes
+ * a response once it has answered the command and revokes it as soon as
+ * the state described by the response changes. Responses are kept without
+ * the request ID, which is added to every answer separately.
+ */
+class ResponseMirror : public Utils::NonCopyable {
+public:
+    ResponseMirror();
+    ~ResponseMirror();
+public:
+    /**
+     * Publishes response to the command.
+     * @param command Name of the command.
+     * @param key Argument of the command the response is valid for, empty
+     *            if the command has no arguments (e.g. URL for 'get_source').
+     * @param response JSON encoded response, it's taken over by the mirror.
+     */
+    void publish( const std::string &command, const std::string &key, std::string &response );
+    /**
+     * Revokes response published for the command.
+     */
+    void revoke( const std::string &command, const std::string &key );
+    /**
+     * Answers the request if there is a valid response for it.
+     * @param request Parsed request.
+     * @param raw JSON encoded request the parsed one comes from.
+     * @param[out] response Response ready to be sent to the client.
+     * @return False if the request has to be handled by the engine.
+     */
+    bool answer( const Utils::JSONValue &request, const std::string &raw, std::string &response );
+private:
+    typedef std::map< std::pair<std::string, std::string>, std::shared_ptr<const std::string> > response_map;
+    Utils::Mutex _mutex;
+    response_map _responses;
+};
+
+}
+
+#endif /* SRC_RESPONSE_MIRROR_HPP_ */
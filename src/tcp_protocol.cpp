@@ -21,52 +21,213 @@
 
 #include <timestamp.hpp>
 #include <js_utils.hpp>
+#include <framing.hpp>
 
 #include <iostream>
 #include <stdio.h>
 #include <string.h>
 #include <sstream>
+#include <algorithm>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#ifdef JSR_TCP_USE_EPOLL
+#include <sys/epoll.h>
+#endif
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
 
 using namespace JSR;
 using namespace std;
 using namespace Utils;
 
-#define JSR_TCP_MAX_CLIENTS_SUPPORTED       1
+#define JSR_TCP_EPOLL_MAX_EVENTS            64
 #define JSR_TCP_DEFAULT_PORT                8089
-#define JSR_TCP_LOCAL_BUFFER                1024
+#define JSR_TCP_LOCAL_BUFFER                ( 16 * 1024 )
+#define JSR_TCP_CLIENT_QUOTA                ( 64 * 1024 )
+// How often clients with full read buffers are checked, in milliseconds.
+#define JSR_TCP_STALLED_READ_RETRY          10
 #define JSR_TCP_DEFAULT_SEPARATOR           "\n"
 #define JSR_TCP_DEFAULT_SEPARATOR_SIZE      sizeof( JSR_TCP_DEFAULT_SEPARATOR )
+// Number of I/O vectors sent at once, three per frame.
+#define JSR_TCP_MAX_IOV                     48
+// Commands are converted to frames only if there is less than this amount
+// of data waiting for the socket, so a response queued after a burst of
+// events isn't sent after all of them.
+#define JSR_TCP_STAGING_SIZE                ( 64 * 1024 )
+
+/*****************
+ * TCPOutputFrame
+ *****************/
+
+TCPOutputFrame::TCPOutputFrame()
+    : _flags(0),
+      _prefixSize(0),
+      _separatorSize(0) {
+}
+
+Command& TCPOutputFrame::getCommand() {
+    return _command;
+}
+
+bool TCPOutputFrame::compress( Deflater &deflater ) {
+    const string &value = _command.getValue();
+    if( !deflater.deflate( value.c_str(), value.size(), _compressed ) ) {
+        _compressed.clear();
+        return false;
+    }
+    _flags |= JSR_FRAME_FLAG_DEFLATE;
+    return true;
+}
+
+const string& TCPOutputFrame::getPayload() const {
+    return ( _flags & JSR_FRAME_FLAG_DEFLATE ) ? _compressed : _command.getValue();
+}
+
+void TCPOutputFrame::prepare( bool binary ) {
+    int contextId = _command.getContextId();
+    if( binary ) {
+        // Binary frames carry context ID in the header and need no separator.
+        FrameHeader header;
+        header.length = static_cast<uint32_t>( getPayload().size() );
+        header.contextId = contextId;
+        header.flags = _flags;
+        encodeFrameHeader( header, _prefix );
+        _prefixSize = JSR_FRAME_HEADER_SIZE;
+        _separatorSize = 0;
+        return;
+    }
+    // Do not send unknown context ID.
+    if( contextId != -1 ) {
+        _prefixSize = snprintf( _prefix, sizeof( _prefix ), "%d/", contextId );
+    } else {
+        _prefixSize = 0;
+    }
+    _separatorSize = JSR_TCP_DEFAULT_SEPARATOR_SIZE - 1;
+}
+
+size_t TCPOutputFrame::size() const {
+    return _prefixSize + getPayload().size() + _separatorSize;
+}
+
+int TCPOutputFrame::fill( struct iovec *iov, size_t offset ) {
+    const string &value = getPayload();
+    const char *parts[] = { _prefix, value.c_str(), JSR_TCP_DEFAULT_SEPARATOR };
+    size_t sizes[] = { _prefixSize, value.size(), _separatorSize };
+    int count = 0;
+    for( int i = 0; i < 3; i++ ) {
+        if( offset >= sizes[i] ) {
+            offset -= sizes[i];
+            continue;
+        }
+        iov[count].iov_base = const_cast<char*>( parts[i] + offset );
+        iov[count].iov_len = sizes[i] - offset;
+        offset = 0;
+        count++;
+    }
+    return count;
+}
+
+/*****************
+ * TCPWriteSignal
+ *****************/
+
+TCPWriteSignal::TCPWriteSignal()
+    : _readfd(-1),
+      _writefd(-1) {
+}
 
-namespace JSR {
+TCPWriteSignal::~TCPWriteSignal() {
+    if( _readfd != -1 ) {
+        ::close( _readfd );
+    }
+    if( _writefd != -1 && _writefd != _readfd ) {
+        ::close( _writefd );
+    }
+}
 
-    /**
-     * All commands separators supported by the protocol.
-     */
-    const char* COMMANDS_SEPARATORS[] = {
-        "\r\n",
-        "\n",
-        nullptr
-    };
+int TCPWriteSignal::init() {
+#ifdef HAVE_SYS_EVENTFD_H
+    int fd = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+    if( fd == -1 ) {
+        return JSR_ERROR_INTERNAL_PIPE_FAILED;
+    }
+    _readfd = _writefd = fd;
+#else
+    int fds[2];
+    if( ::pipe2( fds, O_NONBLOCK | O_CLOEXEC ) ) {
+        return JSR_ERROR_INTERNAL_PIPE_FAILED;
+    }
+    _readfd = fds[0];
+    _writefd = fds[1];
+#endif
+    return JSR_ERROR_NO_ERROR;
+}
+
+int TCPWriteSignal::getFD() const {
+    return _readfd;
+}
+
+void TCPWriteSignal::mark( int clientId ) {
+    bool signal;
+    {
+        MutexLock lock( _mutex );
+        signal = _dirty.empty();
+        _dirty.push_back( clientId );
+    }
+    // Only the first dirty client wakes the main thread up, the
+    // others are collected by the same drain.
+    if( signal ) {
+#ifdef HAVE_SYS_EVENTFD_H
+        uint64_t value = 1;
+#else
+        uint8_t value = 1;
+#endif
+        while( ::write( _writefd, &value, sizeof( value ) ) == -1 && errno == EINTR ) { }
+    }
+}
 
+void TCPWriteSignal::drain( std::vector<int> &clients ) {
+    // Reset the signal before the list is taken. A client marked after
+    // the list is swapped signals once again, so it cannot be missed.
+#ifdef HAVE_SYS_EVENTFD_H
+    uint64_t value;
+    while( ::read( _readfd, &value, sizeof( value ) ) == -1 && errno == EINTR ) { }
+#else
+    uint8_t buffer[64];
+    while( ::read( _readfd, buffer, sizeof( buffer ) ) > 0 || errno == EINTR ) { }
+#endif
+    clients.clear();
+    MutexLock lock( _mutex );
+    _dirty.swap( clients );
 }
 
 /************
  * TCPClient
  ************/
 
-TCPClient::TCPClient( const JSRemoteDebuggerCfg &cfg, int socket, int pipe ) :
+TCPClient::TCPClient( const JSRemoteDebuggerCfg &cfg, int socket, int pipe, TCPWriteSignal &writeSignal ) :
         Client(socket),
         _log( LoggerFactory::getLogger() ),
         _socket(socket),
         _pipe(pipe),
         _closed(false),
-        _cfg(cfg) {
+        _cfg(cfg),
+        _frameOffset(0),
+        _pendingBytes(0),
+        _writeSignal(writeSignal),
+        _writePending(false),
+        _binary(false),
+        _scanOffset(0),
+        _flowControl(false),
+        _credit(0) {
     // We are interested in new commands from debugger in order
     // to inform the server that there is something to send.
     getOutQueue().setSignalHandler(this);
@@ -102,9 +263,15 @@ bool TCPClient::isConnected() {
 }
 
 void TCPClient::handle( BlockingQueue<Command> &queue, int signal ) {
-    // Send information about something to write through
-    // the pipe which is scanned by main TCP thread.
-    sendCommand(TCPProtocol::JSR_TCP_PIPE_COMMAND_WRITE, _socket);
+    // Inform the main TCP thread that there is something to write,
+    // but only once until the thread takes care of the client.
+    if( !_writePending.exchange( true ) ) {
+        _writeSignal.mark( getID() );
+    }
+}
+
+void TCPClient::clearWritePending() {
+    _writePending.store( false );
 }
 
 // Internal API, not need to be synchronized. Used only inside thread-safe methods.
@@ -120,116 +287,270 @@ int TCPClient::getSocket() const {
 // thread-safe methods.
 bool TCPClient::handleBuffers() {
 
-    // Handles read buffer.
-    size_t pos;
+    // Handles read buffer. Broken data is reported while reading.
+    handleReadBuffer();
 
-    const char **separators = COMMANDS_SEPARATORS;
+    // Handles write buffer. Commands are taken from the queue in the order
+    // of their priorities, but only as long as there is little pending data.
+    // Everything else is left in the queue, so commands of higher priority
+    // can still overtake it.
+    BlockingQueue<Command> &queue = getOutQueue();
+    size_t stagingSize = std::min<size_t>(_cfg.getTcpBufferSize(), JSR_TCP_STAGING_SIZE);
 
-    while (*separators) {
+    while (_pendingBytes < stagingSize && (!_flowControl || _credit > 0)) {
 
-        const char *separator = *separators;
+        _frames.push_back(TCPOutputFrame());
+        TCPOutputFrame &frame = _frames.back();
 
-        if ((pos = _readBuffer.find(separator)) != string::npos) {
+        if (!queue.get(frame.getCommand())) {
+            _frames.pop_back();
+            break;
+        }
 
-            // Adds received command into the queue of the commands
-            // sent by the connected client.
-            string commandStr = _readBuffer.substr(0, pos);
+        frame.prepare(_binary);
 
-            // Check if there is context ID in the command string.
-            int contextId = -1;
-            if (!Utils::MozJSUtils::splitCommand(commandStr, contextId,
-                    commandStr)) {
-                _log.error( "TCPClient::handleBuffers: Broken context ID: %s",
-                        commandStr.c_str() );
-            }
+        if (frame.size() > _cfg.getTcpBufferSize()) {
+            // Command is bigger than TCP buffer, so it cannot be sent,
+            // just ignore it. It's checked before compression, so the
+            // deflate stream doesn't contain anything the client never gets.
+            _log.error("Command bigger than TCP buffer has been ignored.");
+            _frames.pop_back();
+            continue;
+        }
 
-            // It should be moved to some kind of protocol abstraction
-            // in the future, which would be responsible for converting content
-            // into a command.
-            Command command(getID(), contextId, commandStr);
-            BlockingQueue<Command> &queue = getInQueue();
-            if (!queue.add(command)) {
-                // Just ignore the command, maybe next time. This operation
-                // cannot block.
-                _log.warn("TCP queue for incoming commands is full.");
-            } else {
-                _readBuffer = _readBuffer.substr( pos + strlen( separator ) );
+        if (_deflater.isInitialized() && frame.getCommand().getValue().size() >= _cfg.getCompressionThreshold()) {
+            if (!frame.compress(_deflater)) {
+                // Stream is broken, so nothing can be sent anymore.
+                _log.error("TCPClient::handleBuffers: Compression failed.");
+                _frames.pop_back();
+                disconnect();
+                break;
+            }
+            frame.prepare(_binary);
+            if (frame.size() > _cfg.getTcpBufferSize()) {
+                // Incompressible data can grow a bit. It's already a part of
+                // the stream, so dropping it would break all the next frames.
+                _log.error("TCPClient::handleBuffers: Compressed command bigger than TCP buffer.");
+                _frames.pop_back();
+                disconnect();
+                break;
             }
-
-            // Command handled, so skip different separators.
-            break;
         }
 
-        separators++;
+        _pendingBytes += frame.size();
+        if (_flowControl) {
+            // The last frame can exceed the credit, otherwise commands
+            // bigger than the window would never be sent.
+            _credit -= frame.size();
+        }
+    }
 
+    if (_pendingBytes >= _cfg.getTcpBufferSize() && !queue.isEmpty()) {
+        // Maybe in the next step. For now, buffer is full.
+        _log.warn("TCP write buffer for outgoing commands is full.");
     }
 
-    // Handles write buffer.
-    Command pendingCommand;
-    BlockingQueue<Command> &queue = getOutQueue();
+    return !_frames.empty();
 
-    // Take into account that the command is removed from the queue only
-    // if it can be properly handled; otherwise it is left where it is.
-    while (queue.peek(pendingCommand)) {
-
-        // Do not send unknown context ID.
-        string commandRaw;
-        int contextId = pendingCommand.getContextId();
-        if (contextId != -1) {
-            stringstream ss;
-            ss << contextId << '/';
-            ss << pendingCommand.getValue();
-            commandRaw = ss.str();
-        } else {
-            commandRaw = pendingCommand.getValue();
-        }
+}
+
+// Checks if the line is one of the protocol lines.
+static bool isFrameLine( const char *data, size_t length, const char *line ) {
+    return length == strlen(line) && memcmp(data, line, length) == 0;
+}
+
+// Internal API, not need to be synchronized. Used only inside
+// thread-safe methods.
+int TCPClient::handleReadBuffer() {
+
+    command_in_queue &queue = getInQueue();
 
-        if ((commandRaw.size() + _writeBuffer.size() +
-                JSR_TCP_DEFAULT_SEPARATOR_SIZE ) < _cfg.getTcpBufferSize()) {
+    // All complete commands are extracted in one pass.
+    while (!_readBuffer.empty()) {
 
-            _writeBuffer.append( commandRaw );
-            _writeBuffer.append( JSR_TCP_DEFAULT_SEPARATOR );
+        size_t consumed;
+        int contextId = -1;
+        string commandStr;
 
-            queue.popOnly();
+        if (_binary) {
+
+            // Whole frame is sliced out without looking at the payload.
+            if (_readBuffer.size() < JSR_FRAME_HEADER_SIZE) {
+                break;
+            }
+
+            FrameHeader header;
+            decodeFrameHeader(_readBuffer.data(), header);
+
+            bool credit = header.flags == JSR_FRAME_FLAG_CREDIT;
+
+            if ((header.flags != 0 && !credit) || (credit && header.length != sizeof(uint32_t)) ||
+                    header.length > _cfg.getTcpBufferSize() - JSR_FRAME_HEADER_SIZE) {
+                // Frame which can never be handled.
+                _log.error("TCPClient::handleReadBuffer: Broken frame header.");
+                return JSR_ERROR_CONNECTION_CLOSED;
+            }
+
+            if (_readBuffer.size() - JSR_FRAME_HEADER_SIZE < header.length) {
+                break;
+            }
+
+            if (credit) {
+                uint32_t granted = decodeFrameUInt32(reinterpret_cast<const uint8_t*>(_readBuffer.data()) + JSR_FRAME_HEADER_SIZE);
+                consumeReadBuffer(JSR_FRAME_HEADER_SIZE + header.length);
+                grantCredit(granted);
+                continue;
+            }
+
+            commandStr.assign(_readBuffer.data() + JSR_FRAME_HEADER_SIZE, header.length);
+            contextId = header.contextId;
+            consumed = JSR_FRAME_HEADER_SIZE + header.length;
 
         } else {
 
-            // Check if there is even a chance to send it later.
-            if (commandRaw.size() > _cfg.getTcpBufferSize()) {
-                // Command is bigger than TCP buffer, so it cannot be sent,
-                // just ignore it.
-                _log.error("Command bigger than TCP buffer has been ignored.");
-                queue.popOnly();
+            // Both "\r\n" and "\n" separators are supported. Bytes which
+            // have been already scanned are not scanned again.
+            const char *data = _readBuffer.data();
+            size_t size = _readBuffer.size();
+            size_t pos = _scanOffset + scanFrame(data + _scanOffset, size - _scanOffset);
+
+            if (pos == size) {
+                _scanOffset = size;
+                break;
+            }
+
+            if (data[pos] == '\0') {
+                // Text protocol doesn't allow zeroes, malicious data.
+                return JSR_ERROR_CONNECTION_CLOSED;
             }
 
-            // Break, maybe in the next step. For now, buffer is full.
-            _log.warn("TCP write buffer for outgoing commands is full.");
+            size_t length = pos;
+            if (length > 0 && data[length - 1] == '\r') {
+                length--;
+            }
+
+            consumed = pos + 1;
+
+            bool binary = isFrameLine(data, length, JSR_FRAME_PROTOCOL_BINARY);
+            if (binary || isFrameLine(data, length, JSR_FRAME_PROTOCOL_BINARY_DEFLATE)) {
+                // Client asks for the binary framing.
+                consumeReadBuffer(consumed);
+                enableBinaryFraming(!binary);
+                continue;
+            }
+
+            uint32_t granted;
+            if (parseFrameCredit(data, length, granted)) {
+                consumeReadBuffer(consumed);
+                grantCredit(granted);
+                continue;
+            }
+
+            // Check if there is context ID in the command string. The
+            // command itself is copied exactly once, straight from the buffer.
+            size_t offset;
+            if (!Utils::MozJSUtils::splitCommand(data, length, contextId, offset)) {
+                _log.error( "TCPClient::handleReadBuffer: Broken context ID: %.*s",
+                        static_cast<int>(length), data );
+            }
+            commandStr.assign(data + offset, length - offset);
+        }
 
+        // It should be moved to some kind of protocol abstraction
+        // in the future, which would be responsible for converting content
+        // into a command.
+        Command command(getID(), contextId, std::move(commandStr));
+        if (!queue.add(std::move(command))) {
+            // Just ignore the command, maybe next time. This operation
+            // cannot block.
+            _log.warn("TCP queue for incoming commands is full.");
             break;
         }
+
+        consumeReadBuffer(consumed);
     }
 
-    return _writeBuffer.size() > 0;
+    return JSR_ERROR_NO_ERROR;
+}
+
+// Internal API, not need to be synchronized. Used only inside
+// thread-safe methods.
+void TCPClient::consumeReadBuffer( size_t size ) {
+    _readBuffer.consume(size);
+    // Scanning starts from the beginning of the next command.
+    _scanOffset = 0;
+}
 
+// Internal API, not need to be synchronized. Used only inside
+// thread-safe methods.
+void TCPClient::grantCredit( uint32_t credit ) {
+    _flowControl = true;
+    _credit += credit;
+    // Commands might be waiting for the credit, so the main
+    // thread has to take care of the client once again.
+    handle( getOutQueue(), BlockingQueue<Command>::SIGNAL_NEW_ELEMENT );
+}
+
+void TCPClient::enableBinaryFraming( bool compress ) {
+    // Client is told whether compression is really used.
+    if (compress && !_deflater.init()) {
+        _log.warn("TCPClient::enableBinaryFraming: Compression is not available.");
+        compress = false;
+    }
+    // The confirmation is the last text frame, everything queued
+    // after it is sent using binary frames.
+    _frames.push_back(TCPOutputFrame());
+    TCPOutputFrame &frame = _frames.back();
+    frame.getCommand() = Command(getID(), -1, compress ? JSR_FRAME_PROTOCOL_BINARY_DEFLATE : JSR_FRAME_PROTOCOL_BINARY);
+    frame.prepare(false);
+    _pendingBytes += frame.size();
+    _binary = true;
+    // Make sure the confirmation is sent as soon as possible.
+    handle(getOutQueue(), BlockingQueue<Command>::SIGNAL_NEW_ELEMENT);
 }
 
 // Reads data from the socket until there is anything.
 // Internal API, not need to be synchronized. Used only inside thread-safe methods.
-int TCPClient::recv() {
+int TCPClient::recv( size_t quota, bool &pending ) {
+
+    size_t received = 0;
 
-    char buffer[JSR_TCP_LOCAL_BUFFER];
+    pending = false;
 
     while( true ) {
+        if( received >= quota ) {
+            // Give the other clients a chance.
+            pending = true;
+            break;
+        }
         int available = _cfg.getTcpBufferSize() - _readBuffer.size();
         int min = available > JSR_TCP_LOCAL_BUFFER ? JSR_TCP_LOCAL_BUFFER : available;
         if( min == 0 ) {
-            // Sorry the buffer is full, client have to interpret it first.
-            _log.warn("TCPClient::recv: TCP read buffer for incoming commands is full.");
-            break;
+            // The buffer is full, so maybe there is some space in the queue now.
+            int rc = handleReadBuffer();
+            if( rc ) {
+                return rc;
+            }
+            if( isReadStalled() ) {
+                if( !getInQueue().isFull() ) {
+                    // The command doesn't fit into the buffer, so it will never
+                    // be completed. Reading further makes no sense.
+                    _log.error("TCPClient::recv: Command exceeds the TCP read buffer.");
+                    return JSR_ERROR_CONNECTION_CLOSED;
+                }
+                // Nothing can be read until the consumer takes some commands.
+                _log.warn("TCPClient::recv: TCP read buffer for incoming commands is full.");
+                break;
+            }
+            continue;
         }
+        // Data is received directly into the read buffer.
+        char *buffer = _readBuffer.reserve( min );
         int rc = ::recv( _socket, buffer, min, 0 );
         if( rc < 0 ) {
-            if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) || ( errno == EINTR ) ) {
+            if( errno == EINTR ) {
+                continue;
+            } else if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) ) {
                 // Do nothing, maybe next time something will be read.
                 return JSR_ERROR_NO_ERROR;
             } else {
@@ -241,15 +562,11 @@ int TCPClient::recv() {
             // Connection closed.
             return JSR_ERROR_CONNECTION_CLOSED;
         } else {
-            // Sanity check. Communication protocol doesn't allow zeroes.
-            size_t i;
-            for( i = 0; i < rc && buffer[i] != '\0'; i++ ) { }
-            if( i != rc ) {
-                // Malicious data, disconnect the client.
-                return JSR_ERROR_CONNECTION_CLOSED;
-            }
-            rc = fillReadBuffer( buffer, 0, rc );
-            if( rc ) {
+            received += rc;
+            _readBuffer.commit( rc );
+            // Check if there is any command which can be treated as completed
+            // one. Malicious data is found while looking for separators.
+            if( ( rc = handleReadBuffer() ) ) {
                 return rc;
             }
         }
@@ -259,38 +576,41 @@ int TCPClient::recv() {
 }
 
 // Internal API, not need to be synchronized. Used only inside thread-safe methods.
-int TCPClient::fillReadBuffer( char *buffer, int offset, size_t size ) {
-
-    if( size <= 0 ) {
-        // Nothing to read from.
-        return JSR_ERROR_NO_ERROR;
-    }
-
-    // Just in case.
-    if( _readBuffer.size() + size > _cfg.getTcpBufferSize() ) {
-        // Max buffer exceeded.
-        _log.warn("TCPClient::fillReadBuffer: Maximal size of the read buffer reached.");
-        return JSR_ERROR_OUT_OF_MEMORY;
-    }
-
-    // Append to the buffer, and check if there is any command which can be treated as completed one.
-    // Commands are separated by new line characters.
-    _readBuffer.append( string( buffer, offset, size ) );
-
-    handleBuffers();
-
-    return JSR_ERROR_NO_ERROR;
+bool TCPClient::isReadStalled() const {
+    return _readBuffer.size() >= _cfg.getTcpBufferSize();
 }
 
 // Sends data into the socket.
 // Internal API, not need to be synchronized. Used only inside thread-safe methods.
-int TCPClient::send() {
+int TCPClient::send( size_t quota, bool &pending ) {
 
-    int rc;
-    while( !_writeBuffer.empty() || handleBuffers() ) {
-        rc = ::send( _socket, _writeBuffer.c_str(), _writeBuffer.size(), 0 );
+    struct iovec iov[JSR_TCP_MAX_IOV];
+    size_t sent = 0;
+
+    pending = false;
+
+    while( !_frames.empty() || handleBuffers() ) {
+        if( sent >= quota ) {
+            // Give the other clients a chance.
+            pending = true;
+            break;
+        }
+        // Gather as many frames as possible.
+        int count = 0;
+        size_t offset = _frameOffset;
+        for( deque<TCPOutputFrame>::iterator it = _frames.begin(); it != _frames.end() && count + 3 <= JSR_TCP_MAX_IOV; it++ ) {
+            count += it->fill( iov + count, offset );
+            offset = 0;
+        }
+        struct msghdr msg;
+        ::memset( &msg, 0, sizeof( msg ) );
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        ssize_t rc = ::sendmsg( _socket, &msg, 0 );
         if( rc < 0 ) {
-            if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) || ( errno == EINTR ) ) {
+            if( errno == EINTR ) {
+                continue;
+            } else if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) ) {
                 // Do nothing, maybe next time something will be written.
                 return JSR_ERROR_WOULD_BLOCK;
             } else {
@@ -300,18 +620,41 @@ int TCPClient::send() {
             }
         } else if( rc > 0 ) {
             // Remove anything that has been already sent.
-            _writeBuffer = _writeBuffer.substr( rc );
+            consumeFrames( rc );
+            sent += rc;
         }
     }
 
     return JSR_ERROR_NO_ERROR;
 }
 
-TCPProtocol::TCPProtocol( ClientManager &clientManager, QueueSignalHandler<Command> &commandHandler, const JSRemoteDebuggerCfg &cfg) :
+// Internal API, not need to be synchronized. Used only inside thread-safe methods.
+void TCPClient::consumeFrames( size_t size ) {
+    while( size > 0 && !_frames.empty() ) {
+        size_t frameSize = _frames.front().size();
+        size_t remaining = frameSize - _frameOffset;
+        if( size >= remaining ) {
+            size -= remaining;
+            _pendingBytes -= frameSize;
+            _frames.pop_front();
+            _frameOffset = 0;
+        } else {
+            _frameOffset += size;
+            size = 0;
+        }
+    }
+}
+
+TCPProtocol::TCPProtocol( ClientManager &clientManager, command_in_handler &commandHandler, const JSRemoteDebuggerCfg &cfg) :
         _log(LoggerFactory::getLogger()),
         _clientManager(clientManager),
         _cfg(cfg),
         _serverSocket(0),
+#ifdef JSR_TCP_USE_EPOLL
+        _epollfd(-1),
+#else
+        _fdmax(0),
+#endif
         // This pointer does not escape here,
         // because this thread is not started
         // Immediately.
@@ -319,6 +662,10 @@ TCPProtocol::TCPProtocol( ClientManager &clientManager, QueueSignalHandler<Comma
         _inCommandHandler(commandHandler) {
     _pipefd[0] = 0;
     _pipefd[1] = 0;
+#ifndef JSR_TCP_USE_EPOLL
+    FD_ZERO( &_readFds );
+    FD_ZERO( &_writeFds );
+#endif
 }
 
 TCPProtocol::~TCPProtocol() {
@@ -332,6 +679,11 @@ TCPProtocol::~TCPProtocol() {
     if( _pipefd[1] ) {
         close(_pipefd[1]);
     }
+#ifdef JSR_TCP_USE_EPOLL
+    if( _epollfd != -1 ) {
+        close( _epollfd );
+    }
+#endif
 }
 
 void TCPProtocol::run() {
@@ -341,115 +693,114 @@ void TCPProtocol::run() {
     try {
 
        int rc;
-       fd_set fds;
-       fd_set read_fds;
-       fd_set write_fds;
-       int fdmax;
 
-       FD_ZERO(&fds);
-       FD_ZERO(&write_fds);
+       _clientManager.start();
 
-       int pipe = _pipefd[0];
+       while( running ) {
 
-       FD_SET(_serverSocket, &fds );
-       FD_SET( pipe, &fds );
-       fdmax = ( pipe > _serverSocket ) ? pipe : _serverSocket;
+           // Clients which exhausted their quota in the previous round. Do not
+           // block waiting for events if there are any, just poll and serve them.
+           std::map<int,int> backlog;
+           backlog.swap( _backlog );
 
-       _clientManager.start();
+           // Clients which cannot read anything are not watched, so they have
+           // to be checked from time to time.
+           int timeout = !backlog.empty() ? 0 : _stalledReads.empty() ? -1 : JSR_TCP_STALLED_READ_RETRY;
 
-       while( running ) {
+#ifdef JSR_TCP_USE_EPOLL
 
-           // Prepare read_fds again, because it might has been cleared by the "select".
-           read_fds = fds;
+           struct epoll_event events[JSR_TCP_EPOLL_MAX_EVENTS];
 
-           rc = ::select( fdmax + 1, &read_fds, &write_fds, nullptr, nullptr );
+           rc = ::epoll_wait( _epollfd, events, JSR_TCP_EPOLL_MAX_EVENTS, timeout );
 
            if ( rc == -1 ) {
                if ( errno == EINTR ) {
                    continue;
                } else {
-                   _log.error( "TCPProtocol::run: select failed with error: %d - %s.", errno, strerror( errno ) );
+                   _log.error( "TCPProtocol::run: epoll_wait failed with error: %d - %s.", errno, strerror( errno ) );
                    break;
                }
            }
 
-           for( int i = 0; i <= fdmax; i++) {
+           for( int i = 0; i < rc && running; i++ ) {
 
-               // Write data.
-               if( FD_ISSET( i, &write_fds ) ) {
-                   // Notice that client is protected from removing while the whole block is executed.
-                   ClientPtrHolder<TCPClient> client(_clientManager, i);
-                   if( client ) {
-                       if( ( rc = client->send() ) ) {
-                           if( rc != JSR_ERROR_WOULD_BLOCK ) {
-                               // Something failed, so disconnect the socket, notice
-                               // that "would block" is silently ignored and FD flag
-                               // is not cleared.
-                               disposeClient( &client, fds, write_fds, fdmax );
-                           }
-                       } else {
-                           // Clear this flag, but only if everything have been sent.
-                           clearFD( i, CBS_WRITE, fds, write_fds, fdmax );
-                       }
-                   } else {
-                       // Something wrong, there is no such a client, so clear write flag anyway.
-                       closeSocket( i, fds, write_fds, fdmax );
+               int fd = events[i].data.fd;
+               uint32_t flags = events[i].events;
+
+               if( fd == _serverSocket ) {
+                   // Accept new connection.
+                   acceptClient();
+               } else if( fd == _pipefd[0] ) {
+                   // Handle PIPE related communication.
+                   running = handlePipe();
+               } else if( fd == _writeSignal.getFD() ) {
+                   // Clients having something to write.
+                   handleWriteSignal();
+               } else {
+                   // Errors and hang-ups are reported by the send and recv calls.
+                   bool alive = true;
+                   if( flags & ( EPOLLOUT | EPOLLERR | EPOLLHUP ) ) {
+                       alive = handleWrite( fd );
+                   }
+                   if( alive && ( flags & ( EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP ) ) ) {
+                       handleRead( fd );
                    }
                }
+           }
 
-               // Read data.
-               if( FD_ISSET( i, &read_fds ) ) {
+#else
 
-                   // Accept new connection.
-                   if( i == _serverSocket ) {
+           // Work on copies, because sets are modified by the "select".
+           fd_set read_fds = _readFds;
+           fd_set write_fds = _writeFds;
+           int fdmax = _fdmax;
 
-                       // Store the client under its socket.
-                       acceptClient( fds, fdmax );
+           struct timeval wait = { 0, timeout * 1000 };
 
-                   // Handle PIPE related communication.
-                   } else if ( i == pipe ) {
-
-                       // Reads command and arguments from pipe.
-                       uint8_t command;
-                       uint32_t socket;
-                       if( recvCommand( pipe, command, socket ) ) {
-                            if( command == JSR_TCP_PIPE_COMMAND_DISCONNECT ) {
-                                // Disconnect the socket.
-                                commandDisconnectClient( socket, fds, write_fds, fdmax );
-                            } else if( command == JSR_TCP_PIPE_COMMAND_WRITE ) {
-                                // Mark socket as "I have something to write..."
-                                commandMarkWrite( socket, write_fds, fdmax );
-                            } else if( command == JSR_TCP_PIPE_COMMAND_EXIT ) {
-                                // Close the debugger.
-                                running = false;
-                                break;
-                            }
-                       } else {
-                           _log.error("TCPProtocol::run: Reading from PIPE failed: %d.", errno);
-                       }
+           rc = ::select( fdmax + 1, &read_fds, &write_fds, nullptr, timeout < 0 ? nullptr : &wait );
+
+           if ( rc == -1 ) {
+               if ( errno == EINTR ) {
+                   continue;
+               } else {
+                   _log.error( "TCPProtocol::run: select failed with error: %d - %s.", errno, strerror( errno ) );
+                   break;
+               }
+           }
+
+           for( int i = 0; i <= fdmax && running; i++) {
+
+               bool alive = true;
+
+               // Write data.
+               if( FD_ISSET( i, &write_fds ) ) {
+                   alive = handleWrite( i );
+               }
 
+               // Read data.
+               if( alive && FD_ISSET( i, &read_fds ) ) {
+                   if( i == _serverSocket ) {
+                       // Accept new connection.
+                       acceptClient();
+                   } else if ( i == _pipefd[0] ) {
+                       // Handle PIPE related communication.
+                       running = handlePipe();
+                   } else if ( i == _writeSignal.getFD() ) {
+                       // Clients having something to write.
+                       handleWriteSignal();
                    } else {
-                       // Client received data.
-                       ClientPtrHolder<TCPClient> client(_clientManager, i);
-                       if( client ) {
-                           bool disconnect = false;
-                           if( ( rc = client->recv() ) ) {
-                               if( ( rc != JSR_ERROR_NO_ERROR ) ) {
-                                   // No matter what, just disconnect the client.
-                                   disconnect = true;
-                               }
-                           }
-                           if( disconnect ) {
-                               disposeClient( &client,  fds, write_fds, fdmax );
-                           }
-                       } else {
-                           // Unknown client, just disconnect it. It should never happen.
-                           closeSocket( i, fds, write_fds, fdmax );
-                       }
+                       handleRead( i );
                    }
                }
            }
 
+#endif
+
+           if( running ) {
+               serviceBacklog( backlog );
+               serviceStalledReads();
+           }
+
            _clientManager.periodicCleanup();
        }
 
@@ -479,20 +830,170 @@ void TCPProtocol::run() {
 }
 
 /**
- * Marks client's socket as 'I would like to write something' if
- * there is anything in the client's output buffer.
+ * Reads one command from the pipe and executes it. Returns false
+ * if the main loop should be stopped.
  */
-void TCPProtocol::commandMarkWrite( int socket, fd_set &write_fds, int &fdmax ) {
+bool TCPProtocol::handlePipe() {
+    // Reads command and arguments from pipe.
+    uint8_t command;
+    uint32_t socket;
+    if( recvCommand( _pipefd[0], command, socket ) ) {
+        if( command == JSR_TCP_PIPE_COMMAND_DISCONNECT ) {
+            // Disconnect the socket.
+            commandDisconnectClient( socket );
+        } else if( command == JSR_TCP_PIPE_COMMAND_EXIT ) {
+            // Close the debugger.
+            return false;
+        }
+    } else {
+        _log.error("TCPProtocol::handlePipe: Reading from PIPE failed: %d.", errno);
+    }
+    return true;
+}
+
+/**
+ * Reads all the available data from the client's socket.
+ */
+void TCPProtocol::handleRead( int socket ) {
+    // Notice that client is protected from removing while the whole block is executed.
     ClientPtrHolder<TCPClient> client(_clientManager, socket);
     if( client ) {
-        if( client->handleBuffers() ) {
-            FD_SET (client->getSocket(), &write_fds);
-            if( fdmax < client->getSocket() ) {
-                fdmax = client->getSocket();
-            }
+        bool pending;
+        if( client->recv( JSR_TCP_CLIENT_QUOTA, pending ) != JSR_ERROR_NO_ERROR ) {
+            // No matter what, just disconnect the client.
+            disposeClient( &client );
+        } else if( client->isReadStalled() ) {
+            // Polling the socket makes no sense until the consumer
+            // takes some commands from the client's queue.
+            watchRead( socket, false );
+            _stalledReads.insert( socket );
+            markBacklog( socket, BACKLOG_READ, false );
+        } else {
+            markBacklog( socket, BACKLOG_READ, pending );
         }
     } else {
-        _log.error("Unknown socket read from pipe: %d", socket);
+        // Unknown client, the event is stale. It should never happen.
+        forgetSocket( socket );
+    }
+}
+
+/**
+ * Sends pending data to the client's socket. Returns false if
+ * the client has been disposed.
+ */
+bool TCPProtocol::handleWrite( int socket ) {
+    // Notice that client is protected from removing while the whole block is executed.
+    ClientPtrHolder<TCPClient> client(_clientManager, socket);
+    if( !client ) {
+        // Something wrong, there is no such a client, so forget the socket anyway.
+        forgetSocket( socket );
+        return false;
+    }
+    bool pending;
+    int rc = client->send( JSR_TCP_CLIENT_QUOTA, pending );
+    if( rc == JSR_ERROR_NO_ERROR ) {
+        if( !pending ) {
+            // Everything have been sent.
+            watchWrite( socket, false );
+        }
+        markBacklog( socket, BACKLOG_WRITE, pending );
+    } else if( rc == JSR_ERROR_WOULD_BLOCK ) {
+        // Wait until the socket is writable again.
+        watchWrite( socket, true );
+        markBacklog( socket, BACKLOG_WRITE, false );
+    } else {
+        // Something failed, so disconnect the socket.
+        disposeClient( &client );
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Remembers or forgets that the socket has some work pending
+ * because it has exhausted its quota.
+ */
+void TCPProtocol::markBacklog( int socket, int flag, bool pending ) {
+    if( pending ) {
+        _backlog[socket] |= flag;
+    } else {
+        std::map<int,int>::iterator it = _backlog.find( socket );
+        if( it != _backlog.end() ) {
+            it->second &= ~flag;
+            if( !it->second ) {
+                _backlog.erase( it );
+            }
+        }
+    }
+}
+
+/**
+ * Continues work for clients which exhausted their quota in
+ * the previous round. Work already done in the current round
+ * because of a new event is skipped.
+ */
+void TCPProtocol::serviceBacklog( std::map<int,int> &backlog ) {
+    for( std::map<int,int>::iterator it = backlog.begin(); it != backlog.end(); it++ ) {
+        int socket = it->first;
+        int flags = it->second;
+        std::map<int,int>::iterator served = _backlog.find( socket );
+        if( served != _backlog.end() ) {
+            flags &= ~served->second;
+        }
+        // The client might have been disposed in the meantime.
+        ClientPtrHolder<TCPClient> client(_clientManager, socket);
+        if( !client ) {
+            continue;
+        }
+        bool alive = true;
+        if( flags & BACKLOG_WRITE ) {
+            alive = handleWrite( socket );
+        }
+        if( alive && ( flags & BACKLOG_READ ) ) {
+            handleRead( socket );
+        }
+    }
+}
+
+/**
+ * Resumes reading for clients which have some space in their
+ * queues of incoming commands again.
+ */
+void TCPProtocol::serviceStalledReads() {
+    std::set<int>::iterator it = _stalledReads.begin();
+    while( it != _stalledReads.end() ) {
+        int socket = *it;
+        ClientPtrHolder<TCPClient> client(_clientManager, socket);
+        if( !client ) {
+            _stalledReads.erase( it++ );
+        } else if( !client->getInQueue().isFull() ) {
+            _stalledReads.erase( it++ );
+            watchRead( socket, true );
+            // Edge-triggered sockets do not report data which
+            // is already there, so it has to be read now.
+            handleRead( socket );
+        } else {
+            it++;
+        }
+    }
+}
+
+/**
+ * Takes all the clients which have something in their output queues
+ * and tries to send pending data immediately. The socket is watched
+ * for writing only if the data cannot be sent at once.
+ */
+void TCPProtocol::handleWriteSignal() {
+    _writeSignal.drain( _dirtyClients );
+    for( vector<int>::iterator it = _dirtyClients.begin(); it != _dirtyClients.end(); it++ ) {
+        ClientPtrHolder<TCPClient> client(_clientManager, *it);
+        if( client ) {
+            // Commands queued from now on mark the client once again.
+            client->clearWritePending();
+            if( client->handleBuffers() ) {
+                handleWrite( *it );
+            }
+        }
     }
 }
 
@@ -500,10 +1001,10 @@ void TCPProtocol::commandMarkWrite( int socket, fd_set &write_fds, int &fdmax )
  * Reads client's id from the pipe and tries to dispose given client
  * if there is any for given id.
  */
-void TCPProtocol::commandDisconnectClient( int socket, fd_set &read_fds, fd_set &write_fds, int &fdmax ) {
+void TCPProtocol::commandDisconnectClient( int socket ) {
     ClientPtrHolder<TCPClient> client(_clientManager, socket);
     if( client ) {
-        disposeClient( &client, read_fds, write_fds, fdmax );
+        disposeClient( &client );
     } else {
         _log.error("Unknown socket read from pipe: %d", socket);
     }
@@ -512,10 +1013,11 @@ void TCPProtocol::commandDisconnectClient( int socket, fd_set &read_fds, fd_set
 /**
  * Accepts newly connected client and adds the client to the clients manager.
  */
-void TCPProtocol::acceptClient( fd_set &read_fd, int &fdmax ) {
+void TCPProtocol::acceptClient() {
 
-    struct sockaddr_in clientName = {0};
-    unsigned int size;
+    // Subclasses may use different address families.
+    struct sockaddr_storage clientName;
+    socklen_t size;
 
     int clientSocket;
     size = sizeof( clientName );
@@ -530,34 +1032,49 @@ void TCPProtocol::acceptClient( fd_set &read_fd, int &fdmax ) {
     if ( ( ( flags = ::fcntl( clientSocket, F_GETFL, 0 ) ) < 0 ) ||
             ( ::fcntl( clientSocket, F_SETFL, flags | O_NONBLOCK ) < 0 ) ) {
         _log.error( " TCPProtocol::acceptClient: fcntl failed with error: %d.", errno );
+        ::close(clientSocket);
         return;
     }
 
+    // Frames are already gathered into as few writes as possible, so
+    // waiting for ACKs would only delay answers to pipelined commands.
+    if( clientName.ss_family == AF_INET || clientName.ss_family == AF_INET6 ) {
+        int noDelay = 1;
+        if( ::setsockopt( clientSocket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof( noDelay ) ) < 0 ) {
+            _log.warn( "TCPProtocol::acceptClient: setsockopt failed with error: %d.", errno );
+        }
+    }
+
     int rc;
 
-    TCPClient *tcpClient = new TCPClient( _cfg, clientSocket, _pipefd[1] );
+    TCPClient *tcpClient = new TCPClient( _cfg, clientSocket, _pipefd[1], _writeSignal );
     tcpClient->getInQueue().setSignalHandler( &_inCommandHandler );
 
     if( ( rc = _clientManager.addClient( tcpClient ) ) ) {
+        if( rc == JSR_ERROR_TOO_MANY_CLIENTS ) {
+            _log.warn( "TCPProtocol::acceptClient: Connection rejected, too many clients." );
+        }
+        // Client closes its socket on its own.
         delete tcpClient;
-        ::close(clientSocket);
-    } else {
-        FD_SET (clientSocket, &read_fd);
-        if( fdmax < clientSocket ) {
-            fdmax = clientSocket;
+    } else if( !watchSocket( clientSocket, true ) ) {
+        ClientPtrHolder<TCPClient> client(_clientManager, clientSocket);
+        if( client ) {
+            disposeClient( &client );
         }
     }
 
 }
 
-void TCPProtocol::disposeClient( TCPClient *client, fd_set &read_fds, fd_set &write_fds, int &fdmax ) {
+void TCPProtocol::disposeClient( TCPClient *client ) {
 
     // Disconnect the connection. This operation is very safe because
     // client do not expose this socket directly. Whole communication
     // is realized using dedicated buffers on the main loop thread.
     int socket = client->getSocket();
+    unwatchSocket( socket );
+    _backlog.erase( socket );
+    _stalledReads.erase( socket );
     client->closeSocket();
-    clearFD( socket, CBS_ALL, read_fds, write_fds, fdmax );
 
     // Remove the client.
     _clientManager.removeClient(client);
@@ -608,40 +1125,139 @@ void TCPProtocol::sendCommand( int pipe, uint8_t command, uint32_t args ) {
     } while( rc == -1 && again <= 3 );
 }
 
+#ifdef JSR_TCP_USE_EPOLL
+
 /**
- * Closes socket and clears its bit inside all available bit sets.
+ * Creates epoll instance and registers the server socket and the
+ * pipe in it. Both of them are level-triggered.
  */
-void TCPProtocol::closeSocket( int socket, fd_set &read_fds, fd_set &write_fds, int &fdmax ) {
-    ::close( socket );
-    clearFD( socket, CBS_ALL, read_fds, write_fds, fdmax );
+int TCPProtocol::initPoller() {
+    _epollfd = ::epoll_create1( EPOLL_CLOEXEC );
+    if( _epollfd == -1 ) {
+        _log.error("TCPProtocol::initPoller: epoll_create1 failed %d.", errno);
+        return JSR_ERROR_POLLER_FAILED;
+    }
+    if( !watchSocket( _serverSocket, false ) || !watchSocket( _pipefd[0], false ) ||
+            !watchSocket( _writeSignal.getFD(), false ) ) {
+        ::close( _epollfd );
+        _epollfd = -1;
+        return JSR_ERROR_POLLER_FAILED;
+    }
+    return JSR_ERROR_NO_ERROR;
 }
 
 /**
- * Clears socket's bit inside all provided bit sets.
+ * Registers descriptor in the epoll instance. Edge-triggered descriptors
+ * are watched for both reading and writing from the very beginning, so
+ * they never have to be modified later.
  */
-void TCPProtocol::clearFD( int fd, ClearBitSet setType, fd_set &read_fds, fd_set &write_fds, int &fdmax ) {
-    // Clear disconnected client.
-    if( setType == CBS_READ || setType == CBS_ALL) {
-        FD_CLR( fd, &read_fds );
-    }
-    if( setType == CBS_WRITE || setType == CBS_ALL) {
-        FD_CLR( fd, &write_fds );
-    }
-    if( fd == fdmax ) {
-        fdmax = 0;
-        for( int i = 0; i < FD_SETSIZE; i++ ) {
-           if( FD_ISSET( i, &read_fds ) || FD_ISSET( i, &write_fds ) ) {
-               fdmax = i;
+bool TCPProtocol::watchSocket( int fd, bool edgeTriggered ) {
+    struct epoll_event event = {0};
+    event.data.fd = fd;
+    event.events = EPOLLIN;
+    if( edgeTriggered ) {
+        event.events |= EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    }
+    if( ::epoll_ctl( _epollfd, EPOLL_CTL_ADD, fd, &event ) == -1 ) {
+        _log.error("TCPProtocol::watchSocket: epoll_ctl failed for %d with %d.", fd, errno);
+        return false;
+    }
+    return true;
+}
+
+void TCPProtocol::watchWrite( int fd, bool enable ) {
+    // Nothing to do here, edge-triggered sockets report
+    // EPOLLOUT every time they become writable again.
+}
+
+void TCPProtocol::watchRead( int fd, bool enable ) {
+    // Nothing to do here either, edge-triggered sockets do not
+    // report the same data twice, even if it's left unread.
+}
+
+void TCPProtocol::unwatchSocket( int fd ) {
+    if( ::epoll_ctl( _epollfd, EPOLL_CTL_DEL, fd, nullptr ) == -1 ) {
+        _log.error("TCPProtocol::unwatchSocket: epoll_ctl failed for %d with %d.", fd, errno);
+    }
+}
+
+void TCPProtocol::forgetSocket( int fd ) {
+    // Closed descriptors are removed from the epoll set by the kernel,
+    // so there is nothing to forget. Never touch the descriptor here,
+    // because its number might have been already reused.
+    _log.debug("TCPProtocol::forgetSocket: Stale event for socket: %d.", fd);
+}
+
+#else
+
+int TCPProtocol::initPoller() {
+    if( !watchSocket( _serverSocket, false ) || !watchSocket( _pipefd[0], false ) ||
+            !watchSocket( _writeSignal.getFD(), false ) ) {
+        return JSR_ERROR_POLLER_FAILED;
+    }
+    return JSR_ERROR_NO_ERROR;
+}
+
+bool TCPProtocol::watchSocket( int fd, bool edgeTriggered ) {
+    if( fd >= FD_SETSIZE ) {
+        _log.error("TCPProtocol::watchSocket: Descriptor %d exceeds FD_SETSIZE.", fd);
+        return false;
+    }
+    FD_SET( fd, &_readFds );
+    if( _fdmax < fd ) {
+        _fdmax = fd;
+    }
+    return true;
+}
+
+void TCPProtocol::watchWrite( int fd, bool enable ) {
+    if( enable ) {
+        FD_SET( fd, &_writeFds );
+        if( _fdmax < fd ) {
+            _fdmax = fd;
+        }
+    } else {
+        FD_CLR( fd, &_writeFds );
+    }
+}
+
+void TCPProtocol::watchRead( int fd, bool enable ) {
+    if( enable ) {
+        FD_SET( fd, &_readFds );
+        if( _fdmax < fd ) {
+            _fdmax = fd;
+        }
+    } else {
+        FD_CLR( fd, &_readFds );
+    }
+}
+
+/**
+ * Clears socket's bit inside all available bit sets.
+ */
+void TCPProtocol::unwatchSocket( int fd ) {
+    FD_CLR( fd, &_readFds );
+    FD_CLR( fd, &_writeFds );
+    if( fd == _fdmax ) {
+        _fdmax = 0;
+        for( int i = 0; i < fd; i++ ) {
+           if( FD_ISSET( i, &_readFds ) || FD_ISSET( i, &_writeFds ) ) {
+               _fdmax = i;
            }
         }
     }
 }
 
-int TCPProtocol::init() {
+void TCPProtocol::forgetSocket( int fd ) {
+    unwatchSocket( fd );
+}
+
+#endif
+
+int TCPProtocol::bindServerSocket( int &serverSocket ) {
 
     // Create socket and bind it into the IP and port from configuration.
 
-    int serverSocket;
     struct sockaddr_in serverIp;
 
     if( ( serverSocket = ::socket( AF_INET, SOCK_STREAM, 0 ) ) == -1 ) {
@@ -677,8 +1293,21 @@ int TCPProtocol::init() {
         return JSR_ERROR_CANNOT_BIND_SOCKET;
     }
 
-    // Currently only one client is supported.
-    if( ::listen( serverSocket, JSR_TCP_MAX_CLIENTS_SUPPORTED ) == -1 ) {
+    return JSR_ERROR_NO_ERROR;
+}
+
+int TCPProtocol::init() {
+
+    int serverSocket;
+
+    int rc = bindServerSocket( serverSocket );
+    if( rc ) {
+        return rc;
+    }
+
+    // Clients exceeding the limit are rejected by the clients manager.
+    int backlog = _cfg.getMaxClients() > 0 ? _cfg.getMaxClients() : SOMAXCONN;
+    if( ::listen( serverSocket, backlog ) == -1 ) {
         _log.error("TCPProtocol::init: listen failed %d.", errno);
         ::close( serverSocket );
         return JSR_ERROR_CANNOT_LISTEN_TO_SOCKET;
@@ -691,8 +1320,28 @@ int TCPProtocol::init() {
         return JSR_ERROR_INTERNAL_PIPE_FAILED;
     }
 
+    // Prepare signal used by clients having something to write.
+    if( _writeSignal.init() ) {
+        _log.error("TCPProtocol::init: Cannot create write signal %d.", errno);
+        ::close( _pipefd[0] );
+        ::close( _pipefd[1] );
+        _pipefd[0] = _pipefd[1] = 0;
+        ::close( serverSocket );
+        return JSR_ERROR_INTERNAL_PIPE_FAILED;
+    }
+
     _serverSocket = serverSocket;
 
+    rc = initPoller();
+    if( rc ) {
+        ::close( _pipefd[0] );
+        ::close( _pipefd[1] );
+        _pipefd[0] = _pipefd[1] = 0;
+        ::close( _serverSocket );
+        _serverSocket = 0;
+        return rc;
+    }
+
     return JSR_ERROR_NO_ERROR;
 }
 
@@ -22,22 +22,115 @@
 
 #include <stdint.h>
 #include <map>
+#include <set>
 #include <vector>
+#include <deque>
 #include <string>
+#include <atomic>
+
+#ifdef HAVE_SYS_EPOLL_H
+// Edge-triggered epoll is used whenever it's available, so the cost
+// of every wakeup depends on the number of ready descriptors only.
+#define JSR_TCP_USE_EPOLL
+#else
+#include <sys/select.h>
+#endif
 
 #include <jsrdbg.h>
 #include "client.hpp"
 #include "protocol.hpp"
 #include <threads.hpp>
+#include <byte_buffer.hpp>
+#include <compression.hpp>
 #include <utils.hpp>
 #include <log.hpp>
 
+struct iovec;
+
 namespace JSR {
 
+/**
+ * Command waiting to be sent. Its context ID prefix, payload and separator
+ * are sent straight from here using scatter-gather I/O, so the payload is
+ * never copied into an intermediate buffer.
+ */
+class TCPOutputFrame {
+public:
+    TCPOutputFrame();
+    /**
+     * Gets command carried by the frame.
+     */
+    Command& getCommand();
+    /**
+     * Replaces the payload with its compressed version. Works only for
+     * binary frames, the frame has to be prepared again afterwards.
+     * @return False if compression failed.
+     */
+    bool compress( Utils::Deflater &deflater );
+    /**
+     * Prepares frame's prefix. Has to be called once the command is set.
+     * @param binary True if binary framing should be used.
+     */
+    void prepare( bool binary );
+    /**
+     * Gets size of the whole frame in bytes.
+     */
+    size_t size() const;
+    /**
+     * Fills I/O vectors with parts of the frame starting at given offset.
+     * @return Number of vectors filled, at most 3.
+     */
+    int fill( struct iovec *iov, size_t offset );
+private:
+    const std::string& getPayload() const;
+private:
+    Command _command;
+    // Compressed payload if the frame is compressed.
+    std::string _compressed;
+    uint32_t _flags;
+    char _prefix[16];
+    size_t _prefixSize;
+    size_t _separatorSize;
+};
+
+/**
+ * Wakes the main protocol thread up when clients have something to write.
+ * Notifications are coalesced: a client is put on the list of dirty clients
+ * only once until the list is drained and the descriptor is signaled only
+ * if the list was empty, so a burst of commands costs a single syscall.
+ * An eventfd is used if it's available, a pipe otherwise.
+ */
+class TCPWriteSignal : protected Utils::NonCopyable {
+public:
+    TCPWriteSignal();
+    ~TCPWriteSignal();
+public:
+    int init();
+    /**
+     * Gets descriptor which becomes readable when there are dirty clients.
+     */
+    int getFD() const;
+    /**
+     * Puts the client on the list of dirty clients.
+     */
+    void mark( int clientId );
+    /**
+     * Takes all the dirty clients and clears the signal.
+     * @param clients Vector the clients are swapped into.
+     */
+    void drain( std::vector<int> &clients );
+private:
+    Utils::Mutex _mutex;
+    std::vector<int> _dirty;
+    // Both are the same descriptor in case of eventfd.
+    int _readfd;
+    int _writefd;
+};
+
 class TCPClient : public Client, protected Utils::QueueSignalHandler<Command>, protected Utils::NonCopyable {
 public:
 
-    TCPClient( const JSRemoteDebuggerCfg &cfg, int socket, int pipe );
+    TCPClient( const JSRemoteDebuggerCfg &cfg, int socket, int pipe, TCPWriteSignal &writeSignal );
     virtual ~TCPClient();
 
 public:
@@ -47,13 +140,26 @@ public:
      * read buffer which is then interpreted in order to identity
      * incoming commands. By default commands are separated
      * by new line characters.
+     * @param quota Maximal number of bytes read at once, so one
+     *              client cannot starve the others.
+     * @param pending Set to true if reading stopped before the socket
+     *                was drained.
      */
-    int recv();
+    int recv( size_t quota, bool &pending );
 
     /**
      * Sets pending data through the client socket.
+     * @param quota Maximal number of bytes sent at once.
+     * @param pending Set to true if sending stopped because the quota
+     *                has been exhausted.
+     */
+    int send( size_t quota, bool &pending );
+
+    /**
+     * Tells whether the read buffer is full, so nothing can be read
+     * until the queue of incoming commands has some space again.
      */
-    int send();
+    bool isReadStalled() const;
 
     /**
      * Handles read and write buffers. Read buffers are interpreted and
@@ -72,6 +178,12 @@ public:
      */
     int getSocket() const;
 
+    /**
+     * Clears the flag set when new commands are queued. Has to be called
+     * before the queue is drained, so none of the commands is missed.
+     */
+    void clearWritePending();
+
     // Client.
     void disconnect();
     bool isConnected();
@@ -82,7 +194,7 @@ protected:
      * Every client is also a signal handler. Signals are sent
      * by the BlockingQueues just in order to inform interested parts
      * about new elements put in them. In case of TCP client such a signal
-     * is then sent through the pipe just to wake up the main thread
+     * marks the client as dirty just to wake up the main thread
      * responsible for carrying out the network transmission.
      */
     void handle( Utils::BlockingQueue<Command> &queue, int signal );
@@ -95,9 +207,32 @@ private:
     void sendCommand( uint8_t command, uint32_t args );
 
     /**
-     * Adds bytes to client's read buffer.
+     * Extracts all the complete commands from the read buffer and puts
+     * them into the queue of incoming commands.
+     * @return Error code if the data breaks the protocol.
+     */
+    int handleReadBuffer();
+
+    /**
+     * Drops bytes of the extracted command from the read buffer.
+     */
+    void consumeReadBuffer( size_t size );
+
+    /**
+     * Switches the connection to the binary framing.
+     * @param compress True if client asked for compression.
+     */
+    void enableBinaryFraming( bool compress );
+
+    /**
+     * Adds credit granted by the client and switches flow control on.
+     */
+    void grantCredit( uint32_t credit );
+
+    /**
+     * Drops given number of sent bytes from the pending frames.
      */
-    int fillReadBuffer( char *buffer, int offset, size_t size );
+    void consumeFrames( size_t size );
 
 protected:
     // Shared logger.
@@ -105,9 +240,8 @@ protected:
 private:
     // Used for internal state synchronization.
     Utils::Mutex _mutex;
-    // Buffers used for buffering commands which are reading now.
-    std::string _readBuffer;
-    std::string _writeBuffer;
+    // Buffer used for buffering commands which are reading now.
+    Utils::ByteBuffer _readBuffer;
     // TCP/IP socket.
     int _socket;
     // Pipe used to inform the main thread
@@ -117,6 +251,29 @@ private:
     bool _closed;
     // Configuration.
     const JSRemoteDebuggerCfg &_cfg;
+    // Commands waiting to be sent.
+    std::deque<TCPOutputFrame> _frames;
+    // Number of bytes of the first frame already sent.
+    size_t _frameOffset;
+    // Number of bytes in all the pending frames.
+    size_t _pendingBytes;
+    // Signal used to inform the main thread about pending commands.
+    TCPWriteSignal &_writeSignal;
+    // True if the client has been already marked as dirty.
+    std::atomic<bool> _writePending;
+    // True if length-prefixed binary framing has been negotiated.
+    bool _binary;
+    // Compresses big outgoing frames if client asked for it.
+    Utils::Deflater _deflater;
+    // Number of bytes in the read buffer which have been already
+    // scanned for the command separator.
+    size_t _scanOffset;
+    // True if the client has granted any credit, so data is sent only
+    // as long as there is credit left.
+    bool _flowControl;
+    // Number of bytes which can be still sent, can go below zero
+    // because frames are never split.
+    int64_t _credit;
 };
 
 /**
@@ -127,18 +284,11 @@ public:
 
     /* Pipe commands. */
     enum Commands {
-       JSR_TCP_PIPE_COMMAND_WRITE = 1,
-       JSR_TCP_PIPE_COMMAND_DISCONNECT,
+       JSR_TCP_PIPE_COMMAND_DISCONNECT = 1,
        JSR_TCP_PIPE_COMMAND_EXIT
     };
 
-    enum ClearBitSet {
-        CBS_READ,
-        CBS_WRITE,
-        CBS_ALL
-    };
-
-    TCPProtocol( ClientManager &clientManager, Utils::QueueSignalHandler<Command> &commandHandler, const JSRemoteDebuggerCfg &cfg );
+    TCPProtocol( ClientManager &clientManager, command_in_handler &commandHandler, const JSRemoteDebuggerCfg &cfg );
     virtual ~TCPProtocol();
 public:
     virtual int init();
@@ -149,15 +299,40 @@ public:
 protected:
     void run();
     void interrupt();
+    /**
+     * Creates server socket and binds it to the address
+     * taken from the configuration.
+     * @param[out] serverSocket Bound socket.
+     * @return Error code.
+     */
+    virtual int bindServerSocket( int &serverSocket );
 private:
+    // Work which couldn't be done in one round because of the client's quota.
+    enum BacklogFlags {
+        BACKLOG_READ = 1,
+        BACKLOG_WRITE = 2
+    };
+    // Events dispatching.
+    bool handlePipe();
+    void handleWriteSignal();
+    void handleRead( int socket );
+    bool handleWrite( int socket );
+    void markBacklog( int socket, int flag, bool pending );
+    void serviceBacklog( std::map<int,int> &backlog );
+    void serviceStalledReads();
     // PIPE commands.
-    void commandMarkWrite( int socket, fd_set &write_fds, int &fdmax );
-    void commandDisconnectClient( int socket, fd_set &read_fds, fd_set &write_fds, int &fdmax );
+    void commandDisconnectClient( int socket );
+private:
+    // Descriptors multiplexing, implemented by the selected backend.
+    int initPoller();
+    bool watchSocket( int fd, bool edgeTriggered );
+    void watchWrite( int fd, bool enable );
+    void watchRead( int fd, bool enable );
+    void unwatchSocket( int fd );
+    void forgetSocket( int fd );
 private:
-    void clearFD( int fd, ClearBitSet setType, fd_set &read_fds, fd_set &write_fds, int &fdmax );
-    void closeSocket( int socket, fd_set &read_fds, fd_set &write_fds, int &fdmax );
-    void acceptClient( fd_set &read_fd, int &fdmax );
-    void disposeClient( TCPClient *client, fd_set &read_fds, fd_set &write_fds, int &fdmax );
+    void acceptClient();
+    void disposeClient( TCPClient *client );
     bool recvCommand(int pipe, uint8_t &command, uint32_t &arg);
 protected:
     Utils::Logger &_log;
@@ -166,8 +341,24 @@ private:
     JSRemoteDebuggerCfg _cfg;
     int _serverSocket;
     int _pipefd[2];
+    // Clients having something to write.
+    TCPWriteSignal _writeSignal;
+    std::vector<int> _dirtyClients;
+    // Sockets which have exhausted their quota, mapped to BacklogFlags.
+    std::map<int,int> _backlog;
+    // Sockets which are not read because their clients' read buffers are full.
+    std::set<int> _stalledReads;
+#ifdef JSR_TCP_USE_EPOLL
+    // Epoll instance watching the server socket, the pipe and all the clients.
+    int _epollfd;
+#else
+    // Descriptors watched for reading and writing.
+    fd_set _readFds;
+    fd_set _writeFds;
+    int _fdmax;
+#endif
     Utils::Thread _thread;
-    Utils::QueueSignalHandler<Command> &_inCommandHandler;
+    command_in_handler &_inCommandHandler;
 };
 
 }
@@ -24,6 +24,7 @@
 #include <timestamp.hpp>
 #include <utils.hpp>
 #include <js_utils.hpp>
+#include <framing.hpp>
 
 #include <stdio.h>
 #include <assert.h>
@@ -40,11 +41,14 @@
 using namespace JSR;
 using namespace Utils;
 
-#define JSR_TCP_MAX_CLIENTS_SUPPORTED       1
 #define JSR_TCP_DEFAULT_PORT                8089
 #define JSR_TCP_LOCAL_BUFFER                1024
 #define JSR_TCP_DEFAULT_SEPARATOR           "\n"
 #define JSR_TCP_DEFAULT_SEPARATOR_SIZE      sizeof( JSR_TCP_DEFAULT_SEPARATOR )
+// Commands are moved to the write buffer only if there is less than this
+// amount of data waiting for the socket, so commands of higher priority
+// can still overtake the rest of them.
+#define JSR_TCP_STAGING_SIZE                ( 64 * 1024 )
 
 namespace {
 
@@ -77,19 +81,6 @@ void winSockCleanup() {
 
 }
 
-namespace JSR {
-
-    /**
-     * All commands separators supported by the protocol.
-     */
-    const char* COMMANDS_SEPARATORS[] = {
-        "\r\n",
-        "\n",
-        nullptr
-    };
-
-}
-
 /************
  * TCPClient
  ************/
@@ -100,6 +91,9 @@ TCPClientWin32::TCPClientWin32( const JSRemoteDebuggerCfg &cfg, SOCKET clientSoc
         _socket(clientSocket),
         _writeEvent(nullptr),
         _closed(false),
+        _hasPendingCommand(false),
+        _flowControl(false),
+        _credit(0),
         _cfg(cfg) {
 
     _writeEvent = WSACreateEvent();
@@ -165,86 +159,104 @@ HANDLE TCPClientWin32::getWriteEvent() const {
 // thread-safe methods.
 bool TCPClientWin32::handleBuffers() {
 
-    // Handles read buffer.
+    // Handles read buffer. Both "\r\n" and "\n" separators are supported.
     size_t pos;
 
-    const char **separators = COMMANDS_SEPARATORS;
+    if ((pos = _readBuffer.find('\n')) != std::string::npos) {
+
+        size_t length = pos;
+        if (length > 0 && _readBuffer.data()[length - 1] == '\r') {
+            length--;
+        }
 
-    while (*separators) {
+        const char *data = _readBuffer.data();
+        uint32_t credit;
 
-        const char *separator = *separators;
+        if (parseFrameCredit(data, length, credit)) {
 
-        if ((pos = _readBuffer.find(separator)) != std::string::npos) {
+            // Client limits the amount of data sent to it.
+            _readBuffer.consume( pos + 1 );
+            _flowControl = true;
+            _credit += credit;
 
-            // Adds received command into the queue of the commands
-            // sent by the connected client.
-            std::string commandStr = _readBuffer.substr(0, pos);
+        } else {
 
             // Check if there is context ID in the command string.
             int contextId = -1;
-            if (!Utils::MozJSUtils::splitCommand(commandStr, contextId,
-                    commandStr)) {
-                _log.error( "TCPClientWin32::handleBuffers: Broken context ID: %s",
-                        commandStr.c_str() );
+            size_t offset;
+            if (!Utils::MozJSUtils::splitCommand(data, length, contextId, offset)) {
+                _log.error( "TCPClientWin32::handleBuffers: Broken context ID: %.*s",
+                        static_cast<int>(length), data );
             }
 
+            // Adds received command into the queue of the commands
+            // sent by the connected client.
+            std::string commandStr(data + offset, length - offset);
+
             // It should be moved to some kind of protocol abstraction
             // in the future, which would be responsible for converting content
             // into a command.
-            Command command(getID(), contextId, commandStr);
-            BlockingQueue<Command> &queue = getInQueue();
-            if (!queue.add(command)) {
+            Command command(getID(), contextId, std::move(commandStr));
+            command_in_queue &queue = getInQueue();
+            if (!queue.add(std::move(command))) {
                 // Just ignore the command, maybe next time. This operation
                 // cannot block.
                 _log.warn("TCP queue for incoming commands is full.");
             } else {
-                _readBuffer = _readBuffer.substr( pos + strlen( separator ) );
+                _readBuffer.consume( pos + 1 );
             }
 
-            // Command handled, so skip different separators.
-            break;
         }
 
-        separators++;
-
     }
 
     // Handles write buffer.
-    Command pendingCommand;
     BlockingQueue<Command> &queue = getOutQueue();
 
-    // Take into account that the command is removed from the queue only
-    // if it can be properly handled; otherwise it is left where it is.
-    while (queue.peek(pendingCommand)) {
+    // Command which cannot be handled yet is kept aside instead of being
+    // left in the queue, because a command of higher priority could be
+    // the first one there next time.
+    size_t stagingSize = std::min<size_t>(_cfg.getTcpBufferSize(), JSR_TCP_STAGING_SIZE);
+
+    while (_writeBuffer.size() < stagingSize && (!_flowControl || _credit > 0) &&
+            (_hasPendingCommand || queue.get(_pendingCommand))) {
+
+        _hasPendingCommand = true;
 
         // Do not send unknown context ID.
-        std::string commandRaw;
-        int contextId = pendingCommand.getContextId();
+        char prefix[16];
+        int prefixSize = 0;
+        int contextId = _pendingCommand.getContextId();
         if (contextId != -1) {
-            std::stringstream ss;
-            ss << contextId << '/';
-            ss << pendingCommand.getValue();
-            commandRaw = ss.str();
-        } else {
-            commandRaw = pendingCommand.getValue();
+            prefixSize = snprintf( prefix, sizeof( prefix ), "%d/", contextId );
         }
 
-        if ((commandRaw.size() + _writeBuffer.size() +
+        const std::string &value = _pendingCommand.getValue();
+        size_t commandSize = prefixSize + value.size();
+
+        if ((commandSize + _writeBuffer.size() +
                 JSR_TCP_DEFAULT_SEPARATOR_SIZE ) < _cfg.getTcpBufferSize()) {
 
-            _writeBuffer.append( commandRaw );
-            _writeBuffer.append( JSR_TCP_DEFAULT_SEPARATOR );
+            _writeBuffer.append( prefix, prefixSize );
+            _writeBuffer.append( value );
+            _writeBuffer.append( JSR_TCP_DEFAULT_SEPARATOR, JSR_TCP_DEFAULT_SEPARATOR_SIZE - 1 );
+
+            if (_flowControl) {
+                _credit -= commandSize + JSR_TCP_DEFAULT_SEPARATOR_SIZE - 1;
+            }
 
-            queue.popOnly();
+            _pendingCommand = Command();
+            _hasPendingCommand = false;
 
         } else {
 
             // Check if there is even a chance to send it later.
-            if (commandRaw.size() > _cfg.getTcpBufferSize()) {
+            if (commandSize > _cfg.getTcpBufferSize()) {
                 // Command is bigger than TCP buffer, so it cannot be sent,
                 // just ignore it.
                 _log.error("Command bigger than TCP buffer has been ignored.");
-                queue.popOnly();
+                _pendingCommand = Command();
+                _hasPendingCommand = false;
             }
 
             // Break, maybe in the next step. For now, buffer is full.
@@ -293,9 +305,7 @@ int TCPClientWin32::recv() {
         }
         else {
             // Sanity check. Communication protocol doesn't allow zeroes.
-            int i;
-            for( i = 0; i < bytes_received && buffer[i] != '\0'; i++ ) { }
-            if( i != bytes_received ) {
+            if( ::memchr( buffer, '\0', bytes_received ) ) {
                 // Malicious data, disconnect the client.
                 return JSR_ERROR_CONNECTION_CLOSED;
             }
@@ -327,7 +337,7 @@ int TCPClientWin32::fillReadBuffer( char *buffer, int offset, size_t size ) {
 
     // Append to the buffer, and check if there is any command which can be treated as completed one.
     // Commands are separated by new line characters.
-    _readBuffer.append( std::string( buffer, offset, size ) );
+    _readBuffer.append( buffer + offset, size );
 
     handleBuffers();
 
@@ -339,7 +349,7 @@ int TCPClientWin32::fillReadBuffer( char *buffer, int offset, size_t size ) {
 int TCPClientWin32::send() {
 
     while( !_writeBuffer.empty() || handleBuffers() ) {
-        int bytes_send = ::send( _socket, _writeBuffer.c_str(), _writeBuffer.size(), 0 );
+        int bytes_send = ::send( _socket, _writeBuffer.data(), static_cast<int>( _writeBuffer.size() ), 0 );
         if( bytes_send == SOCKET_ERROR ) {
             auto err = WSAGetLastError();
             if( ( err == WSAEWOULDBLOCK ) || ( err == WSAEINTR ) ) {
@@ -354,7 +364,7 @@ int TCPClientWin32::send() {
         }
         else if( bytes_send > 0 ) {
             // Remove anything that has been already sent.
-            _writeBuffer = _writeBuffer.substr( bytes_send );
+            _writeBuffer.consume( bytes_send );
         }
     }
 
@@ -365,7 +375,7 @@ int TCPClientWin32::send() {
  * TCPServer
  ************/
 
-TCPProtocolWin32::TCPProtocolWin32( ClientManager &clientManager, QueueSignalHandler<Command> &commandHandler, const JSRemoteDebuggerCfg &cfg) :
+TCPProtocolWin32::TCPProtocolWin32( ClientManager &clientManager, command_in_handler &commandHandler, const JSRemoteDebuggerCfg &cfg) :
         _clientManager(clientManager),
         _log(LoggerFactory::getLogger()),
         _cfg(cfg),
@@ -665,7 +675,7 @@ int TCPProtocolWin32::init() {
         return JSR_ERROR_INTERNAL_PIPE_FAILED;
     }
 
-    // TODO: How many clients can we support? JSR_TCP_MAX_CLIENTS_SUPPORTED | SOMAXCONN
+    // Clients exceeding the limit are rejected by the clients manager.
 
     if ( listen( serverSocket, SOMAXCONN ) == SOCKET_ERROR ) {
         _log.error("TCPProtocolWin32::init: listen failed");
@@ -35,6 +35,7 @@
 #include "client.hpp"
 #include "protocol.hpp"
 #include <threads.hpp>
+#include <byte_buffer.hpp>
 #include <utils.hpp>
 #include <log.hpp>
 
@@ -102,12 +103,19 @@ private:
     Utils::Logger &_log;
     Utils::Mutex _mutex;
     // Buffers used for buffering commands which are reading now.
-    std::string _readBuffer;
-    std::string _writeBuffer;
+    Utils::ByteBuffer _readBuffer;
+    Utils::ByteBuffer _writeBuffer;
     // Client socket.
     SOCKET _socket;
     WSAEVENT _writeEvent;
     bool _closed;
+    // Command taken from the output queue which hasn't fit into
+    // the write buffer yet.
+    Command _pendingCommand;
+    bool _hasPendingCommand;
+    // Credit granted by the client, see framing.hpp.
+    bool _flowControl;
+    int64_t _credit;
     const JSRemoteDebuggerCfg &_cfg;
 };
 
@@ -118,7 +126,7 @@ class TCPProtocolWin32 final : public Protocol, protected Utils::Runnable {
 public:
 
     TCPProtocolWin32( ClientManager &clientManager,
-        Utils::QueueSignalHandler<Command> &commandHandler,
+        command_in_handler &commandHandler,
         const JSRemoteDebuggerCfg &cfg );
     ~TCPProtocolWin32();
 
@@ -141,7 +149,7 @@ private:
     JSRemoteDebuggerCfg _cfg;
     SOCKET _serverSocket;
     Utils::Thread _thread;
-    Utils::QueueSignalHandler<Command> &_inCommandHandler;
+    command_in_handler &_inCommandHandler;
     HANDLE _stopEvent;
     WSAEVENT _networkEvent;
 };
@@ -0,0 +1,106 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "unix_protocol.hpp"
+
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <errno.h>
+
+using namespace JSR;
+using namespace std;
+using namespace Utils;
+
+UnixSocketProtocol::UnixSocketProtocol( ClientManager &clientManager, command_in_handler &commandHandler, const JSRemoteDebuggerCfg &cfg )
+    : TCPProtocol( clientManager, commandHandler, cfg ),
+      _path( cfg.getUnixSocketPath() ),
+      _mode( cfg.getUnixSocketMode() ),
+      _bound( false ) {
+}
+
+UnixSocketProtocol::~UnixSocketProtocol() {
+    if( _bound ) {
+        ::unlink( _path.c_str() );
+    }
+}
+
+int UnixSocketProtocol::bindServerSocket( int &serverSocket ) {
+
+    struct sockaddr_un address;
+
+    if( _path.empty() || _path.size() >= sizeof( address.sun_path ) ) {
+        _log.error("UnixSocketProtocol::init: Invalid socket path: %s", _path.c_str());
+        return JSR_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    if( ( serverSocket = ::socket( AF_UNIX, SOCK_STREAM, 0 ) ) == -1 ) {
+        _log.error("UnixSocketProtocol::init: Cannot create server socket: %d", errno);
+        return JSR_ERROR_CANNOT_CREATE_SOCKET;
+    }
+
+    ::memset( &address, 0, sizeof( address ) );
+    address.sun_family = AF_UNIX;
+    ::strncpy( address.sun_path, _path.c_str(), sizeof( address.sun_path ) - 1 );
+
+    // Socket left by a previous instance which hasn't been stopped
+    // correctly. Other files are never removed and neither are sockets
+    // which are still in use by another debuggee.
+    struct stat info;
+    if( ::lstat( _path.c_str(), &info ) == 0 && S_ISSOCK( info.st_mode ) ) {
+        if( !isStaleSocket( address ) ) {
+            _log.error("UnixSocketProtocol::init: Socket is already in use: %s", _path.c_str());
+            ::close( serverSocket );
+            return JSR_ERROR_CANNOT_BIND_SOCKET;
+        }
+        ::unlink( _path.c_str() );
+    }
+
+    if( ::bind( serverSocket, (struct sockaddr *)&address, sizeof( address ) ) == -1 ) {
+        _log.error("UnixSocketProtocol::init: bind failed %d.", errno);
+        ::close( serverSocket );
+        return JSR_ERROR_CANNOT_BIND_SOCKET;
+    }
+
+    _bound = true;
+
+    // Nobody is able to connect before the socket starts listening,
+    // so permissions can be safely changed after binding.
+    if( ::chmod( _path.c_str(), _mode ) == -1 ) {
+        _log.error("UnixSocketProtocol::init: chmod failed %d.", errno);
+        ::close( serverSocket );
+        return JSR_ERROR_CANNOT_CHANGE_SOCKET_OPTS;
+    }
+
+    return JSR_ERROR_NO_ERROR;
+}
+
+bool UnixSocketProtocol::isStaleSocket( const struct sockaddr_un &address ) {
+    int probe = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+    if( probe == -1 ) {
+        return false;
+    }
+    // Nobody listens on the socket only if the connection is refused, any
+    // other error (e.g. full backlog) means that it might be still in use.
+    bool stale = ::connect( probe, (const struct sockaddr *)&address, sizeof( address ) ) == -1 && errno == ECONNREFUSED;
+    ::close( probe );
+    return stale;
+}
@@ -0,0 +1,59 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef JSR_SRC_UNIX_PROTOCOL_H_
+#define JSR_SRC_UNIX_PROTOCOL_H_
+
+#include <string>
+
+#include "tcp_protocol.hpp"
+
+struct sockaddr_un;
+
+namespace JSR {
+
+/**
+ * Protocol working on top of a Unix domain socket. Clients and the whole
+ * events loop are shared with the TCP/IP protocol, only the server socket
+ * is different. Access to the debugger is controlled by permissions of
+ * the socket file.
+ */
+class UnixSocketProtocol : public TCPProtocol {
+public:
+    UnixSocketProtocol( ClientManager &clientManager, command_in_handler &commandHandler, const JSRemoteDebuggerCfg &cfg );
+    virtual ~UnixSocketProtocol();
+protected:
+    virtual int bindServerSocket( int &serverSocket );
+private:
+    /**
+     * Checks whether nobody listens on the existing socket file.
+     */
+    bool isStaleSocket( const struct sockaddr_un &address );
+private:
+    // Path of the socket file.
+    std::string _path;
+    // Permissions of the socket file.
+    int _mode;
+    // True if the socket file has been created by this instance.
+    bool _bound;
+};
+
+}
+
+#endif /* JSR_SRC_UNIX_PROTOCOL_H_ */
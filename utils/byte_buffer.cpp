@@ -0,0 +1,105 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "byte_buffer.hpp"
+
+#include <string.h>
+
+using namespace Utils;
+
+#define BYTE_BUFFER_MIN_CAPACITY    4096
+
+ByteBuffer::ByteBuffer( size_t capacity )
+    : _buffer( capacity ),
+      _readPos( 0 ),
+      _writePos( 0 ) {
+}
+
+ByteBuffer::~ByteBuffer() {
+}
+
+const char* ByteBuffer::data() const {
+    return _buffer.empty() ? nullptr : &_buffer[_readPos];
+}
+
+size_t ByteBuffer::size() const {
+    return _writePos - _readPos;
+}
+
+bool ByteBuffer::empty() const {
+    return _writePos == _readPos;
+}
+
+char* ByteBuffer::reserve( size_t size ) {
+    if( _buffer.size() - _writePos < size ) {
+        size_t unread = _writePos - _readPos;
+        if( _readPos > 0 && _readPos >= unread && _buffer.size() - unread >= size ) {
+            // Most of the storage has been already consumed, so it's
+            // cheap to move the rest to the beginning.
+            ::memmove( &_buffer[0], &_buffer[_readPos], unread );
+            _readPos = 0;
+            _writePos = unread;
+        } else {
+            size_t capacity = _buffer.size() ? _buffer.size() : BYTE_BUFFER_MIN_CAPACITY;
+            while( capacity - _writePos < size ) {
+                capacity *= 2;
+            }
+            _buffer.resize( capacity );
+        }
+    }
+    return &_buffer[_writePos];
+}
+
+void ByteBuffer::commit( size_t size ) {
+    _writePos += size;
+}
+
+void ByteBuffer::append( const char *data, size_t size ) {
+    if( size > 0 ) {
+        ::memcpy( reserve( size ), data, size );
+        commit( size );
+    }
+}
+
+void ByteBuffer::append( const std::string &data ) {
+    append( data.c_str(), data.size() );
+}
+
+void ByteBuffer::consume( size_t size ) {
+    if( size >= _writePos - _readPos ) {
+        // Everything consumed, so the whole storage can be reused.
+        clear();
+    } else {
+        _readPos += size;
+    }
+}
+
+void ByteBuffer::clear() {
+    _readPos = 0;
+    _writePos = 0;
+}
+
+size_t ByteBuffer::find( char c, size_t offset ) const {
+    if( offset >= size() ) {
+        return std::string::npos;
+    }
+    const char *start = data();
+    const char *found = static_cast<const char*>( ::memchr( start + offset, c, size() - offset ) );
+    return found ? static_cast<size_t>( found - start ) : std::string::npos;
+}
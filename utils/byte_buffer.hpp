@@ -0,0 +1,90 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SRC_BYTE_BUFFER_H_
+#define SRC_BYTE_BUFFER_H_
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include "utils.hpp"
+
+namespace Utils {
+
+/**
+ * Contiguous byte buffer with separate read and write cursors. Consumed
+ * data is never copied; the read cursor is just moved forward. Unread data
+ * is moved to the beginning of the storage only when there is no space
+ * left at its end and at least half of the storage has been consumed, so
+ * the cost of compaction is amortized over the consumed bytes. The storage
+ * itself is reused, so no allocations are made once the buffer is warm.
+ */
+class ByteBuffer : public NonCopyable {
+public:
+    explicit ByteBuffer( size_t capacity = 0 );
+    ~ByteBuffer();
+public:
+    /**
+     * Gets pointer to the first unread byte.
+     */
+    const char* data() const;
+    /**
+     * Gets number of unread bytes.
+     */
+    size_t size() const;
+    bool empty() const;
+    /**
+     * Makes sure that there are at least 'size' bytes available for
+     * writing at the end of the buffer and returns pointer to them. Data
+     * written there becomes visible after it's committed.
+     */
+    char* reserve( size_t size );
+    /**
+     * Marks 'size' bytes written to the reserved space as readable.
+     */
+    void commit( size_t size );
+    /**
+     * Appends data at the end of the buffer.
+     */
+    void append( const char *data, size_t size );
+    void append( const std::string &data );
+    /**
+     * Drops 'size' bytes from the beginning of the buffer.
+     */
+    void consume( size_t size );
+    /**
+     * Drops all the unread bytes.
+     */
+    void clear();
+    /**
+     * Finds the first occurrence of the character starting
+     * from the given offset.
+     * @return Offset of the character or std::string::npos.
+     */
+    size_t find( char c, size_t offset = 0 ) const;
+private:
+    std::vector<char> _buffer;
+    size_t _readPos;
+    size_t _writePos;
+};
+
+}
+
+#endif /* SRC_BYTE_BUFFER_H_ */
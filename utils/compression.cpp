@@ -0,0 +1,214 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "compression.hpp"
+
+#ifdef HAVE_ZLIB_H
+#include <string.h>
+#include <zlib.h>
+#endif
+
+using namespace Utils;
+
+#define COMPRESSION_CHUNK_SIZE  ( 16 * 1024 )
+
+#ifdef HAVE_ZLIB_H
+
+Deflater::Deflater()
+    : _stream(nullptr) {
+}
+
+Deflater::~Deflater() {
+    if( _stream ) {
+        z_stream *stream = static_cast<z_stream*>( _stream );
+        deflateEnd( stream );
+        delete stream;
+    }
+}
+
+bool Deflater::isSupported() {
+    return true;
+}
+
+bool Deflater::init( int level ) {
+    if( _stream ) {
+        return true;
+    }
+    z_stream *stream = new z_stream;
+    ::memset( stream, 0, sizeof( z_stream ) );
+    if( deflateInit( stream, level ) != Z_OK ) {
+        delete stream;
+        return false;
+    }
+    _stream = stream;
+    return true;
+}
+
+bool Deflater::isInitialized() const {
+    return _stream != nullptr;
+}
+
+bool Deflater::deflate( const char *data, size_t size, std::string &out ) {
+    if( !_stream ) {
+        return false;
+    }
+    z_stream *stream = static_cast<z_stream*>( _stream );
+    stream->next_in = reinterpret_cast<Bytef*>( const_cast<char*>( data ) );
+    stream->avail_in = static_cast<uInt>( size );
+    size_t offset = out.size();
+    // Output is usually much smaller than the input, so start with
+    // the bound and grow only if it's really needed.
+    size_t available = deflateBound( stream, static_cast<uLong>( size ) ) + 16;
+    do {
+        out.resize( offset + available );
+        stream->next_out = reinterpret_cast<Bytef*>( &out[offset] );
+        stream->avail_out = static_cast<uInt>( available );
+        // Sync flush makes everything available for the receiver.
+        int rc = ::deflate( stream, Z_SYNC_FLUSH );
+        if( rc != Z_OK && rc != Z_BUF_ERROR ) {
+            out.resize( offset );
+            return false;
+        }
+        offset += available - stream->avail_out;
+        available = COMPRESSION_CHUNK_SIZE;
+    } while( stream->avail_out == 0 );
+    out.resize( offset );
+    return true;
+}
+
+Inflater::Inflater()
+    : _stream(nullptr) {
+}
+
+Inflater::~Inflater() {
+    if( _stream ) {
+        z_stream *stream = static_cast<z_stream*>( _stream );
+        inflateEnd( stream );
+        delete stream;
+    }
+}
+
+bool Inflater::isSupported() {
+    return true;
+}
+
+bool Inflater::init() {
+    if( _stream ) {
+        return true;
+    }
+    z_stream *stream = new z_stream;
+    ::memset( stream, 0, sizeof( z_stream ) );
+    if( inflateInit( stream ) != Z_OK ) {
+        delete stream;
+        return false;
+    }
+    _stream = stream;
+    return true;
+}
+
+bool Inflater::isInitialized() const {
+    return _stream != nullptr;
+}
+
+bool Inflater::inflate( const char *data, size_t size, std::string &out, size_t maxSize ) {
+    if( !_stream ) {
+        return false;
+    }
+    z_stream *stream = static_cast<z_stream*>( _stream );
+    stream->next_in = reinterpret_cast<Bytef*>( const_cast<char*>( data ) );
+    stream->avail_in = static_cast<uInt>( size );
+    size_t offset = out.size();
+    size_t available = size * 4 > COMPRESSION_CHUNK_SIZE ? size * 4 : COMPRESSION_CHUNK_SIZE;
+    // One byte over the limit tells data which fills the limit exactly
+    // from data which doesn't fit.
+    size_t limit = maxSize + 1 > maxSize ? maxSize + 1 : maxSize;
+    do {
+        if( offset + available > limit ) {
+            if( offset >= limit ) {
+                out.resize( offset );
+                return false;
+            }
+            available = limit - offset;
+        }
+        out.resize( offset + available );
+        stream->next_out = reinterpret_cast<Bytef*>( &out[offset] );
+        stream->avail_out = static_cast<uInt>( available );
+        int rc = ::inflate( stream, Z_SYNC_FLUSH );
+        if( rc != Z_OK && rc != Z_BUF_ERROR ) {
+            out.resize( offset );
+            return false;
+        }
+        offset += available - stream->avail_out;
+        available *= 2;
+    } while( stream->avail_out == 0 );
+    out.resize( offset );
+    return stream->avail_in == 0;
+}
+
+#else
+
+// Compression is not available without zlib.
+
+Deflater::Deflater()
+    : _stream(nullptr) {
+}
+
+Deflater::~Deflater() {
+}
+
+bool Deflater::isSupported() {
+    return false;
+}
+
+bool Deflater::init( int level ) {
+    return false;
+}
+
+bool Deflater::isInitialized() const {
+    return false;
+}
+
+bool Deflater::deflate( const char *data, size_t size, std::string &out ) {
+    return false;
+}
+
+Inflater::Inflater()
+    : _stream(nullptr) {
+}
+
+Inflater::~Inflater() {
+}
+
+bool Inflater::isSupported() {
+    return false;
+}
+
+bool Inflater::init() {
+    return false;
+}
+
+bool Inflater::isInitialized() const {
+    return false;
+}
+
+bool Inflater::inflate( const char *data, size_t size, std::string &out, size_t maxSize ) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SRC_COMPRESSION_H_
+#define SRC_COMPRESSION_H_
+
+#include <stddef.h>
+#include <string>
+
+#include "utils.hpp"
+
+namespace Utils {
+
+/**
+ * Streaming deflate compressor. Every call compresses the next part of
+ * the same stream and flushes it, so the receiver is able to decompress
+ * each part as soon as it arrives while the dictionary is shared between
+ * all of them. Works only if the library has been built with zlib.
+ */
+class Deflater : public NonCopyable {
+public:
+    Deflater();
+    ~Deflater();
+public:
+    /**
+     * Returns true if compression is available at all.
+     */
+    static bool isSupported();
+    /**
+     * Initializes the stream.
+     * @param level Compression level from 1 to 9 or -1 for the default one.
+     * @return False if the stream cannot be initialized.
+     */
+    bool init( int level = -1 );
+    bool isInitialized() const;
+    /**
+     * Compresses data and appends the result to the output string.
+     * @return False if compression failed, the stream cannot be used anymore.
+     */
+    bool deflate( const char *data, size_t size, std::string &out );
+private:
+    // Opaque zlib stream, so zlib headers are not needed here.
+    void *_stream;
+};
+
+/**
+ * Streaming counterpart of the Deflater.
+ */
+class Inflater : public NonCopyable {
+public:
+    Inflater();
+    ~Inflater();
+public:
+    static bool isSupported();
+    bool init();
+    bool isInitialized() const;
+    /**
+     * Decompresses the next part of the stream and appends the result
+     * to the output string.
+     * @param maxSize Maximum size of the decompressed data.
+     * @return False if data is broken or exceeds the limit.
+     */
+    bool inflate( const char *data, size_t size, std::string &out, size_t maxSize );
+private:
+    void *_stream;
+};
+
+}
+
+#endif /* SRC_COMPRESSION_H_ */
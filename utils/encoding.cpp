@@ -20,9 +20,133 @@
 #include "encoding.hpp"
 
 #include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
 
 using namespace Utils;
 
+// Converters kept by a single thread, a few encodings are used at most.
+#define ICONV_CACHE_MAX_SIZE    8
+
+namespace {
+
+    struct CachedConverter {
+        std::string source;
+        std::string destination;
+        iconv_t cd;
+        // Converter is used by a conversion in progress.
+        bool used;
+    };
+
+    typedef std::vector<CachedConverter> ThreadConverters;
+
+#ifdef _WIN32
+    void WINAPI destroyConverters( void *data ) {
+#else
+    void destroyConverters( void *data ) {
+#endif
+        ThreadConverters *converters = static_cast<ThreadConverters*>( data );
+        if( converters ) {
+            for( ThreadConverters::iterator it = converters->begin(); it != converters->end(); ++it ) {
+                ::iconv_close( it->cd );
+            }
+            delete converters;
+        }
+    }
+
+    /*
+     * Slot for converters of every thread. Allocated while the library is
+     * loaded, so it doesn't depend on thread safe initialization of local
+     * statics. Converters are destroyed when the thread exits.
+     */
+    struct ConvertersSlot {
+        ConvertersSlot() {
+#ifdef _WIN32
+            _index = ::FlsAlloc( destroyConverters );
+            _available = _index != FLS_OUT_OF_INDEXES;
+#else
+            _available = ::pthread_key_create( &_key, destroyConverters ) == 0;
+#endif
+        }
+        // Gets converters of the calling thread or NULL if there is no slot.
+        ThreadConverters* get() {
+            if( !_available ) {
+                return NULL;
+            }
+#ifdef _WIN32
+            ThreadConverters *converters = static_cast<ThreadConverters*>( ::FlsGetValue( _index ) );
+#else
+            ThreadConverters *converters = static_cast<ThreadConverters*>( ::pthread_getspecific( _key ) );
+#endif
+            if( !converters ) {
+                converters = new ThreadConverters();
+#ifdef _WIN32
+                bool stored = ::FlsSetValue( _index, converters ) != FALSE;
+#else
+                bool stored = ::pthread_setspecific( _key, converters ) == 0;
+#endif
+                if( !stored ) {
+                    delete converters;
+                    return NULL;
+                }
+            }
+            return converters;
+        }
+    private:
+#ifdef _WIN32
+        DWORD _index;
+#else
+        pthread_key_t _key;
+#endif
+        bool _available;
+    };
+
+    ConvertersSlot convertersSlot;
+
+}
+
+iconv_t IconvCache::acquire( const std::string &source, const std::string &destination ) {
+    ThreadConverters *converters = convertersSlot.get();
+    if( converters ) {
+        for( ThreadConverters::iterator it = converters->begin(); it != converters->end(); ++it ) {
+            if( !it->used && it->source == source && it->destination == destination ) {
+                it->used = true;
+                // Drop the shift state left by the previous conversion.
+                ::iconv( it->cd, NULL, NULL, NULL, NULL );
+                return it->cd;
+            }
+        }
+    }
+    return ::iconv_open( destination.c_str(), source.c_str() );
+}
+
+void IconvCache::release( const std::string &source, const std::string &destination, iconv_t cd ) {
+    ThreadConverters *converters = convertersSlot.get();
+    if( converters ) {
+        for( ThreadConverters::iterator it = converters->begin(); it != converters->end(); ++it ) {
+            if( it->cd == cd ) {
+                it->used = false;
+                return;
+            }
+        }
+        if( converters->size() < ICONV_CACHE_MAX_SIZE ) {
+            CachedConverter converter;
+            converter.source = source;
+            converter.destination = destination;
+            converter.cd = cd;
+            converter.used = false;
+            converters->push_back( converter );
+            return;
+        }
+    }
+    ::iconv_close( cd );
+}
+
 EncodingFailedException::EncodingFailedException( const std::string& msg )
     : _msg(msg) {
 }
@@ -35,6 +35,8 @@
 #include <langinfo.h>
 #endif
 
+#include "unicode.hpp"
+
 namespace Utils {
 
 #define WCE_LOCAL_BUFF_LEN          1024
@@ -48,12 +50,32 @@ private:
     std::string _msg;
 };
 
+/**
+ * Cache of iconv converters owned by the calling thread, so converters are
+ * not opened for every single conversion. Converter is marked as used until
+ * it's released, so nested conversions never share the same one.
+ */
+class IconvCache {
+public:
+    /**
+     * Takes unused converter from the cache or opens a new one if there is none.
+     * Cached converters are reset to their initial state.
+     * @return Converter or (iconv_t)-1 if iconv_open failed.
+     */
+    static iconv_t acquire( const std::string &source, const std::string &destination );
+    /**
+     * Gives the converter back to the cache. It's closed if the cache is full.
+     */
+    static void release( const std::string &source, const std::string &destination, iconv_t cd );
+};
+
 typedef std::basic_string<jschar> jstring;
 typedef std::basic_stringstream<jschar> jstringstream;
 
 /**
  * Converts MBS characters into the wide characters. MBS characters are
- * always treated as encoded using default environment encoding.
+ * always treated as encoded using default environment encoding. Conversions
+ * between UTF-8 and UTF-16 in the native byte order don't use iconv at all.
  */
 template<typename T>
 class WideCharEncoder {
@@ -69,6 +91,7 @@ public:
         _envCharSet = ::nl_langinfo(CODESET);
 #endif
         _wideCharSet = encoding;
+        _nativeUTF16 = sizeof(T) == sizeof(uint16_t) && _wideCharSet == "UTF-16LE" && isNativeUTF16LE();
     }
     virtual ~WideCharEncoder() {
     }
@@ -81,7 +104,14 @@ public:
      * @param str String encoded in UTF-8.
      * @return String represented using wide characters.
      */
-    virtual tstring utf8ToWide( const std::string str ) {
+    virtual tstring utf8ToWide( const std::string &str ) {
+        if( _nativeUTF16 ) {
+            tstring result( getUTF16Length( str.data(), str.size() ), 0 );
+            if( !result.empty() ) {
+                convertUTF8ToUTF16( str.data(), str.size(), reinterpret_cast<uint16_t*>( &result[0] ) );
+            }
+            return result;
+        }
         return encode<char,T>("UTF-8", _wideCharSet, str);
     }
     /**
@@ -90,7 +120,7 @@ public:
      * @param str String encoded using environment encoding.
      * @return String represented using wide characters.
      */
-    virtual std::basic_string<T> envToWide( const std::string str ) {
+    virtual std::basic_string<T> envToWide( const std::string &str ) {
         return encode<char,T>(_envCharSet, _wideCharSet, str);
     }
     /**
@@ -98,7 +128,15 @@ public:
      * @param str String represented using wide characters.
      * @return String encoded in UTF-8.
      */
-    virtual std::string wideToUtf8( const std::basic_string<T> str ) {
+    virtual std::string wideToUtf8( const std::basic_string<T> &str ) {
+        if( _nativeUTF16 ) {
+            const uint16_t *units = reinterpret_cast<const uint16_t*>( str.data() );
+            std::string result( getUTF8Length( units, str.size() ), 0 );
+            if( !result.empty() ) {
+                convertUTF16ToUTF8( units, str.size(), &result[0] );
+            }
+            return result;
+        }
         return encode<T,char>(_wideCharSet, "UTF-8", str);
     }
     /**
@@ -107,7 +145,7 @@ public:
      * @param str String represented using wide characters.
      * @return String encoded using default character set.
      */
-    virtual std::string wideToEnv( const std::basic_string<T> str ) {
+    virtual std::string wideToEnv( const std::basic_string<T> &str ) {
         return encode<T,char>(_wideCharSet, _envCharSet, str);
     }
 
@@ -195,9 +233,11 @@ protected:
             IE_INVALID_BYTE_SEQ,
             IE_FAILED
         };
-        Iconv( std::string source, std::string destination ) {
+        Iconv( const std::string &source, const std::string &destination )
+            : _source(source),
+              _destination(destination) {
             // Allocate ICONV converter.
-            _cd = ::iconv_open(destination.c_str(), source.c_str());
+            _cd = IconvCache::acquire(source, destination);
             if( _cd == reinterpret_cast<iconv_t>(-1) ) {
                 if( errno == EINVAL ) {
                     throw EncodingFailedException("Conversion from: " + source + " to: " + destination + " not available.");
@@ -207,7 +247,7 @@ protected:
             _error = IE_OK;
         }
         ~Iconv() {
-            ::iconv_close(_cd);
+            IconvCache::release(_source, _destination, _cd);
         }
     public:
         // Lengths are represented in number or characters not bytes.
@@ -242,6 +282,8 @@ protected:
             return _error;
         }
     private:
+        std::string _source;
+        std::string _destination;
         iconv_t _cd;
         IconvError _error;
     };
@@ -251,6 +293,8 @@ private:
     std::string _envCharSet;
     // Character set for wide strings.
     std::string _wideCharSet;
+    // Wide strings are UTF-16 in the native byte order.
+    bool _nativeUTF16;
 };
 
 typedef WideCharEncoder<jschar> JCharEncoder;
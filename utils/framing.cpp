@@ -0,0 +1,158 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "framing.hpp"
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#define JSR_FRAME_SCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 is chosen at runtime if the compiler is able to generate it
+// for a single function, otherwise only if it's enabled globally.
+#if defined(__AVX2__)
+#define JSR_FRAME_SCAN_AVX2
+#include <immintrin.h>
+#elif defined(JSR_FRAME_SCAN_SSE2) && defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define JSR_FRAME_SCAN_AVX2
+#define JSR_FRAME_SCAN_AVX2_DISPATCH
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+typedef size_t (*ScanFunction)( const char *data, size_t size );
+
+#ifdef JSR_FRAME_SCAN_SSE2
+
+inline unsigned int firstSetBit( uint32_t mask ) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward( &index, mask );
+    return index;
+#else
+    return __builtin_ctz( mask );
+#endif
+}
+
+#endif
+
+size_t scanFrameScalar( const char *data, size_t size ) {
+    for( size_t i = 0; i < size; i++ ) {
+        if( data[i] == '\n' || data[i] == '\0' ) {
+            return i;
+        }
+    }
+    return size;
+}
+
+#ifdef JSR_FRAME_SCAN_SSE2
+
+size_t scanFrameSSE2( const char *data, size_t size ) {
+    const __m128i newLine = _mm_set1_epi8( '\n' );
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for( ; i + 16 <= size; i += 16 ) {
+        __m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>( data + i ) );
+        __m128i found = _mm_or_si128( _mm_cmpeq_epi8( chunk, newLine ), _mm_cmpeq_epi8( chunk, zero ) );
+        uint32_t mask = static_cast<uint32_t>( _mm_movemask_epi8( found ) );
+        if( mask ) {
+            return i + firstSetBit( mask );
+        }
+    }
+    size_t rest = scanFrameScalar( data + i, size - i );
+    return i + rest;
+}
+
+#endif
+
+#ifdef JSR_FRAME_SCAN_AVX2
+
+#ifdef JSR_FRAME_SCAN_AVX2_DISPATCH
+__attribute__((target("avx2")))
+#endif
+size_t scanFrameAVX2( const char *data, size_t size ) {
+    const __m256i newLine = _mm256_set1_epi8( '\n' );
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for( ; i + 32 <= size; i += 32 ) {
+        __m256i chunk = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( data + i ) );
+        __m256i found = _mm256_or_si256( _mm256_cmpeq_epi8( chunk, newLine ), _mm256_cmpeq_epi8( chunk, zero ) );
+        uint32_t mask = static_cast<uint32_t>( _mm256_movemask_epi8( found ) );
+        if( mask ) {
+            return i + firstSetBit( mask );
+        }
+    }
+    // Avoids the penalty of mixing AVX and SSE instructions.
+    _mm256_zeroupper();
+    size_t rest = scanFrameSSE2( data + i, size - i );
+    return i + rest;
+}
+
+#endif
+
+ScanFunction selectScanFunction() {
+#if defined(JSR_FRAME_SCAN_AVX2_DISPATCH)
+    if( __builtin_cpu_supports( "avx2" ) ) {
+        return scanFrameAVX2;
+    }
+    return scanFrameSSE2;
+#elif defined(JSR_FRAME_SCAN_AVX2)
+    return scanFrameAVX2;
+#elif defined(JSR_FRAME_SCAN_SSE2)
+    return scanFrameSSE2;
+#else
+    return scanFrameScalar;
+#endif
+}
+
+// Resolved once, before any thread can use it. Local statics are
+// not initialized in a thread safe way by all the supported compilers.
+const ScanFunction scan = selectScanFunction();
+
+}
+
+size_t Utils::scanFrame( const char *data, size_t size ) {
+    return scan( data, size );
+}
+
+bool Utils::parseFrameCredit( const char *data, size_t length, uint32_t &credit ) {
+    static const size_t prefixLength = sizeof( JSR_FRAME_PROTOCOL_CREDIT ) - 1;
+    if( length <= prefixLength || ::memcmp( data, JSR_FRAME_PROTOCOL_CREDIT, prefixLength ) != 0 ) {
+        return false;
+    }
+    uint64_t value = 0;
+    for( size_t i = prefixLength; i < length; i++ ) {
+        if( data[i] < '0' || data[i] > '9' ) {
+            return false;
+        }
+        value = value * 10 + ( data[i] - '0' );
+        if( value > 0xFFFFFFFFu ) {
+            return false;
+        }
+    }
+    credit = static_cast<uint32_t>( value );
+    return true;
+}
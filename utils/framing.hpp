@@ -0,0 +1,125 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SRC_FRAMING_H_
+#define SRC_FRAMING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Length-prefixed binary framing of the remote protocol.
+ *
+ * Connection starts in the text mode, where commands are separated by new
+ * line characters. Client can switch it to the binary mode by sending the
+ * JSR_FRAME_PROTOCOL_BINARY line. Server confirms it by sending the same line
+ * back and every frame sent after the confirmation is a binary one. Client
+ * has to wait for the confirmation before it sends any binary frame.
+ *
+ * Every binary frame starts with a header consisting of three 32 bit integers
+ * in the network byte order: payload length, context ID (-1 if there is no
+ * context) and flags. The payload follows the header and can contain any bytes.
+ *
+ * Client which sends JSR_FRAME_PROTOCOL_BINARY_DEFLATE instead asks for
+ * compression of the frames sent by the server. Server confirms it by sending
+ * the same line back or JSR_FRAME_PROTOCOL_BINARY if compression is not
+ * supported. Payloads of compressed frames are consecutive parts of a single
+ * deflate stream and are marked by JSR_FRAME_FLAG_DEFLATE.
+ *
+ * Client can also limit the amount of data sent by the server. It grants
+ * credit by sending the JSR_FRAME_PROTOCOL_CREDIT line followed by number
+ * of bytes, e.g. "credit/65536", or in the binary mode a frame marked by
+ * JSR_FRAME_FLAG_CREDIT with the number as its 32 bit payload. Once the first
+ * credit is granted, server sends frames only as long as there is credit
+ * left; every frame sent is subtracted from it as a whole. Credits sum up,
+ * so client grants more as soon as it processes received data.
+ */
+
+#define JSR_FRAME_PROTOCOL_BINARY           "protocol/binary"
+#define JSR_FRAME_PROTOCOL_BINARY_DEFLATE   "protocol/binary-deflate"
+#define JSR_FRAME_HEADER_SIZE               12
+#define JSR_FRAME_FLAG_DEFLATE              0x01
+#define JSR_FRAME_PROTOCOL_CREDIT           "credit/"
+#define JSR_FRAME_FLAG_CREDIT               0x02
+
+namespace Utils {
+
+/**
+ * Header of the binary frame.
+ */
+struct FrameHeader {
+    uint32_t length;
+    int32_t contextId;
+    uint32_t flags;
+};
+
+inline void encodeFrameUInt32( uint32_t value, uint8_t *buffer ) {
+    buffer[0] = static_cast<uint8_t>( value >> 24 );
+    buffer[1] = static_cast<uint8_t>( value >> 16 );
+    buffer[2] = static_cast<uint8_t>( value >> 8 );
+    buffer[3] = static_cast<uint8_t>( value );
+}
+
+inline uint32_t decodeFrameUInt32( const uint8_t *buffer ) {
+    return ( static_cast<uint32_t>( buffer[0] ) << 24 ) |
+           ( static_cast<uint32_t>( buffer[1] ) << 16 ) |
+           ( static_cast<uint32_t>( buffer[2] ) << 8 ) |
+             static_cast<uint32_t>( buffer[3] );
+}
+
+/**
+ * Writes the header into the buffer which has to be at least
+ * JSR_FRAME_HEADER_SIZE bytes long.
+ */
+inline void encodeFrameHeader( const FrameHeader &header, void *buffer ) {
+    uint8_t *bytes = static_cast<uint8_t*>( buffer );
+    encodeFrameUInt32( header.length, bytes );
+    encodeFrameUInt32( static_cast<uint32_t>( header.contextId ), bytes + 4 );
+    encodeFrameUInt32( header.flags, bytes + 8 );
+}
+
+/**
+ * Reads the header from the buffer which has to be at least
+ * JSR_FRAME_HEADER_SIZE bytes long.
+ */
+inline void decodeFrameHeader( const void *buffer, FrameHeader &header ) {
+    const uint8_t *bytes = static_cast<const uint8_t*>( buffer );
+    header.length = decodeFrameUInt32( bytes );
+    header.contextId = static_cast<int32_t>( decodeFrameUInt32( bytes + 4 ) );
+    header.flags = decodeFrameUInt32( bytes + 8 );
+}
+
+/**
+ * Finds the first new line or NUL character of the text protocol, so
+ * the command separator and malicious data are found in one pass. SSE2
+ * or AVX2 is used if the CPU supports it.
+ * @return Offset of the character or 'size' if there is none.
+ */
+size_t scanFrame( const char *data, size_t size );
+
+/**
+ * Parses JSR_FRAME_PROTOCOL_CREDIT line of the text protocol.
+ * @param credit Number of bytes granted by the client.
+ * @return False if it's not a valid credit line.
+ */
+bool parseFrameCredit( const char *data, size_t length, uint32_t &credit );
+
+}
+
+#endif /* SRC_FRAMING_H_ */
@@ -21,9 +21,14 @@
 
 #include <string>
 #include <map>
+#include <memory>
+#include <string.h>
+#include <stdlib.h>
 
 #include "encoding.hpp"
+#include "unicode.hpp"
 #include "log.hpp"
+#include "threads.hpp"
 
 using namespace Utils;
 using namespace JS;
@@ -273,6 +278,122 @@ bool MozJSUtils::evaluateUtf8Script( JSObject *global, const std::string &script
    return evaluateScript( global, jscript, fileName, outRetval );
 }
 
+namespace {
+
+    /*
+     * Bytecode of the embedded scripts. It doesn't depend on the runtime,
+     * so it's shared by all of them. Resources are never unloaded, so their
+     * addresses identify them.
+     */
+    class ScriptCache : public NonCopyable {
+    public:
+        std::shared_ptr<const std::string> get( const void *resource ) {
+            MutexLock lock( _mutex );
+            std::map<const void*, std::shared_ptr<const std::string> >::iterator it = _scripts.find( resource );
+            return it != _scripts.end() ? it->second : std::shared_ptr<const std::string>();
+        }
+        void put( const void *resource, const std::shared_ptr<const std::string> &bytecode ) {
+            MutexLock lock( _mutex );
+            _scripts[resource] = bytecode;
+        }
+    private:
+        Mutex _mutex;
+        std::map<const void*, std::shared_ptr<const std::string> > _scripts;
+    };
+
+    ScriptCache scriptCache;
+
+}
+
+bool MozJSUtils::evaluateResource( JSObject *global, const Resource &resource, const char *fileName, jsval *outRetval, bool shared ) {
+
+    if( !shared ) {
+        return evaluateUtf8Script( global, resource.toString(), fileName, outRetval );
+    }
+
+    JSAutoRequest ar(_context);
+    JSAutoCompartment cm(_context, global);
+
+    if(JS_IsExceptionPending(_context)) {
+        LoggerFactory::getLogger().error( "evaluateResource:: Unexpected pending exception." );
+        _lastError = ERROR_PENDING_EXCEPTION;
+        return false;
+    }
+
+    ExceptionState state(_context);
+
+    JS::RootedObject rootedObj(_context, global);
+    JS::RootedScript script(_context);
+
+    std::shared_ptr<const std::string> bytecode = scriptCache.get( resource.addr );
+    if( bytecode ) {
+        script = JS_DecodeScript( _context, bytecode->data(), static_cast<uint32_t>( bytecode->size() ), nullptr, nullptr );
+        if( !script ) {
+            LoggerFactory::getLogger().warn( "evaluateResource:: Cannot decode cached script: %s, compiling it again.", fileName );
+            JS_ClearPendingException(_context);
+        }
+    }
+
+    if( !script ) {
+
+        jstring source;
+        try {
+            JCharEncoder encoder;
+            source = encoder.utf8ToWide( resource.toString() );
+        } catch( EncodingFailedException & ) {
+            _lastError = ERROR_CHAR_ENCODING_FAILED;
+            return false;
+        }
+
+        // Scripts which are to be run in many globals cannot be compiled
+        // with compile-and-go optimizations, they bind them to the first one.
+        JS::CompileOptions options(_context);
+        options.setFileAndLine(fileName, 0)
+                .setSourcePolicy(JS::CompileOptions::LAZY_SOURCE)
+                .setCompileAndGo(false);
+
+        script = JS::Compile( _context, rootedObj, options, source.c_str(), source.size() );
+        if( !script ) {
+            _lastError = ERROR_EVALUATION_FAILED;
+            return false;
+        }
+
+        uint32_t length;
+        void *data = JS_EncodeScript( _context, script, &length );
+        if( data ) {
+            scriptCache.put( resource.addr, std::make_shared<const std::string>( static_cast<const char*>( data ), length ) );
+            JS_free( _context, data );
+        } else {
+            // Not fatal, it's compiled again next time.
+            LoggerFactory::getLogger().warn( "evaluateResource:: Cannot encode script: %s.", fileName );
+            JS_ClearPendingException(_context);
+        }
+
+    }
+
+    jsval retval = JSVAL_VOID;
+    if (!JS_ExecuteScript(_context, rootedObj, script, &retval)) {
+        _lastError = ERROR_EVALUATION_FAILED;
+        return false;
+    }
+
+    if ( JS_IsExceptionPending(_context) ) {
+        MozJSUtils jsUtils(_context);
+        std::string msg = jsUtils.getPendingExceptionMessage();
+        LoggerFactory::getLogger().error( "evaluateResource:: Exception: %s.", msg.c_str() );
+        _lastError = ERROR_EVALUATION_FAILED;
+        return false;
+    }
+
+    if(outRetval) {
+        *outRetval = retval;
+    }
+
+    _lastError = 0;
+
+    return true;
+}
+
 bool MozJSUtils::parseUtf8JSON(const std::string &str, JS::MutableHandleObject dest) {
 
     // Convert UTF8 string to wide.
@@ -354,13 +475,49 @@ JSCompartment* MozJSUtils::getCurrentCompartment(JSObject *global) {
 
 namespace Utils {
 
-    // Copies all 16-bit UNICODE characters into the provided buffer.
+    /*
+     * Output of the JSON stringifier. Characters are converted into UTF-8 as
+     * they come, so the stringified value is never copied as UTF-16 string.
+     */
+    struct JSONCommandWriter {
+        std::string *result;
+        // High surrogate which ended the previous chunk, its pair may
+        // start the next one.
+        jschar pendingSurrogate;
+    };
+
+    static void appendUtf8( std::string &dest, const jschar *buf, size_t len ) {
+        const uint16_t *units = reinterpret_cast<const uint16_t*>( buf );
+        size_t offset = dest.size();
+        dest.resize( offset + getUTF8Length( units, len ) );
+        convertUTF16ToUTF8( units, len, &dest[0] + offset );
+    }
+
+    // Converts all 16-bit UNICODE characters and appends them to the result.
     JSBool JSONCommandWriteCallback(const jschar *buf, uint32_t len, void *data) {
         if( !data ) {
             return JS_FALSE;
         }
-        std::basic_string<jschar> *buffer = reinterpret_cast< std::basic_string<jschar>* >( data );
-        buffer->append( buf, len );
+        JSONCommandWriter *writer = reinterpret_cast<JSONCommandWriter*>( data );
+        if( len == 0 ) {
+            return JS_TRUE;
+        }
+        if( writer->pendingSurrogate ) {
+            jschar pair[2] = { writer->pendingSurrogate, buf[0] };
+            writer->pendingSurrogate = 0;
+            if( buf[0] >= 0xDC00 && buf[0] <= 0xDFFF ) {
+                appendUtf8( *writer->result, pair, 2 );
+                buf++;
+                len--;
+            } else {
+                appendUtf8( *writer->result, pair, 1 );
+            }
+        }
+        if( len > 0 && buf[len - 1] >= 0xD800 && buf[len - 1] <= 0xDBFF ) {
+            writer->pendingSurrogate = buf[len - 1];
+            len--;
+        }
+        appendUtf8( *writer->result, buf, len );
         return JS_TRUE;
     }
 
@@ -368,18 +525,19 @@ namespace Utils {
 
 bool MozJSUtils::stringifyToUtf8( JS::Value value, std::string &result ) {
 
-    std::basic_string<jschar> stringifiedValue;
-    if( !JS_Stringify( _context, &value, nullptr, JS::NullHandleValue, &JSONCommandWriteCallback, &stringifiedValue ) ) {
+    result.clear();
+
+    JSONCommandWriter writer;
+    writer.result = &result;
+    writer.pendingSurrogate = 0;
+    if( !JS_Stringify( _context, &value, nullptr, JS::NullHandleValue, &JSONCommandWriteCallback, &writer ) ) {
         _lastError = ERROR_JS_STRINGIFY_FAILED;
         return false;
     }
 
-    try {
-        JCharEncoder encoder;
-        result = encoder.wideToUtf8( stringifiedValue );
-    } catch( EncodingFailedException & ) {
-        _lastError = ERROR_CHAR_ENCODING_FAILED;
-        return false;
+    if( writer.pendingSurrogate ) {
+        // Unpaired surrogate at the very end.
+        appendUtf8( result, &writer.pendingSurrogate, 1 );
     }
 
     return true;
@@ -490,32 +648,49 @@ bool MozJSUtils::isFunctionObject(JSObject* fn) {
 }
 
 bool MozJSUtils::splitCommand( const std::string &packet, int &contextId, std::string &jsonCommand ) {
+    size_t offset;
+    bool result = splitCommand( packet.c_str(), packet.size(), contextId, offset );
+    if( result ) {
+        if( &packet == &jsonCommand ) {
+            jsonCommand.erase( 0, offset );
+        } else {
+            jsonCommand.assign( packet, offset, std::string::npos );
+        }
+    }
+    return result;
+}
+
+/**
+ * Finds where the JSON command starts without copying anything, so
+ * the caller can take the command directly from its own buffer. Packet
+ * doesn't have to be NUL terminated.
+ */
+bool MozJSUtils::splitCommand( const char *packet, size_t size, int &contextId, size_t &commandOffset ) {
     // Check if there is context ID in the command string.
     bool result = true;
-    size_t sep = packet.find( '/' );
-    if( sep != std::string::npos ) {
-        size_t json = packet.find( '{' );
-        if( sep != std::string::npos && sep < json ) {
+    commandOffset = 0;
+    const char *sep = static_cast<const char*>( memchr( packet, '/', size ) );
+    if( sep ) {
+        const char *json = static_cast<const char*>( memchr( packet, '{', size ) );
+        if( !json || sep < json ) {
+            // The separator stops strtol, so it never reads past the packet.
             char *end;
-            contextId = static_cast<int>( strtol( packet.c_str(), &end, 10 ) );
-            if( end != packet.c_str() + sep ) {
+            contextId = static_cast<int>( strtol( packet, &end, 10 ) );
+            if( end != sep ) {
                 // Broken context ID.
                 result = false;
                 contextId = -1;
             } else {
-                jsonCommand = packet.substr( sep + 1 );
+                commandOffset = static_cast<size_t>( sep - packet ) + 1;
             }
-        } else {
-            jsonCommand = packet;
         }
-    } else {
-        jsonCommand = packet;
     }
     return result;
 }
 
 struct ResourceManagersHolder {
     std::map<std::string, ResourceManager*> managers;
+    bool shareScripts;
 };
 
 /**
@@ -593,10 +768,8 @@ static JSBool JSR_fn_utils_require( JSContext *context, unsigned int argc, Value
        Resource const * resource = manager->getResource( moduleName );
        if( resource ) {
 
-           std::string moduleScript( reinterpret_cast<char*>( resource->addr ), resource->len );
-
            Value module;
-           if( !jsUtils.evaluateUtf8Script( global, moduleScript, moduleName.c_str(), &module ) ) {
+           if( !jsUtils.evaluateResource( global, *resource, moduleName.c_str(), &module, holder->shareScripts ) ) {
                JS_ReportError( context, "JSR_fn_utils_require:: Cannot evaluate module." );
                return JS_FALSE;
            }
@@ -662,7 +835,7 @@ bool MozJSUtils::addResourceManager( JSObject *global, const std::string &prefix
     return true;
 }
 
-bool MozJSUtils::registerModuleLoader( JSObject *global ) {
+bool MozJSUtils::registerModuleLoader( JSObject *global, bool shareScripts ) {
 
     if ( !JS_DefineFunctions( _context, global, &JSR_EngineEnvironmentFuntions[0] ) ) {
         LoggerFactory::getLogger().error( "JSDebuggerEngine::registerModuleLoader: Cannot define 'require' function." );
@@ -686,6 +859,7 @@ bool MozJSUtils::registerModuleLoader( JSObject *global ) {
     }
 
     ResourceManagersHolder *holders = new ResourceManagersHolder();
+    holders->shareScripts = shareScripts;
 
     JS_SetPrivate( holder, holders );
 
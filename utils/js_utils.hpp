@@ -65,6 +65,11 @@ public:
     // Scripts evaluation.
     bool evaluateUtf8Script( JSObject *global, const std::string &script, const char *fileName, jsval *outRetval );
     bool evaluateScript( JSObject *global, const jstring &script, const char *fileName, jsval *outRetval );
+    /**
+     * Evaluates script embedded as a resource. Shared script is compiled only
+     * once per process, every next evaluation decodes cached bytecode (XDR).
+     */
+    bool evaluateResource( JSObject *global, const Resource &resource, const char *fileName, jsval *outRetval, bool shared );
     // JSON support.
     bool parseUtf8JSON(const std::string &str, JS::MutableHandleObject dest);
     // Compartments.
@@ -87,8 +92,9 @@ public:
     bool isFunctionObject( JSObject *fn );
     // Command parsing.
     static bool splitCommand( const std::string &packet, int &contextId, std::string &jsonCommand );
+    static bool splitCommand( const char *packet, size_t size, int &contextId, size_t &commandOffset );
     // Support for module loading.
-    bool registerModuleLoader( JSObject *global );
+    bool registerModuleLoader( JSObject *global, bool shareScripts );
     bool addResourceManager( JSObject *global, const std::string &prefix, ResourceManager &resourceManager );
 private:
     JSContext *_context;
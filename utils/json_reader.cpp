@@ -0,0 +1,470 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "json_reader.hpp"
+#include "unicode.hpp"
+
+#include <string.h>
+#include <stdlib.h>
+#include <locale.h>
+
+using namespace Utils;
+using namespace std;
+
+// Nesting limit which protects the stack against malicious documents.
+#define JSON_READER_MAX_DEPTH   256
+
+/************
+ * JSONValue
+ ************/
+
+JSONValue::JSONValue()
+    : _type( TYPE_NULL ),
+      _boolean( false ),
+      _offset( 0 ),
+      _length( 0 ) {
+}
+
+JSONValue::Type JSONValue::getType() const {
+    return _type;
+}
+
+bool JSONValue::isString() const {
+    return _type == TYPE_STRING;
+}
+
+bool JSONValue::isObject() const {
+    return _type == TYPE_OBJECT;
+}
+
+const string& JSONValue::getString() const {
+    return _string;
+}
+
+bool JSONValue::getBoolean() const {
+    return _boolean;
+}
+
+double JSONValue::getNumber() const {
+    if( _type != TYPE_NUMBER ) {
+        return 0;
+    }
+    // strtod depends on the locale set by the application, so the decimal
+    // point has to be replaced by the one it expects.
+    string number( _string );
+    const char *point = ::localeconv()->decimal_point;
+    if( point && point[0] != '.' && point[0] != '\0' ) {
+        size_t pos = number.find( '.' );
+        if( pos != string::npos ) {
+            number.replace( pos, 1, point );
+        }
+    }
+    return ::strtod( number.c_str(), nullptr );
+}
+
+bool JSONValue::isTruthy() const {
+    switch( _type ) {
+    case TYPE_BOOLEAN:
+        return _boolean;
+    case TYPE_NUMBER:
+        return getNumber() != 0;
+    case TYPE_STRING:
+        return !_string.empty();
+    case TYPE_ARRAY:
+    case TYPE_OBJECT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+size_t JSONValue::size() const {
+    return _elements.size();
+}
+
+const JSONValue& JSONValue::get( size_t index ) const {
+    return _elements[index];
+}
+
+const string& JSONValue::getName( size_t index ) const {
+    return _names[index];
+}
+
+const JSONValue* JSONValue::find( const string &name ) const {
+    for( size_t i = _names.size(); i > 0; i-- ) {
+        if( _names[i - 1] == name ) {
+            return &_elements[i - 1];
+        }
+    }
+    return nullptr;
+}
+
+size_t JSONValue::getOffset() const {
+    return _offset;
+}
+
+size_t JSONValue::getLength() const {
+    return _length;
+}
+
+/*************
+ * JSONReader
+ *************/
+
+JSONReader::JSONReader()
+    : _data( nullptr ),
+      _size( 0 ),
+      _pos( 0 ),
+      _error( nullptr ),
+      _errorOffset( 0 ) {
+}
+
+JSONReader::~JSONReader() {
+}
+
+bool JSONReader::parse( const string &data, JSONValue &root ) {
+    return parse( data.c_str(), data.size(), root );
+}
+
+bool JSONReader::parse( const char *data, size_t size, JSONValue &root ) {
+    _data = data;
+    _size = size;
+    _pos = 0;
+    _error = nullptr;
+    _errorOffset = 0;
+    root = JSONValue();
+    skipSpaces();
+    if( !parseValue( root, 0 ) ) {
+        return false;
+    }
+    skipSpaces();
+    if( _pos != _size ) {
+        return fail( "Unexpected data after the value." );
+    }
+    return true;
+}
+
+const char* JSONReader::getError() const {
+    return _error;
+}
+
+size_t JSONReader::getErrorOffset() const {
+    return _errorOffset;
+}
+
+bool JSONReader::fail( const char *error ) {
+    _error = error;
+    _errorOffset = _pos;
+    return false;
+}
+
+void JSONReader::skipSpaces() {
+    while( _pos < _size ) {
+        char c = _data[_pos];
+        if( c != ' ' && c != '\t' && c != '\n' && c != '\r' ) {
+            break;
+        }
+        _pos++;
+    }
+}
+
+bool JSONReader::parseValue( JSONValue &value, int depth ) {
+    if( _pos >= _size ) {
+        return fail( "Unexpected end of data." );
+    }
+    value._offset = _pos;
+    bool result;
+    switch( _data[_pos] ) {
+    case '{':
+        result = parseObject( value, depth + 1 );
+        break;
+    case '[':
+        result = parseArray( value, depth + 1 );
+        break;
+    case '"':
+        value._type = JSONValue::TYPE_STRING;
+        result = parseString( value._string );
+        break;
+    case 't':
+        value._type = JSONValue::TYPE_BOOLEAN;
+        value._boolean = true;
+        result = parseLiteral( "true", 4 );
+        break;
+    case 'f':
+        value._type = JSONValue::TYPE_BOOLEAN;
+        result = parseLiteral( "false", 5 );
+        break;
+    case 'n':
+        result = parseLiteral( "null", 4 );
+        break;
+    default:
+        result = parseNumber( value );
+        break;
+    }
+    value._length = _pos - value._offset;
+    return result;
+}
+
+bool JSONReader::parseObject( JSONValue &value, int depth ) {
+    if( depth > JSON_READER_MAX_DEPTH ) {
+        return fail( "Too deeply nested." );
+    }
+    value._type = JSONValue::TYPE_OBJECT;
+    _pos++;
+    skipSpaces();
+    if( _pos < _size && _data[_pos] == '}' ) {
+        _pos++;
+        return true;
+    }
+    while( true ) {
+        if( _pos >= _size || _data[_pos] != '"' ) {
+            return fail( "Member name expected." );
+        }
+        value._names.push_back( string() );
+        if( !parseString( value._names.back() ) ) {
+            return false;
+        }
+        skipSpaces();
+        if( _pos >= _size || _data[_pos] != ':' ) {
+            return fail( "Colon expected." );
+        }
+        _pos++;
+        skipSpaces();
+        value._elements.push_back( JSONValue() );
+        if( !parseValue( value._elements.back(), depth ) ) {
+            return false;
+        }
+        skipSpaces();
+        if( _pos >= _size ) {
+            return fail( "Unexpected end of data." );
+        }
+        char c = _data[_pos++];
+        if( c == '}' ) {
+            return true;
+        } else if( c != ',' ) {
+            _pos--;
+            return fail( "Comma or end of the object expected." );
+        }
+        skipSpaces();
+    }
+}
+
+bool JSONReader::parseArray( JSONValue &value, int depth ) {
+    if( depth > JSON_READER_MAX_DEPTH ) {
+        return fail( "Too deeply nested." );
+    }
+    value._type = JSONValue::TYPE_ARRAY;
+    _pos++;
+    skipSpaces();
+    if( _pos < _size && _data[_pos] == ']' ) {
+        _pos++;
+        return true;
+    }
+    while( true ) {
+        value._elements.push_back( JSONValue() );
+        if( !parseValue( value._elements.back(), depth ) ) {
+            return false;
+        }
+        skipSpaces();
+        if( _pos >= _size ) {
+            return fail( "Unexpected end of data." );
+        }
+        char c = _data[_pos++];
+        if( c == ']' ) {
+            return true;
+        } else if( c != ',' ) {
+            _pos--;
+            return fail( "Comma or end of the array expected." );
+        }
+        skipSpaces();
+    }
+}
+
+bool JSONReader::parseLiteral( const char *literal, size_t length ) {
+    if( _size - _pos < length || ::memcmp( _data + _pos, literal, length ) ) {
+        return fail( "Unexpected character." );
+    }
+    _pos += length;
+    return true;
+}
+
+bool JSONReader::parseNumber( JSONValue &value ) {
+    size_t start = _pos;
+    if( _pos < _size && _data[_pos] == '-' ) {
+        _pos++;
+    }
+    if( _pos >= _size || _data[_pos] < '0' || _data[_pos] > '9' ) {
+        return fail( "Unexpected character." );
+    }
+    // Leading zeros are not allowed.
+    if( _data[_pos++] != '0' ) {
+        while( _pos < _size && _data[_pos] >= '0' && _data[_pos] <= '9' ) {
+            _pos++;
+        }
+    }
+    if( _pos < _size && _data[_pos] == '.' ) {
+        _pos++;
+        if( _pos >= _size || _data[_pos] < '0' || _data[_pos] > '9' ) {
+            return fail( "Digit expected." );
+        }
+        while( _pos < _size && _data[_pos] >= '0' && _data[_pos] <= '9' ) {
+            _pos++;
+        }
+    }
+    if( _pos < _size && ( _data[_pos] == 'e' || _data[_pos] == 'E' ) ) {
+        _pos++;
+        if( _pos < _size && ( _data[_pos] == '+' || _data[_pos] == '-' ) ) {
+            _pos++;
+        }
+        if( _pos >= _size || _data[_pos] < '0' || _data[_pos] > '9' ) {
+            return fail( "Digit expected." );
+        }
+        while( _pos < _size && _data[_pos] >= '0' && _data[_pos] <= '9' ) {
+            _pos++;
+        }
+    }
+    value._type = JSONValue::TYPE_NUMBER;
+    value._string.assign( _data + start, _pos - start );
+    return true;
+}
+
+bool JSONReader::parseHex( uint32_t &value ) {
+    if( _size - _pos < 4 ) {
+        return fail( "Unexpected end of data." );
+    }
+    value = 0;
+    for( int i = 0; i < 4; i++ ) {
+        char c = _data[_pos];
+        value <<= 4;
+        if( c >= '0' && c <= '9' ) {
+            value |= c - '0';
+        } else if( c >= 'a' && c <= 'f' ) {
+            value |= c - 'a' + 10;
+        } else if( c >= 'A' && c <= 'F' ) {
+            value |= c - 'A' + 10;
+        } else {
+            return fail( "Hexadecimal digit expected." );
+        }
+        _pos++;
+    }
+    return true;
+}
+
+namespace {
+
+    void appendUTF8( string &dest, uint32_t code ) {
+        if( code < 0x80 ) {
+            dest += static_cast<char>( code );
+        } else if( code < 0x800 ) {
+            dest += static_cast<char>( 0xC0 | ( code >> 6 ) );
+            dest += static_cast<char>( 0x80 | ( code & 0x3F ) );
+        } else if( code < 0x10000 ) {
+            dest += static_cast<char>( 0xE0 | ( code >> 12 ) );
+            dest += static_cast<char>( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+            dest += static_cast<char>( 0x80 | ( code & 0x3F ) );
+        } else {
+            dest += static_cast<char>( 0xF0 | ( code >> 18 ) );
+            dest += static_cast<char>( 0x80 | ( ( code >> 12 ) & 0x3F ) );
+            dest += static_cast<char>( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+            dest += static_cast<char>( 0x80 | ( code & 0x3F ) );
+        }
+    }
+
+}
+
+bool JSONReader::parseString( string &value ) {
+    _pos++;
+    while( true ) {
+        // Copy plain characters in runs.
+        size_t start = _pos;
+        while( _pos < _size ) {
+            unsigned char c = static_cast<unsigned char>( _data[_pos] );
+            if( c == '"' || c == '\\' || c < 0x20 || c >= 0x80 ) {
+                break;
+            }
+            _pos++;
+        }
+        value.append( _data + start, _pos - start );
+        if( _pos >= _size ) {
+            return fail( "Unterminated string." );
+        }
+        unsigned char c = static_cast<unsigned char>( _data[_pos] );
+        if( c == '"' ) {
+            _pos++;
+            return true;
+        } else if( c < 0x20 ) {
+            return fail( "Control character in string." );
+        } else if( c >= 0x80 ) {
+            size_t length = getUTF8SequenceLength( reinterpret_cast<const unsigned char*>( _data + _pos ), _size - _pos );
+            if( !length ) {
+                return fail( "Malformed UTF-8 sequence." );
+            }
+            value.append( _data + _pos, length );
+            _pos += length;
+        } else {
+            // Escape sequence.
+            _pos++;
+            if( _pos >= _size ) {
+                return fail( "Unterminated string." );
+            }
+            char e = _data[_pos++];
+            switch( e ) {
+            case '"': value += '"'; break;
+            case '\\': value += '\\'; break;
+            case '/': value += '/'; break;
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+            case 'n': value += '\n'; break;
+            case 'r': value += '\r'; break;
+            case 't': value += '\t'; break;
+            case 'u': {
+                uint32_t code;
+                if( !parseHex( code ) ) {
+                    return false;
+                }
+                if( code >= 0xD800 && code <= 0xDBFF && _size - _pos >= 6 &&
+                        _data[_pos] == '\\' && _data[_pos + 1] == 'u' ) {
+                    size_t pos = _pos;
+                    _pos += 2;
+                    uint32_t low;
+                    if( !parseHex( low ) ) {
+                        return false;
+                    }
+                    if( low >= 0xDC00 && low <= 0xDFFF ) {
+                        code = 0x10000 + ( ( code - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+                    } else {
+                        // Not a pair, the second escape is read separately.
+                        _pos = pos;
+                    }
+                }
+                if( code >= 0xD800 && code <= 0xDFFF ) {
+                    // JSON.parse accepts unpaired surrogates, but they
+                    // cannot be encoded in UTF-8.
+                    code = 0xFFFD;
+                }
+                appendUTF8( value, code );
+                break;
+            }
+            default:
+                _pos--;
+                return fail( "Invalid escape sequence." );
+            }
+        }
+    }
+}
@@ -0,0 +1,140 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SRC_JSON_READER_H_
+#define SRC_JSON_READER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "utils.hpp"
+
+namespace Utils {
+
+/**
+ * Value of the JSON document read by the JSONReader.
+ */
+class JSONValue {
+public:
+    enum Type {
+        TYPE_NULL,
+        TYPE_BOOLEAN,
+        TYPE_NUMBER,
+        TYPE_STRING,
+        TYPE_ARRAY,
+        TYPE_OBJECT
+    };
+public:
+    JSONValue();
+public:
+    Type getType() const;
+    bool isString() const;
+    bool isObject() const;
+    /**
+     * Gets decoded UTF-8 value of the string or the literal of the number.
+     */
+    const std::string& getString() const;
+    bool getBoolean() const;
+    double getNumber() const;
+    /**
+     * Checks if the value is truthy the way JavaScript understands it.
+     */
+    bool isTruthy() const;
+    /**
+     * Gets number of elements of the array or members of the object.
+     */
+    size_t size() const;
+    /**
+     * Gets element of the array or value of the object's member.
+     */
+    const JSONValue& get( size_t index ) const;
+    /**
+     * Gets name of the object's member.
+     */
+    const std::string& getName( size_t index ) const;
+    /**
+     * Finds member of the object. If the name is duplicated, the last
+     * member is returned, the same way JSON.parse does it.
+     * @return Member's value or nullptr if there is no such member.
+     */
+    const JSONValue* find( const std::string &name ) const;
+    /**
+     * Gets position of the value in the document it was read from.
+     */
+    size_t getOffset() const;
+    size_t getLength() const;
+private:
+    friend class JSONReader;
+    Type _type;
+    bool _boolean;
+    std::string _string;
+    std::vector<std::string> _names;
+    std::vector<JSONValue> _elements;
+    size_t _offset;
+    size_t _length;
+};
+
+/**
+ * Strict RFC 7159 reader of UTF-8 encoded JSON documents. It accepts the same
+ * documents as JSON.parse does, except the ones which are not valid UTF-8,
+ * so it can be used to validate data before it's handed to the JS engine.
+ */
+class JSONReader : public NonCopyable {
+public:
+    JSONReader();
+    ~JSONReader();
+public:
+    /**
+     * Reads the document.
+     * @param root Output parameter for the top level value.
+     * @return False if the document is malformed.
+     */
+    bool parse( const char *data, size_t size, JSONValue &root );
+    bool parse( const std::string &data, JSONValue &root );
+    /**
+     * Describes why the last document was rejected.
+     */
+    const char* getError() const;
+    /**
+     * Gets offset of the byte the last document was rejected at.
+     */
+    size_t getErrorOffset() const;
+private:
+    bool parseValue( JSONValue &value, int depth );
+    bool parseObject( JSONValue &value, int depth );
+    bool parseArray( JSONValue &value, int depth );
+    bool parseString( std::string &value );
+    bool parseNumber( JSONValue &value );
+    bool parseLiteral( const char *literal, size_t length );
+    bool parseHex( uint32_t &value );
+    void skipSpaces();
+    bool fail( const char *error );
+private:
+    const char *_data;
+    size_t _size;
+    size_t _pos;
+    const char *_error;
+    size_t _errorOffset;
+};
+
+}
+
+#endif /* SRC_JSON_READER_H_ */
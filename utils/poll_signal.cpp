@@ -0,0 +1,133 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "poll_signal.hpp"
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdint.h>
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+#endif
+
+using namespace Utils;
+
+#ifdef _WIN32
+
+PollSignal::PollSignal()
+    : _signaled( false ),
+      _event( NULL ) {
+}
+
+PollSignal::~PollSignal() {
+    if( _event ) {
+        ::CloseHandle( _event );
+    }
+}
+
+bool PollSignal::init() {
+    _event = ::CreateEvent( NULL, TRUE, FALSE, NULL );
+    return _event != NULL;
+}
+
+poll_handle PollSignal::getHandle() const {
+    return _event;
+}
+
+void PollSignal::set() {
+    if( !_signaled.exchange( true ) ) {
+        ::SetEvent( _event );
+    }
+}
+
+void PollSignal::reset() {
+    _signaled = false;
+    ::ResetEvent( _event );
+}
+
+#else
+
+PollSignal::PollSignal()
+    : _signaled( false ),
+      _readfd( -1 ),
+      _writefd( -1 ) {
+}
+
+PollSignal::~PollSignal() {
+    if( _readfd != -1 ) {
+        ::close( _readfd );
+    }
+    if( _writefd != -1 && _writefd != _readfd ) {
+        ::close( _writefd );
+    }
+}
+
+bool PollSignal::init() {
+#ifdef HAVE_SYS_EVENTFD_H
+    int fd = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+    if( fd == -1 ) {
+        return false;
+    }
+    _readfd = _writefd = fd;
+#else
+    int fds[2];
+    if( ::pipe2( fds, O_NONBLOCK | O_CLOEXEC ) ) {
+        return false;
+    }
+    _readfd = fds[0];
+    _writefd = fds[1];
+#endif
+    return true;
+}
+
+poll_handle PollSignal::getHandle() const {
+    return _readfd;
+}
+
+void PollSignal::set() {
+    // Only the first one writes, so there is always at most one
+    // pending notification in the descriptor.
+    if( !_signaled.exchange( true ) ) {
+#ifdef HAVE_SYS_EVENTFD_H
+        uint64_t value = 1;
+#else
+        uint8_t value = 1;
+#endif
+        while( ::write( _writefd, &value, sizeof( value ) ) == -1 && errno == EINTR ) { }
+    }
+}
+
+void PollSignal::reset() {
+    _signaled = false;
+    // Drained even if the flag wasn't set, a notification written by
+    // set() racing with the previous reset() could be left behind.
+#ifdef HAVE_SYS_EVENTFD_H
+    uint64_t value;
+    while( ::read( _readfd, &value, sizeof( value ) ) == -1 && errno == EINTR ) { }
+#else
+    uint8_t buffer[64];
+    ssize_t size;
+    while( ( size = ::read( _readfd, buffer, sizeof( buffer ) ) ) > 0 || ( size == -1 && errno == EINTR ) ) { }
+#endif
+}
+
+#endif
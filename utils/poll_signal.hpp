@@ -0,0 +1,83 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SRC_POLL_SIGNAL_H_
+#define SRC_POLL_SIGNAL_H_
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#include <atomic>
+
+#include "utils.hpp"
+
+namespace Utils {
+
+#ifdef _WIN32
+typedef HANDLE poll_handle;
+#else
+typedef int poll_handle;
+#endif
+
+/**
+ * Level triggered signal which can be waited for by a poll/epoll loop (or
+ * WaitForMultipleObjects on Windows). The handle is readable from the moment
+ * the signal is set until it's reset, no matter how many times it was set
+ * in the meantime. Setting already set signal costs no system call. An
+ * eventfd is used if it's available, a pipe or a manual-reset event otherwise.
+ */
+class PollSignal : public NonCopyable {
+public:
+    PollSignal();
+    ~PollSignal();
+public:
+    /**
+     * Creates the underlying descriptor.
+     * @return False if it cannot be created.
+     */
+    bool init();
+    /**
+     * Gets handle which is readable (signaled) as long as the signal is set.
+     */
+    poll_handle getHandle() const;
+    /**
+     * Sets the signal. It can be called from any thread.
+     */
+    void set();
+    /**
+     * Resets the signal. It has to be called by a single consumer. In
+     * order not to lose a signal set concurrently, the condition the signal
+     * stands for has to be checked again after the signal is reset.
+     */
+    void reset();
+private:
+    std::atomic<bool> _signaled;
+#ifdef _WIN32
+    HANDLE _event;
+#else
+    // Both are the same descriptor in case of eventfd.
+    int _readfd;
+    int _writefd;
+#endif
+};
+
+}
+
+#endif /* SRC_POLL_SIGNAL_H_ */
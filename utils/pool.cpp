@@ -0,0 +1,91 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "pool.hpp"
+
+#include <new>
+
+using namespace Utils;
+
+MemoryPool::MemoryPool( size_t blockSize, size_t maxFree )
+    : _blockSize( blockSize < sizeof( FreeBlock ) ? sizeof( FreeBlock ) : blockSize ),
+      _maxFree( maxFree ),
+      _freeCount( 0 ),
+      _free( nullptr ),
+      _heapAllocations( 0 ),
+      _pooledAllocations( 0 ) {
+}
+
+MemoryPool::~MemoryPool() {
+    while( _free ) {
+        FreeBlock *block = _free;
+        _free = block->next;
+        ::operator delete( block );
+    }
+}
+
+void* MemoryPool::allocate( size_t size ) {
+    if( size <= _blockSize ) {
+        FreeBlock *block = nullptr;
+        _mutex.lock();
+        if( _free ) {
+            block = _free;
+            _free = block->next;
+            _freeCount--;
+        }
+        _mutex.unlock();
+        if( block ) {
+            _pooledAllocations++;
+            return block;
+        }
+        size = _blockSize;
+    }
+    // Throws std::bad_alloc if there is no memory.
+    void *block = ::operator new( size );
+    _heapAllocations++;
+    return block;
+}
+
+void MemoryPool::release( void *block, size_t size ) {
+    if( !block ) {
+        return;
+    }
+    if( size <= _blockSize ) {
+        _mutex.lock();
+        if( _freeCount < _maxFree ) {
+            FreeBlock *free = static_cast<FreeBlock*>( block );
+            free->next = _free;
+            _free = free;
+            _freeCount++;
+            block = nullptr;
+        }
+        _mutex.unlock();
+    }
+    if( block ) {
+        ::operator delete( block );
+    }
+}
+
+size_t MemoryPool::getHeapAllocations() const {
+    return _heapAllocations.load();
+}
+
+size_t MemoryPool::getPooledAllocations() const {
+    return _pooledAllocations.load();
+}
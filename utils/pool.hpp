@@ -0,0 +1,82 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SRC_POOL_H_
+#define SRC_POOL_H_
+
+#include <stddef.h>
+#include <atomic>
+
+#include "utils.hpp"
+#include "threads.hpp"
+
+namespace Utils {
+
+/**
+ * Thread-safe pool of memory blocks of the same size. Released blocks
+ * are kept on a free list and handed out again, so objects which are
+ * created and destroyed all the time do not hit the heap. Blocks can be
+ * allocated and released by different threads. Requests bigger than
+ * the block size are passed directly to the heap.
+ */
+class MemoryPool : public NonCopyable {
+public:
+    /**
+     * Creates a pool.
+     * @param blockSize Size of every block.
+     * @param maxFree Maximum number of free blocks kept in the pool;
+     *                blocks above the limit are returned to the heap.
+     */
+    MemoryPool( size_t blockSize, size_t maxFree );
+    ~MemoryPool();
+public:
+    /**
+     * Allocates memory for an object of given size.
+     * @throws std::bad_alloc
+     */
+    void* allocate( size_t size );
+    /**
+     * Releases memory allocated by the pool. The size has to be the
+     * same as the one passed to 'allocate'.
+     */
+    void release( void *block, size_t size );
+    /**
+     * Gets number of allocations which hit the heap.
+     */
+    size_t getHeapAllocations() const;
+    /**
+     * Gets number of allocations served from the free list.
+     */
+    size_t getPooledAllocations() const;
+private:
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+    size_t _blockSize;
+    size_t _maxFree;
+    size_t _freeCount;
+    FreeBlock *_free;
+    Mutex _mutex;
+    std::atomic<size_t> _heapAllocations;
+    std::atomic<size_t> _pooledAllocations;
+};
+
+}
+
+#endif /* SRC_POOL_H_ */
@@ -281,6 +281,10 @@ bool Condition::wait( Mutex &mutex, int milis ) {
     return pthread_cond_timedwait( &_condition, &mutex._mutex, &ts.getTs() ) != ETIMEDOUT;
 }
 
+bool Condition::waitUntil( Mutex &mutex, TimeStamp deadline ) {
+    return pthread_cond_timedwait( &_condition, &mutex._mutex, &deadline.getTs() ) != ETIMEDOUT;
+}
+
 #elif defined(_WIN32)
 
 Condition::Condition() {
@@ -310,4 +314,14 @@ bool Condition::wait( Mutex &mutex, int milis ) {
     return true;
 }
 
+bool Condition::waitUntil( Mutex &mutex, TimeStamp deadline ) {
+    uint64_t now = TimeStamp().getNanos();
+    uint64_t end = deadline.getNanos();
+    if( end <= now ) {
+        return false;
+    }
+    // Rounded up, so it never wakes up before the deadline.
+    return wait( mutex, static_cast<int>( ( end - now + 999999 ) / 1000000 ) );
+}
+
 #endif
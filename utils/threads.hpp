@@ -24,9 +24,13 @@
 #include <Windows.h>
 #endif
 
-#include <queue>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <utility>
 
 #include "utils.hpp"
+#include "timestamp.hpp"
 
 namespace Utils {
 
@@ -92,6 +96,11 @@ public:
     void broadcast();
     void wait( Mutex &mutex );
     bool wait( Mutex &mutex, int milis );
+    /**
+     * Waits until the condition is signaled or the deadline passes.
+     * @return False if the deadline has passed.
+     */
+    bool waitUntil( Mutex &mutex, TimeStamp deadline );
 private:
 #ifdef _WIN32
     CONDITION_VARIABLE _condition;
@@ -153,16 +162,30 @@ class BlockingQueue;
 /**
  * Generic signal handler.
  */
-template<typename T>
+template<typename T, template<typename> class Queue = BlockingQueue>
 class QueueSignalHandler {
 public:
     QueueSignalHandler() {}
     virtual ~QueueSignalHandler() {}
-    virtual void handle( BlockingQueue<T> &queue, int signal ) = 0;
+    virtual void handle( Queue<T> &queue, int signal ) = 0;
 };
 
 /**
- * Simple blocking queue implementation.
+ * Gets the lane of a multi-lane BlockingQueue the element belongs to.
+ * Elements are put into the first lane by default; types which need
+ * priorities provide their own overload found by argument dependent lookup.
+ */
+template<typename T>
+inline int getQueueLane( const T& ) {
+    return 0;
+}
+
+/**
+ * Simple blocking queue implementation. The queue can be divided into
+ * a few lanes; elements are always taken from the first non empty lane,
+ * so elements of the lower lanes overtake the ones of the higher lanes,
+ * but the order inside a lane is preserved. The maximum number of
+ * elements applies to all the lanes together.
  */
 template<typename T>
 class BlockingQueue {
@@ -170,16 +193,19 @@ public:
 
     static const int SIGNAL_NEW_ELEMENT = 1;
 
-    BlockingQueue( int max = -1 ) :
+    BlockingQueue( int max = -1, int lanes = 1 ) :
         _max(max),
         _interrupt(false),
+        _lanes( lanes > 0 ? lanes : 1 ),
+        _count(0),
         _signalHandler(nullptr) {
     }
 
     BlockingQueue(const BlockingQueue &queue)
         : _max(queue._max),
           _interrupt(false),
-          _queue( queue._queue ),
+          _lanes( queue._lanes ),
+          _count( queue._count ),
           _signalHandler( queue._signalHandler ) {
         // Do not copy mutex and condition. Every queue
         // has their own independent instances.
@@ -188,7 +214,8 @@ public:
     BlockingQueue& operator=( const BlockingQueue &queue ) {
         if( &queue != this ) {
             _max = queue._max;
-            _queue = queue._queue;
+            _lanes = queue._lanes;
+            _count = queue._count;
             _interrupt = queue._interrupt;
             _signalHandler = queue._signalHandler;
         }
@@ -207,8 +234,8 @@ public:
     bool peek( T &element ) {
         bool exists = false;
         _mutex.lock();
-        if( !_queue.empty() ) {
-            element = _queue.front();
+        if( _count > 0 ) {
+            element = frontLane().front();
             exists = true;
         }
         _mutex.unlock();
@@ -216,16 +243,15 @@ public:
     }
 
     /**
-     * Pops the next element from the front of the queue.
+     * Pops the next element from the front of the queue. Keep in mind
+     * that it's the element returned by peek only if nothing has been
+     * added to a lower lane in the meantime.
      */
     void popOnly() {
         _mutex.lock();
-        if( !_queue.empty() ) {
-            _queue.pop();
-            _conditionFull.signal();
-            if( _queue.empty() ) {
-                _conditionEmptyWait.broadcast();
-            }
+        if( _count > 0 ) {
+            frontLane().pop_front();
+            removed();
         }
         _mutex.unlock();
     }
@@ -236,13 +262,8 @@ public:
     bool get( T &element ) {
         bool exists = false;
         _mutex.lock();
-        if( !_queue.empty() ) {
-            element = _queue.front();
-            _queue.pop();
-            _conditionFull.signal();
-            if( _queue.empty() ) {
-                _conditionEmptyWait.broadcast();
-            }
+        if( _count > 0 ) {
+            take( element );
             exists = true;
         }
         _mutex.unlock();
@@ -254,19 +275,50 @@ public:
      * element has been added.
      */
     bool add( T &element ) {
-        bool result = true;
-        _mutex.lock();
-        if( _max != -1 && _queue.size() == _max ) {
-            result = false;
-        } else {
-            _queue.push(element);
-            _conditionEmpty.signal();
-        }
-        _mutex.unlock();
-        if( _signalHandler ) {
-            _signalHandler->handle( *this, SIGNAL_NEW_ELEMENT );
-        }
-        return result;
+        return addElement( element );
+    }
+
+    /**
+     * Moves new element into the queue without blocking anything. Element
+     * is left untouched if it cannot be added.
+     */
+    bool add( T &&element ) {
+        return addElement( std::move( element ) );
+    }
+
+    /**
+     * Adds new element without blocking anything. If the queue is full,
+     * the oldest element of the same lane is dropped to make room for it.
+     * @param dropped Set to true if an element has been dropped.
+     * @return False if the queue is full and there is nothing in the
+     *         lane which could be dropped.
+     */
+    bool addDroppingOldest( T &element, bool &dropped ) {
+        return addDroppingOldestElement( element, dropped );
+    }
+
+    /**
+     * Moves new element into the queue the same way the version above
+     * does. Element is left untouched if it cannot be added.
+     */
+    bool addDroppingOldest( T &&element, bool &dropped ) {
+        return addDroppingOldestElement( std::move( element ), dropped );
+    }
+
+    /**
+     * Replaces the last element of the same lane for which the predicate
+     * returns true. The replaced element is removed and the new one goes
+     * to the end of the lane, so the order of elements is kept.
+     * @return False if there is no such an element.
+     */
+    template<typename P>
+    bool replace( T &element, P predicate ) {
+        return replaceElement( element, predicate );
+    }
+
+    template<typename P>
+    bool replace( T &&element, P predicate ) {
+        return replaceElement( std::move( element ), predicate );
     }
 
     /**
@@ -275,51 +327,60 @@ public:
      * @throws InterruptionException
      */
     T pop() {
-        _mutex.lock();
-        if( _interrupt ) {
-            _mutex.unlock();
-            throw InterruptionException();
-        }
-        while( _queue.empty() ) {
-            _conditionEmpty.wait( _mutex );
-            if ( _interrupt ) {
-                _mutex.unlock();
-                throw InterruptionException();
-            }
-        }
-        T element  = _queue.front();
-        _queue.pop();
-        _conditionFull.signal();
-        if( _queue.empty() ) {
-            _conditionEmptyWait.broadcast();
-        }
-        _mutex.unlock();
+        T element;
+        popElement( element, nullptr );
         return element;
     }
 
+    /**
+     * Gets next element from the queue, but waits no longer than given
+     * number of milliseconds.
+     * @param milis Maximum time to wait, negative value means no limit.
+     * @return False if the queue is still empty after the timeout.
+     * @throws InterruptionException
+     */
+    bool pop( T &element, int milis ) {
+        TimeStamp deadline = TimeStamp() + TimeStamp::ms( milis > 0 ? milis : 0 );
+        return popElement( element, milis < 0 ? nullptr : &deadline );
+    }
+
     /**
      * Adds new element into the queue.
      * @param element Element to add to the queue.
      */
     void push(T &element) {
-        _mutex.lock();
-        if( _interrupt ) {
-            _mutex.unlock();
-            throw InterruptionException();
-        }
-        while( _max != -1 && _queue.size() == _max ) {
-            _conditionFull.wait( _mutex );
-            if ( _interrupt ) {
-                _mutex.unlock();
-                throw InterruptionException();
-            }
-        }
-        _queue.push(element);
-        _conditionEmpty.signal();
-        _mutex.unlock();
-        if( _signalHandler ) {
-            _signalHandler->handle( *this, SIGNAL_NEW_ELEMENT );
-        }
+        pushElement( element, nullptr );
+    }
+
+    /**
+     * Moves new element into the queue.
+     * @param element Element to add to the queue.
+     */
+    void push(T &&element) {
+        pushElement( std::move( element ), nullptr );
+    }
+
+    /**
+     * Adds new element into the queue, but waits no longer than given
+     * number of milliseconds for the free space.
+     * @param element Element to add to the queue.
+     * @param milis Maximum time to wait, negative value means no limit.
+     * @return False if there is still no space after the timeout.
+     * @throws InterruptionException
+     */
+    bool push(T &element, int milis) {
+        TimeStamp deadline = TimeStamp() + TimeStamp::ms( milis > 0 ? milis : 0 );
+        return pushElement( element, milis < 0 ? nullptr : &deadline );
+    }
+
+    /**
+     * Moves new element into the queue, but waits no longer than given
+     * number of milliseconds for the free space. Element is left untouched
+     * if it cannot be added.
+     */
+    bool push(T &&element, int milis) {
+        TimeStamp deadline = TimeStamp() + TimeStamp::ms( milis > 0 ? milis : 0 );
+        return pushElement( std::move( element ), milis < 0 ? nullptr : &deadline );
     }
 
     /**
@@ -340,7 +401,7 @@ public:
     bool isEmpty() {
         bool empty;
         _mutex.lock();
-        empty = _queue.empty();
+        empty = _count == 0;
         _mutex.unlock();
         return empty;
     }
@@ -351,7 +412,7 @@ public:
     int getCount() {
         int count;
         _mutex.lock();
-        count = static_cast<int>(_queue.size());
+        count = _count;
         _mutex.unlock();
         return count;
     }
@@ -360,40 +421,410 @@ public:
      * Waits as long as the queue is empty.
      */
     void waitForEmpty() {
+        waitForEmptyUntil( nullptr );
+    }
+
+    /**
+     * Waits until the queue is empty, but no longer than given
+     * number of milliseconds.
+     * @param milis Maximum time to wait, negative value means no limit.
+     * @return False if the queue is still not empty after the timeout.
+     * @throws InterruptionException
+     */
+    bool waitForEmpty( int milis ) {
+        TimeStamp deadline = TimeStamp() + TimeStamp::ms( milis > 0 ? milis : 0 );
+        return waitForEmptyUntil( milis < 0 ? nullptr : &deadline );
+    }
+
+    /**
+     * Sets new signal handler.
+     * @param signalHandler Signal handler.
+     */
+    void setSignalHandler( QueueSignalHandler<T> *signalHandler ) {
+        this->_signalHandler = signalHandler;
+    }
+
+private:
+
+    // Both versions of add and push share the same logic, the element
+    // is either copied or moved into the queue depending on U.
+
+    template<typename U>
+    bool addElement( U &&element ) {
+        bool result = true;
+        _mutex.lock();
+        if( _max != -1 && _count == _max ) {
+            result = false;
+        } else {
+            put( std::forward<U>( element ) );
+        }
+        _mutex.unlock();
+        if( _signalHandler ) {
+            _signalHandler->handle( *this, SIGNAL_NEW_ELEMENT );
+        }
+        return result;
+    }
+
+    template<typename U>
+    bool addDroppingOldestElement( U &&element, bool &dropped ) {
+        bool result = true;
+        dropped = false;
+        _mutex.lock();
+        if( _max != -1 && _count == _max ) {
+            std::deque< T > &lane = _lanes[laneOf( element )];
+            if( lane.empty() ) {
+                result = false;
+            } else {
+                lane.pop_front();
+                _count--;
+                dropped = true;
+            }
+        }
+        if( result ) {
+            put( std::forward<U>( element ) );
+        }
+        _mutex.unlock();
+        if( result && _signalHandler ) {
+            _signalHandler->handle( *this, SIGNAL_NEW_ELEMENT );
+        }
+        return result;
+    }
+
+    template<typename U, typename P>
+    bool replaceElement( U &&element, P &predicate ) {
+        bool result = false;
+        _mutex.lock();
+        std::deque< T > &lane = _lanes[laneOf( element )];
+        for( typename std::deque< T >::reverse_iterator it = lane.rbegin(); it != lane.rend(); it++ ) {
+            if( predicate( static_cast<const T&>( *it ) ) ) {
+                lane.erase( ( ++it ).base() );
+                lane.push_back( std::forward<U>( element ) );
+                result = true;
+                break;
+            }
+        }
+        _mutex.unlock();
+        return result;
+    }
+
+    // All the blocking operations wait for the condition until the
+    // deadline passes or forever if there is no deadline.
+
+    template<typename U>
+    bool pushElement( U &&element, TimeStamp *deadline ) {
         _mutex.lock();
         if( _interrupt ) {
             _mutex.unlock();
             throw InterruptionException();
         }
-        while( !_queue.empty() ) {
-            _conditionEmptyWait.wait( _mutex );
-            if ( _interrupt ) {
-                _mutex.unlock();
-                throw InterruptionException();
+        while( _max != -1 && _count == _max ) {
+            if( !waitFor( _conditionFull, deadline ) ) {
+                break;
+            }
+        }
+        if( _max != -1 && _count == _max ) {
+            // Timed out.
+            _mutex.unlock();
+            return false;
+        }
+        put( std::forward<U>( element ) );
+        _mutex.unlock();
+        if( _signalHandler ) {
+            _signalHandler->handle( *this, SIGNAL_NEW_ELEMENT );
+        }
+        return true;
+    }
+
+    bool popElement( T &element, TimeStamp *deadline ) {
+        _mutex.lock();
+        if( _interrupt ) {
+            _mutex.unlock();
+            throw InterruptionException();
+        }
+        while( _count == 0 ) {
+            if( !waitFor( _conditionEmpty, deadline ) ) {
+                break;
             }
         }
+        if( _count == 0 ) {
+            // Timed out.
+            _mutex.unlock();
+            return false;
+        }
+        take( element );
         _mutex.unlock();
+        return true;
+    }
+
+    // Lanes are touched only by the owner of the mutex.
+
+    size_t laneOf( const T &element ) {
+        int lane = getQueueLane( element );
+        if( lane < 0 ) {
+            lane = 0;
+        } else if( lane >= static_cast<int>( _lanes.size() ) ) {
+            lane = static_cast<int>( _lanes.size() ) - 1;
+        }
+        return static_cast<size_t>( lane );
+    }
+
+    template<typename U>
+    void put( U &&element ) {
+        _lanes[laneOf( element )].push_back( std::forward<U>( element ) );
+        _count++;
+        _conditionEmpty.signal();
+    }
+
+    std::deque< T >& frontLane() {
+        size_t lane = 0;
+        while( _lanes[lane].empty() ) {
+            lane++;
+        }
+        return _lanes[lane];
+    }
+
+    void take( T &element ) {
+        std::deque< T > &lane = frontLane();
+        element = std::move( lane.front() );
+        lane.pop_front();
+        removed();
+    }
+
+    void removed() {
+        _count--;
+        _conditionFull.signal();
+        if( _count == 0 ) {
+            _conditionEmptyWait.broadcast();
+        }
+    }
+
+    bool waitForEmptyUntil( TimeStamp *deadline ) {
+        _mutex.lock();
+        if( _interrupt ) {
+            _mutex.unlock();
+            throw InterruptionException();
+        }
+        while( _count > 0 ) {
+            if( !waitFor( _conditionEmptyWait, deadline ) ) {
+                break;
+            }
+        }
+        bool empty = _count == 0;
+        _mutex.unlock();
+        return empty;
     }
 
     /**
-     * Sets new signal handler.
-     * @param signalHandler Signal handler.
+     * Waits for the condition. Has to be called by the owner of the mutex,
+     * which is released if the queue has been interrupted in the meantime.
+     * @return False if the deadline has passed.
+     * @throws InterruptionException
      */
-    void setSignalHandler( QueueSignalHandler<T> *signalHandler ) {
-        this->_signalHandler = signalHandler;
+    bool waitFor( Condition &condition, TimeStamp *deadline ) {
+        bool signaled = true;
+        if( deadline ) {
+            signaled = condition.waitUntil( _mutex, *deadline );
+        } else {
+            condition.wait( _mutex );
+        }
+        if( _interrupt ) {
+            _mutex.unlock();
+            throw InterruptionException();
+        }
+        return signaled;
     }
 
-private:
     int _max;
     bool _interrupt;
     Mutex _mutex;
     Condition _conditionEmpty;
     Condition _conditionFull;
     Condition _conditionEmptyWait;
-    std::queue< T > _queue;
+    std::vector< std::deque< T > > _lanes;
+    int _count;
     QueueSignalHandler<T> *_signalHandler;
 };
 
+/**
+ * Bounded lock-free queue for exactly one producer thread and exactly
+ * one consumer thread. Elements are stored in a ring buffer and both
+ * sides synchronize only through their positions, so neither add nor get
+ * takes any lock. The mutex and the condition are used only by the
+ * blocking pop when the consumer has to sleep, and the producer touches
+ * them only if it knows that the consumer is really sleeping.
+ */
+template<typename T>
+class SPSCQueue : public NonCopyable {
+public:
+
+    static const int SIGNAL_NEW_ELEMENT = 1;
+
+    /**
+     * Creates a queue.
+     * @param capacity Maximum number of elements, rounded up
+     *                 to the power of two.
+     */
+    explicit SPSCQueue( size_t capacity ) :
+        _mask(0),
+        _head(0),
+        _tail(0),
+        _waiting(false),
+        _interrupt(false),
+        _signalHandler(nullptr) {
+        size_t size = 1;
+        while( size < capacity ) {
+            size <<= 1;
+        }
+        _buffer.resize( size );
+        _mask = size - 1;
+    }
+
+    ~SPSCQueue() {
+        // Just in case.
+        interrupt();
+    }
+
+    /**
+     * Adds new element without blocking anything. Can be
+     * called by the producer only.
+     * @return True if element has been added.
+     */
+    bool add( T &element ) {
+        return addElement( element );
+    }
+
+    /**
+     * Moves new element into the queue. Element is left untouched
+     * if the queue is full. Can be called by the producer only.
+     * @return True if element has been added.
+     */
+    bool add( T &&element ) {
+        return addElement( std::move( element ) );
+    }
+
+    /**
+     * Gets next element if there is any. Can be called by the consumer only.
+     */
+    bool get( T &element ) {
+        size_t head = _head.load( std::memory_order_relaxed );
+        if( head == _tail.load( std::memory_order_acquire ) ) {
+            return false;
+        }
+        element = std::move( _buffer[head & _mask] );
+        _head.store( head + 1, std::memory_order_release );
+        return true;
+    }
+
+    /**
+     * Gets next element from the queue. It's a blocking operation
+     * which blocks if there is nothing in the queue. Can be called
+     * by the consumer only.
+     * @throws InterruptionException
+     */
+    T pop() {
+        T element;
+        while( !get( element ) ) {
+            MutexLock lock( _mutex );
+            while( true ) {
+                // Producer checks the flag after publishing an element, so
+                // either it sees the flag or the element is seen here.
+                _waiting.store( true, std::memory_order_relaxed );
+                std::atomic_thread_fence( std::memory_order_seq_cst );
+                if( _interrupt.load() || !isEmpty() ) {
+                    break;
+                }
+                _condition.wait( _mutex );
+            }
+            _waiting.store( false, std::memory_order_relaxed );
+            if( _interrupt.load() ) {
+                throw InterruptionException();
+            }
+        }
+        return element;
+    }
+
+    /**
+     * Interrupts the consumer waiting using pop method.
+     */
+    void interrupt() {
+        MutexLock lock( _mutex );
+        _interrupt.store( true );
+        _condition.broadcast();
+    }
+
+    /**
+     * Returns true if queue is empty.
+     */
+    bool isEmpty() const {
+        return _head.load( std::memory_order_acquire ) == _tail.load( std::memory_order_acquire );
+    }
+
+    /**
+     * Returns number of elements in the queue.
+     */
+    int getCount() const {
+        return static_cast<int>( _tail.load( std::memory_order_acquire ) - _head.load( std::memory_order_acquire ) );
+    }
+
+    /**
+     * Returns true if there is no space left in the queue.
+     */
+    bool isFull() const {
+        return _tail.load( std::memory_order_acquire ) - _head.load( std::memory_order_acquire ) > _mask;
+    }
+
+    /**
+     * Sets new signal handler.
+     * @param signalHandler Signal handler.
+     */
+    void setSignalHandler( QueueSignalHandler<T, SPSCQueue> *signalHandler ) {
+        this->_signalHandler = signalHandler;
+    }
+
+private:
+
+    template<typename U>
+    bool addElement( U &&element ) {
+        size_t tail = _tail.load( std::memory_order_relaxed );
+        if( tail - _head.load( std::memory_order_acquire ) > _mask ) {
+            return false;
+        }
+        _buffer[tail & _mask] = std::forward<U>( element );
+        _tail.store( tail + 1, std::memory_order_release );
+        wakeConsumer();
+        if( _signalHandler ) {
+            _signalHandler->handle( *this, SIGNAL_NEW_ELEMENT );
+        }
+        return true;
+    }
+
+    void wakeConsumer() {
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        if( _waiting.load( std::memory_order_relaxed ) ) {
+            // Consumer is woken up once, it rechecks the queue anyway.
+            MutexLock lock( _mutex );
+            _waiting.store( false, std::memory_order_relaxed );
+            _condition.signal();
+        }
+    }
+
+private:
+    std::vector<T> _buffer;
+    size_t _mask;
+    // Positions are kept on separate cache lines, so the producer
+    // and the consumer do not invalidate each other's lines.
+    char _padHead[64];
+    std::atomic<size_t> _head;
+    char _padTail[64];
+    std::atomic<size_t> _tail;
+    char _padEnd[64];
+    std::atomic<bool> _waiting;
+    std::atomic<bool> _interrupt;
+    Mutex _mutex;
+    Condition _condition;
+    QueueSignalHandler<T, SPSCQueue> *_signalHandler;
+};
+
 }
 
 #endif /* SRC_THREADS_H_ */
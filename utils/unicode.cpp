@@ -0,0 +1,479 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "unicode.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#define JSR_UNICODE_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 is chosen at runtime if the compiler is able to generate it
+// for a single function, otherwise only if it's enabled globally.
+#if defined(__AVX2__)
+#define JSR_UNICODE_AVX2
+#include <immintrin.h>
+#elif defined(JSR_UNICODE_SSE2) && defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define JSR_UNICODE_AVX2
+#define JSR_UNICODE_AVX2_DISPATCH
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+/*
+ * ASCII kernels. Every one of them handles only the leading run of
+ * ASCII characters and returns its length, so it stops at the first
+ * character which has to be converted by the scalar code. They are
+ * called for every ASCII run of a mixed text, so AVX2 ones clear upper
+ * halves of the registers before SSE2 code is used for the rest, otherwise
+ * every call pays for the AVX to SSE transition.
+ */
+
+// Gets length of the leading ASCII run of UTF-8 string.
+typedef size_t (*SkipUTF8Function)( const char *data, size_t size );
+// Gets length of the leading ASCII run of UTF-16 string.
+typedef size_t (*SkipUTF16Function)( const uint16_t *data, size_t size );
+// Converts the leading ASCII run of UTF-8 string into UTF-16.
+typedef size_t (*WidenFunction)( const char *data, size_t size, uint16_t *dest );
+// Converts the leading ASCII run of UTF-16 string into UTF-8.
+typedef size_t (*NarrowFunction)( const uint16_t *data, size_t size, char *dest );
+
+struct Kernels {
+    SkipUTF8Function skipUTF8;
+    SkipUTF16Function skipUTF16;
+    WidenFunction widen;
+    NarrowFunction narrow;
+};
+
+#ifdef JSR_UNICODE_SSE2
+
+inline unsigned int firstSetBit( uint32_t mask ) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward( &index, mask );
+    return index;
+#else
+    return __builtin_ctz( mask );
+#endif
+}
+
+#endif
+
+size_t skipUTF8Scalar( const char *data, size_t size ) {
+    size_t i = 0;
+    while( i < size && static_cast<unsigned char>( data[i] ) < 0x80 ) {
+        i++;
+    }
+    return i;
+}
+
+size_t skipUTF16Scalar( const uint16_t *data, size_t size ) {
+    size_t i = 0;
+    while( i < size && data[i] < 0x80 ) {
+        i++;
+    }
+    return i;
+}
+
+size_t widenScalar( const char *data, size_t size, uint16_t *dest ) {
+    size_t i = 0;
+    while( i < size && static_cast<unsigned char>( data[i] ) < 0x80 ) {
+        dest[i] = static_cast<uint16_t>( data[i] );
+        i++;
+    }
+    return i;
+}
+
+size_t narrowScalar( const uint16_t *data, size_t size, char *dest ) {
+    size_t i = 0;
+    while( i < size && data[i] < 0x80 ) {
+        dest[i] = static_cast<char>( data[i] );
+        i++;
+    }
+    return i;
+}
+
+#ifdef JSR_UNICODE_SSE2
+
+size_t skipUTF8SSE2( const char *data, size_t size ) {
+    size_t i = 0;
+    for( ; i + 16 <= size; i += 16 ) {
+        __m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>( data + i ) );
+        uint32_t mask = static_cast<uint32_t>( _mm_movemask_epi8( chunk ) );
+        if( mask ) {
+            return i + firstSetBit( mask );
+        }
+    }
+    return i + skipUTF8Scalar( data + i, size - i );
+}
+
+size_t skipUTF16SSE2( const uint16_t *data, size_t size ) {
+    const __m128i nonASCII = _mm_set1_epi16( static_cast<short>( 0xFF80 ) );
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for( ; i + 8 <= size; i += 8 ) {
+        __m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>( data + i ) );
+        __m128i ascii = _mm_cmpeq_epi16( _mm_and_si128( chunk, nonASCII ), zero );
+        uint32_t mask = static_cast<uint32_t>( _mm_movemask_epi8( ascii ) ) ^ 0xFFFF;
+        if( mask ) {
+            return i + firstSetBit( mask ) / 2;
+        }
+    }
+    return i + skipUTF16Scalar( data + i, size - i );
+}
+
+size_t widenSSE2( const char *data, size_t size, uint16_t *dest ) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for( ; i + 16 <= size; i += 16 ) {
+        __m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>( data + i ) );
+        if( _mm_movemask_epi8( chunk ) ) {
+            break;
+        }
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( dest + i ), _mm_unpacklo_epi8( chunk, zero ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( dest + i + 8 ), _mm_unpackhi_epi8( chunk, zero ) );
+    }
+    return i + widenScalar( data + i, size - i, dest + i );
+}
+
+size_t narrowSSE2( const uint16_t *data, size_t size, char *dest ) {
+    const __m128i nonASCII = _mm_set1_epi16( static_cast<short>( 0xFF80 ) );
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for( ; i + 16 <= size; i += 16 ) {
+        __m128i low = _mm_loadu_si128( reinterpret_cast<const __m128i*>( data + i ) );
+        __m128i high = _mm_loadu_si128( reinterpret_cast<const __m128i*>( data + i + 8 ) );
+        __m128i ascii = _mm_cmpeq_epi16( _mm_and_si128( _mm_or_si128( low, high ), nonASCII ), zero );
+        if( _mm_movemask_epi8( ascii ) != 0xFFFF ) {
+            break;
+        }
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( dest + i ), _mm_packus_epi16( low, high ) );
+    }
+    return i + narrowScalar( data + i, size - i, dest + i );
+}
+
+#endif
+
+#ifdef JSR_UNICODE_AVX2
+
+#ifdef JSR_UNICODE_AVX2_DISPATCH
+__attribute__((target("avx2")))
+#endif
+size_t skipUTF8AVX2( const char *data, size_t size ) {
+    size_t i = 0;
+    for( ; i + 32 <= size; i += 32 ) {
+        __m256i chunk = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( data + i ) );
+        uint32_t mask = static_cast<uint32_t>( _mm256_movemask_epi8( chunk ) );
+        if( mask ) {
+            return i + firstSetBit( mask );
+        }
+    }
+    _mm256_zeroupper();
+    return i + skipUTF8SSE2( data + i, size - i );
+}
+
+#ifdef JSR_UNICODE_AVX2_DISPATCH
+__attribute__((target("avx2")))
+#endif
+size_t skipUTF16AVX2( const uint16_t *data, size_t size ) {
+    const __m256i nonASCII = _mm256_set1_epi16( static_cast<short>( 0xFF80 ) );
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for( ; i + 16 <= size; i += 16 ) {
+        __m256i chunk = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( data + i ) );
+        __m256i ascii = _mm256_cmpeq_epi16( _mm256_and_si256( chunk, nonASCII ), zero );
+        uint32_t mask = ~static_cast<uint32_t>( _mm256_movemask_epi8( ascii ) );
+        if( mask ) {
+            return i + firstSetBit( mask ) / 2;
+        }
+    }
+    _mm256_zeroupper();
+    return i + skipUTF16SSE2( data + i, size - i );
+}
+
+#ifdef JSR_UNICODE_AVX2_DISPATCH
+__attribute__((target("avx2")))
+#endif
+size_t widenAVX2( const char *data, size_t size, uint16_t *dest ) {
+    size_t i = 0;
+    for( ; i + 32 <= size; i += 32 ) {
+        __m256i chunk = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( data + i ) );
+        if( _mm256_movemask_epi8( chunk ) ) {
+            break;
+        }
+        __m256i low = _mm256_cvtepu8_epi16( _mm256_castsi256_si128( chunk ) );
+        __m256i high = _mm256_cvtepu8_epi16( _mm256_extracti128_si256( chunk, 1 ) );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( dest + i ), low );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( dest + i + 16 ), high );
+    }
+    _mm256_zeroupper();
+    return i + widenSSE2( data + i, size - i, dest + i );
+}
+
+#ifdef JSR_UNICODE_AVX2_DISPATCH
+__attribute__((target("avx2")))
+#endif
+size_t narrowAVX2( const uint16_t *data, size_t size, char *dest ) {
+    const __m256i nonASCII = _mm256_set1_epi16( static_cast<short>( 0xFF80 ) );
+    size_t i = 0;
+    for( ; i + 32 <= size; i += 32 ) {
+        __m256i low = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( data + i ) );
+        __m256i high = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( data + i + 16 ) );
+        if( !_mm256_testz_si256( _mm256_or_si256( low, high ), nonASCII ) ) {
+            break;
+        }
+        // Packing works within 128 bit lanes, so quadwords have to be reordered.
+        __m256i packed = _mm256_permute4x64_epi64( _mm256_packus_epi16( low, high ), 0xD8 );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( dest + i ), packed );
+    }
+    _mm256_zeroupper();
+    return i + narrowSSE2( data + i, size - i, dest + i );
+}
+
+#endif
+
+const Kernels SCALAR_KERNELS = { skipUTF8Scalar, skipUTF16Scalar, widenScalar, narrowScalar };
+#ifdef JSR_UNICODE_SSE2
+const Kernels SSE2_KERNELS = { skipUTF8SSE2, skipUTF16SSE2, widenSSE2, narrowSSE2 };
+#endif
+#ifdef JSR_UNICODE_AVX2
+const Kernels AVX2_KERNELS = { skipUTF8AVX2, skipUTF16AVX2, widenAVX2, narrowAVX2 };
+
+bool isAVX2Supported() {
+#ifdef JSR_UNICODE_AVX2_DISPATCH
+    return __builtin_cpu_supports( "avx2" ) != 0;
+#else
+    return true;
+#endif
+}
+
+#endif
+
+Kernels selectKernels() {
+#ifdef JSR_UNICODE_AVX2
+    if( isAVX2Supported() ) {
+        return AVX2_KERNELS;
+    }
+#endif
+#ifdef JSR_UNICODE_SSE2
+    return SSE2_KERNELS;
+#else
+    return SCALAR_KERNELS;
+#endif
+}
+
+// Resolved once while the library is loaded, so it doesn't depend
+// on thread safe initialization of local statics. Tests can change it
+// using setUnicodeKernel().
+Kernels kernels = selectKernels();
+
+inline bool isHighSurrogate( uint16_t unit ) {
+    return unit >= 0xD800 && unit <= 0xDBFF;
+}
+
+inline bool isLowSurrogate( uint16_t unit ) {
+    return unit >= 0xDC00 && unit <= 0xDFFF;
+}
+
+}
+
+size_t Utils::getUTF8SequenceLength( const unsigned char *data, size_t size ) {
+    unsigned char c = data[0];
+    size_t length;
+    unsigned char min = 0x80, max = 0xBF;
+    if( c >= 0xC2 && c <= 0xDF ) {
+        length = 2;
+    } else if( c >= 0xE0 && c <= 0xEF ) {
+        length = 3;
+        if( c == 0xE0 ) {
+            min = 0xA0;
+        } else if( c == 0xED ) {
+            max = 0x9F;
+        }
+    } else if( c >= 0xF0 && c <= 0xF4 ) {
+        length = 4;
+        if( c == 0xF0 ) {
+            min = 0x90;
+        } else if( c == 0xF4 ) {
+            max = 0x8F;
+        }
+    } else {
+        return 0;
+    }
+    if( size < length || data[1] < min || data[1] > max ) {
+        return 0;
+    }
+    for( size_t i = 2; i < length; i++ ) {
+        if( data[i] < 0x80 || data[i] > 0xBF ) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+size_t Utils::getUTF16Length( const char *data, size_t size ) {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>( data );
+    size_t length = 0;
+    size_t i = 0;
+    while( i < size ) {
+        size_t ascii = kernels.skipUTF8( data + i, size - i );
+        i += ascii;
+        length += ascii;
+        // Multibyte characters usually come in runs, so they are
+        // handled here until the next ASCII character.
+        while( i < size && bytes[i] >= 0x80 ) {
+            size_t sequence = getUTF8SequenceLength( bytes + i, size - i );
+            if( sequence ) {
+                length += sequence == 4 ? 2 : 1;
+                i += sequence;
+            } else {
+                length++;
+                i++;
+            }
+        }
+    }
+    return length;
+}
+
+size_t Utils::convertUTF8ToUTF16( const char *data, size_t size, uint16_t *dest ) {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>( data );
+    uint16_t *out = dest;
+    size_t i = 0;
+    while( i < size ) {
+        size_t ascii = kernels.widen( data + i, size - i, out );
+        i += ascii;
+        out += ascii;
+        while( i < size && bytes[i] >= 0x80 ) {
+            const unsigned char *c = bytes + i;
+            switch( getUTF8SequenceLength( c, size - i ) ) {
+            case 2:
+                *out++ = static_cast<uint16_t>( ( ( c[0] & 0x1F ) << 6 ) | ( c[1] & 0x3F ) );
+                i += 2;
+                break;
+            case 3:
+                *out++ = static_cast<uint16_t>( ( ( c[0] & 0x0F ) << 12 ) | ( ( c[1] & 0x3F ) << 6 ) | ( c[2] & 0x3F ) );
+                i += 3;
+                break;
+            case 4: {
+                uint32_t code = ( ( c[0] & 0x07 ) << 18 ) | ( ( c[1] & 0x3F ) << 12 ) |
+                                ( ( c[2] & 0x3F ) << 6 ) | ( c[3] & 0x3F );
+                code -= 0x10000;
+                *out++ = static_cast<uint16_t>( 0xD800 | ( code >> 10 ) );
+                *out++ = static_cast<uint16_t>( 0xDC00 | ( code & 0x3FF ) );
+                i += 4;
+                break;
+            }
+            default:
+                *out++ = JSR_UNICODE_REPLACEMENT_CHAR;
+                i++;
+            }
+        }
+    }
+    return out - dest;
+}
+
+size_t Utils::getUTF8Length( const uint16_t *data, size_t size ) {
+    size_t length = 0;
+    size_t i = 0;
+    while( i < size ) {
+        size_t ascii = kernels.skipUTF16( data + i, size - i );
+        i += ascii;
+        length += ascii;
+        while( i < size && data[i] >= 0x80 ) {
+            uint16_t unit = data[i];
+            if( unit < 0x800 ) {
+                length += 2;
+            } else if( isHighSurrogate( unit ) && i + 1 < size && isLowSurrogate( data[i + 1] ) ) {
+                length += 4;
+                i++;
+            } else if( isHighSurrogate( unit ) || isLowSurrogate( unit ) ) {
+                length++;
+            } else {
+                length += 3;
+            }
+            i++;
+        }
+    }
+    return length;
+}
+
+size_t Utils::convertUTF16ToUTF8( const uint16_t *data, size_t size, char *dest ) {
+    char *out = dest;
+    size_t i = 0;
+    while( i < size ) {
+        size_t ascii = kernels.narrow( data + i, size - i, out );
+        i += ascii;
+        out += ascii;
+        while( i < size && data[i] >= 0x80 ) {
+            uint32_t code = data[i];
+            if( code < 0x800 ) {
+                *out++ = static_cast<char>( 0xC0 | ( code >> 6 ) );
+                *out++ = static_cast<char>( 0x80 | ( code & 0x3F ) );
+            } else if( isHighSurrogate( data[i] ) && i + 1 < size && isLowSurrogate( data[i + 1] ) ) {
+                code = 0x10000 + ( ( code - 0xD800 ) << 10 ) + ( data[i + 1] - 0xDC00 );
+                *out++ = static_cast<char>( 0xF0 | ( code >> 18 ) );
+                *out++ = static_cast<char>( 0x80 | ( ( code >> 12 ) & 0x3F ) );
+                *out++ = static_cast<char>( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+                *out++ = static_cast<char>( 0x80 | ( code & 0x3F ) );
+                i++;
+            } else if( isHighSurrogate( data[i] ) || isLowSurrogate( data[i] ) ) {
+                *out++ = JSR_UNICODE_REPLACEMENT_CHAR;
+            } else {
+                *out++ = static_cast<char>( 0xE0 | ( code >> 12 ) );
+                *out++ = static_cast<char>( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+                *out++ = static_cast<char>( 0x80 | ( code & 0x3F ) );
+            }
+            i++;
+        }
+    }
+    return out - dest;
+}
+
+bool Utils::setUnicodeKernel( UnicodeKernel kernel ) {
+    switch( kernel ) {
+    case UNICODE_KERNEL_SCALAR:
+        kernels = SCALAR_KERNELS;
+        return true;
+#ifdef JSR_UNICODE_SSE2
+    case UNICODE_KERNEL_SSE2:
+        kernels = SSE2_KERNELS;
+        return true;
+#endif
+#ifdef JSR_UNICODE_AVX2
+    case UNICODE_KERNEL_AVX2:
+        if( !isAVX2Supported() ) {
+            return false;
+        }
+        kernels = AVX2_KERNELS;
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+bool Utils::isNativeUTF16LE() {
+    const uint16_t unit = 1;
+    return *reinterpret_cast<const unsigned char*>( &unit ) == 1;
+}
@@ -0,0 +1,94 @@
+/*
+ * A Remote Debugger for SpiderMonkey Java Script engine.
+ * Copyright (C) 2014-2015 Sławomir Wojtasiak
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SRC_UNICODE_H_
+#define SRC_UNICODE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Conversions between UTF-8 and UTF-16 in the native byte order. Every byte
+ * which is not a part of a well-formed UTF-8 sequence and every unpaired
+ * surrogate is replaced by JSR_UNICODE_REPLACEMENT_CHAR, exactly as iconv
+ * based conversions have always done it. Output length is computed by a
+ * separate pass, so strings can be allocated once with the exact size. Runs
+ * of ASCII characters are converted using SSE2 or AVX2 if the CPU supports it.
+ */
+
+#define JSR_UNICODE_REPLACEMENT_CHAR    '?'
+
+namespace Utils {
+
+/**
+ * Gets length of the well-formed UTF-8 sequence (RFC 3629) or 0. Overlong
+ * forms, surrogates and code points above U+10FFFF are rejected. ASCII
+ * characters are not multibyte sequences, so 0 is returned for them too.
+ */
+size_t getUTF8SequenceLength( const unsigned char *data, size_t size );
+
+/**
+ * Gets number of UTF-16 code units the UTF-8 string is converted into.
+ */
+size_t getUTF16Length( const char *data, size_t size );
+
+/**
+ * Converts UTF-8 string into UTF-16 one.
+ * @param dest Buffer for exactly getUTF16Length() code units.
+ * @return Number of code units written.
+ */
+size_t convertUTF8ToUTF16( const char *data, size_t size, uint16_t *dest );
+
+/**
+ * Gets number of bytes the UTF-16 string is converted into.
+ */
+size_t getUTF8Length( const uint16_t *data, size_t size );
+
+/**
+ * Converts UTF-16 string into UTF-8 one.
+ * @param dest Buffer for exactly getUTF8Length() bytes.
+ * @return Number of bytes written.
+ */
+size_t convertUTF16ToUTF8( const uint16_t *data, size_t size, char *dest );
+
+/**
+ * Kernels which convert runs of ASCII characters.
+ */
+enum UnicodeKernel {
+    UNICODE_KERNEL_SCALAR,
+    UNICODE_KERNEL_SSE2,
+    UNICODE_KERNEL_AVX2
+};
+
+/**
+ * Forces kernels used by all the conversions, so every one of them can be
+ * tested on the same machine. It's not thread safe, so it's meant for tests
+ * and benchmarks only. The best kernels are selected by default.
+ * @return False if kernels are not supported by the CPU or the compiler.
+ */
+bool setUnicodeKernel( UnicodeKernel kernel );
+
+/**
+ * Tells whether UTF-16 code units are stored in the little-endian order.
+ */
+bool isNativeUTF16LE();
+
+}
+
+#endif /* SRC_UNICODE_H_ */